@@ -0,0 +1,26 @@
+/* Key of the translation table, shared by x_helix.c, which looks atoms up by it, and make_translation.c, */
+/* which sorts translation.h by it, so that the two cannot disagree */
+
+#ifndef ATOM_KEY_H
+#define ATOM_KEY_H
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to intern a residue name and atom name as one number */
+static inline unsigned long long atom_key(const char *residue, const char *atom)
+{
+   /* Variables */
+
+   unsigned long long key=0;
+   int k;
+
+
+   /* the names compare as strings, so nothing after the end of a name counts */
+
+   for(k=0;(k<3) && residue[k];k++) key|=(unsigned long long)(unsigned char)residue[k]<<(8*(6-k));
+   for(k=0;(k<4) && atom[k];k++) key|=(unsigned long long)(unsigned char)atom[k]<<(8*(3-k));
+
+   return key;
+}
+
+#endif
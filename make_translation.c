@@ -0,0 +1,132 @@
+/* Builds translation.h, the compiled-in table of hydrogen bond donor and electrostatic info, */
+/* from translation.txt: make-translation translation.txt > translation.h */
+/* Lines are residue name (columns 1-3), atom name (5-8), H-bond donor (10) and charge class (12), */
+/* the table is sorted by atom_key() and, as when the file was read at run time, the last line wins */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "atom_key.h"
+
+#define LINLEN 128
+#define ENTRIES_START 4096
+
+struct ENTRY
+{
+   unsigned long long key;
+   int line_number;
+   int hbond_donor;
+   int electrostatic;
+};
+
+/* Prototypes */
+
+int compare_entries(const void *a, const void *b);
+
+/* ------------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+   /* Variables */
+
+   FILE *fp;
+   char line[LINLEN];
+   char residue[4];
+   char atom[5];
+   char hbond[2];
+   char electro[2];
+   struct ENTRY *entry;
+   int entries_total=0;
+   int entries_max=ENTRIES_START;
+   int i,k,n=0;
+
+
+   if(argc!=2)
+   {
+      printf("Usage: make-translation translation.txt > translation.h\n");
+      exit(1);
+   }
+
+   if((fp=fopen(argv[1],"r")) == NULL)
+   {
+      printf("\n\nError opening %s\n",argv[1]);
+      exit(1);
+   }
+
+   entry=(struct ENTRY *) malloc(entries_max*sizeof(struct ENTRY));
+
+   while(fgets(line,LINLEN,fp)!=NULL)
+   {
+      n++;
+
+      k=strlen(line);
+      while((k>0) && ((line[k-1]=='\n') || (line[k-1]=='\r'))) line[--k]='\0';
+
+      if(k<12) continue;
+
+      for(i=0;i<3;i++) residue[i]=line[i];
+      residue[3]='\0';
+
+      for(i=0;i<4;i++) atom[i]=line[4+i];
+      atom[4]='\0';
+
+      hbond[0]=line[9];
+      hbond[1]='\0';
+
+      electro[0]=line[11];
+      electro[1]='\0';
+
+      if(entries_total==entries_max)
+      {
+         entries_max*=2;
+         entry=(struct ENTRY *) realloc(entry,entries_max*sizeof(struct ENTRY));
+      }
+
+      entry[entries_total].key=atom_key(residue,atom);
+      entry[entries_total].line_number=n;
+      entry[entries_total].hbond_donor=atoi(hbond);
+      entry[entries_total].electrostatic=atoi(electro);
+      entries_total++;
+   }
+
+   fclose(fp);
+
+   qsort(entry,entries_total,sizeof(struct ENTRY),compare_entries);
+
+   /* of the lines with the same key only the last one is kept */
+
+   for(i=0,n=0;i<entries_total;i++)
+   {
+      if((n>0) && (entry[n-1].key==entry[i].key)) n--;
+      entry[n++]=entry[i];
+   }
+
+   printf("/* Generated from %s by make-translation, do not edit */\n\n",argv[1]);
+   printf("#define TRANSLATIONS_TOTAL %d\n\n",n);
+   printf("struct TRANSLATION translation[TRANSLATIONS_TOTAL]=\n{\n");
+
+   for(i=0;i<n;i++)
+   {
+      printf("   {0x%014llxULL, %d, %d}%s\n",entry[i].key,entry[i].hbond_donor,entry[i].electrostatic,(i<n-1) ? "," : "");
+   }
+
+   printf("};\n");
+
+   free(entry);
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to order table entries by key, and by line within a key */
+int compare_entries(const void *a, const void *b)
+{
+   const struct ENTRY *entry1=(const struct ENTRY *)a;
+   const struct ENTRY *entry2=(const struct ENTRY *)b;
+
+   if(entry1->key<entry2->key) return -1;
+   if(entry1->key>entry2->key) return 1;
+
+   return entry1->line_number-entry2->line_number;
+}
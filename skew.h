@@ -117,7 +117,7 @@ VECTOR* vnorm(VECTOR *a)
 
    if ((d = recip_vmag(a)) > MAXRECIPLEN)
    {
-      printf ("vector at 0x%x: %g %g %g?",(int)a, a->dx, a->dy, a->dz);
+      printf ("vector at 0x%x: %g %g %g?\n",(int)a, a->dx, a->dy, a->dz);
 
       a->dx = a->dy = a->dz = 0.0;
 
@@ -179,7 +179,7 @@ POINT* intersect_line_plane(POINT *p,POINT *a, POINT *b,PLANE *M)
 /* <point,direction> line form, return the intersection point from an intersected line and the plane in question */
 POINT* intersect_dline_plane(POINT *p,POINT *a, VECTOR *adir,PLANE *M)               
 {
-   static POINT B, *b = &B;
+   POINT B, *b = &B;
 
    pplusv (b, a, adir);
    return (intersect_line_plane (p, a, b, M));
@@ -199,8 +199,8 @@ PLANE* plane_from_two_vectors_and_point(PLANE *M,VECTOR *u,VECTOR *v,POINT *p)
 /* Returns: 0 if parallel; 1 if lines intersect (coincident); 2 if lines are skew (as expected) */
 int line_line_closest_points3d(POINT *pA, POINT *pB, POINT *a, VECTOR *adir, POINT *b, VECTOR *bdir)
 {
-   static VECTOR Cdir, *cdir = &Cdir;
-   static PLANE Ac, *ac = &Ac, Bc, *bc = &Bc;
+   VECTOR Cdir, *cdir = &Cdir;
+   PLANE Ac, *ac = &Ac, Bc, *bc = &Bc;
 
    /* connecting line is perpendicular to both */
    vcross (cdir, adir, bdir);
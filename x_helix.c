@@ -81,78 +81,596 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <strings.h>
+#include <limits.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(SCALAR_KERNEL)
+#define X86_KERNELS                   /* AVX2 and AVX-512 distance kernels and an AVX2 hydrogen bond kernel, chosen at run time */
+#include <immintrin.h>
+#endif
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>                     /* gzip inputs, as on the PDB mirrors, and gzip outputs */
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>                     /* zstd outputs, built with -DHAVE_ZSTD ... -lzstd */
+#endif
 #include "skew.h"
+#include "xhelix.h"
+#include "atom_key.h"                 /* key of the translation table, as make_translation.c sorts it */
 
 // dmf 6.27.17
 // #define DEBUG
 
 // dmf 6.27.17 increased DLINLEN from 150
 #define DLINLEN 160
-#define MAXHELICES 1000               /* max helices in protein - set between 500-1000 */
-#define MAXRESIDUES 200               /* maximum residues in a helix - set between 100-200 */
 #define LINLEN 128
 #define CLINLEN 450
-#define MAXHELIXATOMS (MAXRESIDUES*10)
+#define HELICES_START 64              /* helix records first allocated per protein, grown as needed */
+#define SLOTS_START 1024              /* residue slots first allocated per protein, grown as needed */
+#define ATOMS_START 4096              /* atoms first allocated per protein, grown as needed */
+#define ARENA_BLOCK (1<<22)           /* smallest block taken by the per-protein arena (4 MB) */
+#define ARENA_ALIGN 16                /* alignment of every arena allocation */
+#define HUGE_PAGE_SIZE (1<<21)        /* arena blocks are rounded up to this when built with -DHUGE_PAGES */
 #define SQR(X) ((X)*(X))
 #define TOLERANCE 0.6                 /* to be used in packing threshold calculation */
 #define TOLERANCE2 (106.0/100.0)      /* to be used in determining atom-atom bonds   */
 #define MIN_CONTACT_RESIDUES 3        /* minimum contacting residues per helix that constitute packing */
+#define CONTACT_CUTOFF 5.0            /* largest atom-atom distance that can count as a contact (electrostatic limit) */
+#define GRID_CELL (CONTACT_CUTOFF+0.01)  /* cell grid edge, a little over the cutoff to absorb rounding */
+#define MAXGRIDCELLS (1<<22)          /* cell grid is coarsened beyond this many cells */
+#define NEIGHBOUR_DISTANCE 10.0       /* helices are neighbours if they have C-alphas this close */
+#define NEIGHBOUR_MARGIN 0.01         /* added to capsule bounds to absorb rounding */
+#define HELIXNODE_SIZE 4              /* maximum helices in a leaf of the capsule hierarchy */
+#define ELEMENT_OTHER 0               /* element codes of the atom store, they select the atomic radii */
+#define ELEMENT_C 1
+#define ELEMENT_O 2
+#define ELEMENT_N 3
+#define ELEMENT_S 4
+#define CLASS_O 1                     /* atom class bits of the atom store, set for O and N atom names */
+#define CLASS_N 2
+#define HBOND_KEYS 12                 /* atom class (4) by H-bond donor state (none, 1, other) */
+#define TILE_ATOMS 256                /* helix one atoms scanned for contacts by one task, so large helix pairs are shared out */
+#define ENTRIES_START 256             /* entries of the input list first allocated, grown as needed */
+#define MESSAGE_LENGTH 256            /* longest error message kept for the caller */
+#define OUTPUT_BUFFER (1<<18)         /* bytes buffered for each output file before it is written out */
+#define OUTPUT_NAMES 8                /* output files that can be chosen with -o, in XHELIX_OUTPUT_ bit order */
+#define OUTPUT_NAME_LENGTH 40         /* longest output file name, <pdb id>_<name> and the .gz or .zst of a compressed one */
+#define DEFLATE_CHUNK (1<<16)         /* bytes of an output taken at a time by the thread compressing it */
+#define TEXT_START (1<<16)            /* bytes first allocated for an input that cannot be mapped, grown as needed */
+#define DSSP_COLUMNS 17               /* DSSP columns looked at, longer lines are read in place */
+#define DSSP_CA_COLUMNS 136           /* DSSP columns looked at for the C-alpha co-ordinates, which end in column 136 */
+#define PDB_COLUMNS 55                /* PDB columns looked at (up to the one after Z), longer lines are read in place */
+#define EXACT_DIGITS 15               /* most digits of a number decoded without strtod(), exact in a double */
+#define INFLATE_CHUNK (1<<16)         /* bytes inflated from a gzip input before the readers are told */
+#define INFLATE_FEED (1<<30)          /* most compressed bytes given to zlib at once, it counts in 32 bits */
+#define DEFLATE_RATIO 1032            /* most that deflate can expand its input by */
+#define INFLATE_MOST ((size_t)1<<((sizeof(size_t)>4) ? 40 : 30))   /* most address space set aside for an inflated input */
+#define CIF_LINLEN (1<<16)            /* longest mmCIF line taken whole, longer ones are split as fgets() would */
+#define CIF_GROUP 0                   /* atom_site fields of an mmCIF file taken by the reader, see cif_field_name */
+#define CIF_ID 1
+#define CIF_TYPE 2
+#define CIF_LABEL_ATOM 3
+#define CIF_AUTH_ATOM 4
+#define CIF_LABEL_COMP 5
+#define CIF_AUTH_COMP 6
+#define CIF_LABEL_ASYM 7
+#define CIF_AUTH_ASYM 8
+#define CIF_LABEL_SEQ 9
+#define CIF_AUTH_SEQ 10
+#define CIF_INS_CODE 11
+#define CIF_X 12
+#define CIF_Y 13
+#define CIF_Z 14
+#define CIF_MODEL 15
+#define CIF_FIELDS 16
+#define BINARY_MAGIC "XHB1"           /* start of a binary structure file, see write_binary() */
+#define BINARY_MAGIC_SIZE 4
+#define BINARY_ATOMS 0                /* counts in the header of a binary structure file */
+#define BINARY_NAMES 1
+#define BINARY_RESNAMES 2
+#define BINARY_COUNTS 3
+#define BINARY_NAME 0                 /* columns of a binary structure file, their sizes follow the counts */
+#define BINARY_SERIAL 1
+#define BINARY_RESIDUE 2
+#define BINARY_X 3
+#define BINARY_Y 4
+#define BINARY_Z 5
+#define BINARY_STREAMS 6
+#define BINARY_HEADER_SIZE (BINARY_MAGIC_SIZE+4*(BINARY_COUNTS+BINARY_STREAMS))
+#define BINARY_LARGEST 1e12           /* largest residue number or co-ordinate written, its thousandths are exact in a double */
+#define BINARY_NAMES_START 64         /* names first allocated in a name table, grown as needed */
+#define BYTES_START 4096              /* bytes first allocated for a column, grown as needed */
+#define RESULTS_MAGIC "XHR1"          /* start of a result store, see write_group() */
+#define RESULTS_MAGIC_SIZE 4
+#define RESULTS_HEADER_SIZE 8         /* magic and the most rows in a row group of a table */
+#define RESULTS_GROUP_ROWS 65536      /* rows of a table gathered before they are written out as a row group */
+#define RESULTS_GROUP_HEADER 16       /* table, rows, columns and bytes of a row group */
+#define RESULTS_TAIL_SIZE (RESULTS_GROUP_HEADER+8)  /* last group of a result store, giving where its index starts */
+#define KEYS_START 4096               /* index keys first allocated for a result store, grown as needed */
+#define RESULTS_ALIGN 8               /* columns are padded to this, so numbers can be read in place */
+#define COLUMN_TEXT 0                 /* types of the columns of a result store */
+#define COLUMN_INT 1                  /* 4 bytes, lowest first */
+#define COLUMN_DOUBLE 2               /* 8 bytes of IEEE double, lowest first */
+#define HELIX_COLUMNS 6               /* columns of the helix and pair tables and the index of a result store */
+#define PAIR_COLUMNS 14
+#define KEY_COLUMNS 5
+#define BACKBONE_N 1                  /* backbone atoms found for a residue by the helix assigner */
+#define BACKBONE_CA 2
+#define BACKBONE_C 4
+#define BACKBONE_O 8
+#define BACKBONE_ALL 15
+#define PEPTIDE_BOND_MAX 2.5          /* longest C-N peptide bond before DSSP sees a break in the chain */
+#define HBOND_CA_DISTANCE 9.0         /* C-alphas further apart than this have no DSSP hydrogen bond */
+#define HBOND_COUPLING -27.888        /* DSSP electrostatic energy constant, -332*0.42*0.2 kcal/mol */
+#define HBOND_DISTANCE_MIN 0.5        /* atoms closer than this give the lowest hydrogen bond energy */
+#define HBOND_ENERGY_MIN -9.9         /* lowest DSSP hydrogen bond energy */
+#define HBOND_ENERGY_MAX -0.5         /* highest energy that DSSP counts as a hydrogen bond */
+#define BRIDGE_NONE 0                 /* beta bridges between two residues */
+#define BRIDGE_PARALLEL 1
+#define BRIDGE_ANTIPARALLEL 2
+#define TURN_START 1                  /* helix flags of a residue in the n-turns of DSSP */
+#define TURN_MIDDLE 2
+#define TURN_END 4
+#define IS_SPACE(C) (((C)==' ') || (((C)>='\t') && ((C)<='\r')))   /* isspace() in the C locale */
 #define OBPDBDIR "/usr3/database/pdbobso/"
 
 /* Global Variables */
 
-// dmf 6.27.17
-int new_open = 1;
+/* Output filenames and carried-over state of the entry being analysed, one per entry so that */
+/* entries can be analysed side by side */
+struct ENTRYSTATE
+{
+   // dmf 7.29.17
+   char output_helices[OUTPUT_NAME_LENGTH];
+   char output_packing[OUTPUT_NAME_LENGTH];
+   char output_shape[OUTPUT_NAME_LENGTH];
+   char output_axis[OUTPUT_NAME_LENGTH];
+   char output_geom[OUTPUT_NAME_LENGTH];
+   char output_contact[OUTPUT_NAME_LENGTH];
+   char pymol_axis[OUTPUT_NAME_LENGTH];
+   char pymol_cgo[OUTPUT_NAME_LENGTH];
+
+   /* helix axial segments of the last packed pair, kept for pairs whose contact zone leaves them unset */
+   LINESEGMENT Alimits;
+   LINESEGMENT Blimits;
+
+   int outputs;               /* XHELIX_OUTPUT_ bits of the files written */
+   int compression;           /* XHELIX_COMPRESS_ type of the files written */
+   int verbose;               /* XHELIX_VERBOSE_ progress reports on stdout, 0 for none */
+   FILE *fpo_helices;         /* output files, each opened once and open for the whole entry (NULL if not written) */
+   FILE *fpo_packing;
+   FILE *fpo_shape;
+   FILE *fpo_axis;
+   FILE *fpo_geom;
+   FILE *fpo_contact;
+   FILE *fpo_pyaxis;
+   FILE *fpo_cgo;
+   struct DEFLATER *deflater; /* threads compressing the output files, NULL if they are not compressed */
+   char message[MESSAGE_LENGTH];   /* what went wrong, if the analysis failed */
+};
 
-// dmf 7.29.17
-char output_helices[30];
-char output_packing[30];
-char output_shape[30];
-char output_axis[30];
-char output_geom[30];
-char output_contact[30];
-char pymol_axis[30];
+/* Analysis context of the library: its settings, the arena of the entry being analysed and the results */
+/* of the last one. Contexts share nothing, so entries can be analysed by a context per thread */
+struct XHELIX
+{
+   struct ARENA *arena;
+   int threads_total;         /* threads sharing the helix pairs of an entry */
+   struct ARENA **thread_arena;    /* one per thread, the first is arena; kept from entry to entry and reset */
+   int outputs;
+   int compression;
+   int verbose;
+   int ca_only;               /* set to take the C-alphas from the DSSP file and read no structure */
+   struct XHELIX_HELIX *helix;     /* results of the last entry, from the arena */
+   int helices_total;
+   struct XHELIX_PAIR *pair;
+   int pairs_total;
+   char message[MESSAGE_LENGTH];
+};
+
+/* A helix, and a packed helix pair, as kept in a result store */
+struct HELIXROW
+{
+   char pdb[4];
+   char chain;
+   char geometry;
+   int helix_no;
+   int residues_total;
+   double max_bending_angle;
+};
+
+struct PAIRROW
+{
+   char pdb[4];
+   char chain1;
+   char chain2;
+   int helix1;                /* helix numbers from the DSSP file, as in helix_packing_pair.txt */
+   int helix2;
+   int h1_residues;
+   int h2_residues;
+   double angle1;
+   double angle2;
+   double distance;
+   int covalent;
+   int electrostatic;
+   int hbond;
+   int vdw;
+};
+
+/* A key of the index of a result store: a helix, and each of the two helices of a packed pair, lead to their row */
+struct KEYROW
+{
+   char pdb[4];
+   char chain;
+   char table;                /* H for the helix table, P for the pair table */
+   int helix_no;
+   int row;                   /* row of the table, counted over all its row groups */
+};
+
+/* A column of a result store, taken from the same place in each row */
+struct RESULTCOLUMN
+{
+   size_t offset;
+   int width;
+   int type;
+};
+
+/* Columns of the helix and pair tables of a result store, in the order written */
+const struct RESULTCOLUMN helix_column[HELIX_COLUMNS]=
+{
+   {offsetof(struct HELIXROW, pdb), 4, COLUMN_TEXT},
+   {offsetof(struct HELIXROW, chain), 1, COLUMN_TEXT},
+   {offsetof(struct HELIXROW, helix_no), 4, COLUMN_INT},
+   {offsetof(struct HELIXROW, residues_total), 4, COLUMN_INT},
+   {offsetof(struct HELIXROW, geometry), 1, COLUMN_TEXT},
+   {offsetof(struct HELIXROW, max_bending_angle), 8, COLUMN_DOUBLE}
+};
+
+const struct RESULTCOLUMN pair_column[PAIR_COLUMNS]=
+{
+   {offsetof(struct PAIRROW, pdb), 4, COLUMN_TEXT},
+   {offsetof(struct PAIRROW, chain1), 1, COLUMN_TEXT},
+   {offsetof(struct PAIRROW, chain2), 1, COLUMN_TEXT},
+   {offsetof(struct PAIRROW, helix1), 4, COLUMN_INT},
+   {offsetof(struct PAIRROW, helix2), 4, COLUMN_INT},
+   {offsetof(struct PAIRROW, h1_residues), 4, COLUMN_INT},
+   {offsetof(struct PAIRROW, h2_residues), 4, COLUMN_INT},
+   {offsetof(struct PAIRROW, angle1), 8, COLUMN_DOUBLE},
+   {offsetof(struct PAIRROW, angle2), 8, COLUMN_DOUBLE},
+   {offsetof(struct PAIRROW, distance), 8, COLUMN_DOUBLE},
+   {offsetof(struct PAIRROW, covalent), 4, COLUMN_INT},
+   {offsetof(struct PAIRROW, electrostatic), 4, COLUMN_INT},
+   {offsetof(struct PAIRROW, hbond), 4, COLUMN_INT},
+   {offsetof(struct PAIRROW, vdw), 4, COLUMN_INT}
+};
+
+const struct RESULTCOLUMN key_column[KEY_COLUMNS]=
+{
+   {offsetof(struct KEYROW, pdb), 4, COLUMN_TEXT},
+   {offsetof(struct KEYROW, chain), 1, COLUMN_TEXT},
+   {offsetof(struct KEYROW, table), 1, COLUMN_TEXT},
+   {offsetof(struct KEYROW, helix_no), 4, COLUMN_INT},
+   {offsetof(struct KEYROW, row), 4, COLUMN_INT}
+};
+
+/* Result store written by a batch run. The rows of the entries are taken in list order, whichever thread */
+/* analysed them, and written out a row group at a time */
+struct RESULTSTORE
+{
+   FILE *fp;
+   char *filename;
+   pthread_mutex_t lock;
+   struct HELIXROW *helix;    /* rows of the row groups being gathered */
+   int helices_total;
+   struct PAIRROW *pair;
+   int pairs_total;
+   int next_entry;            /* next entry of the list to be stored, those analysed after it wait for it */
+   unsigned char *group;      /* part of a column as written */
+   int helix_rows;            /* rows of each table so far */
+   int pair_rows;
+   struct KEYROW *key;        /* index of all the rows so far, sorted when the store is closed */
+   int keys_total;
+   int keys_max;
+   unsigned long long offset; /* bytes written so far */
+   int failed;                /* set once the store could not be written or its index grown, nothing more is stored */
+   char message[MESSAGE_LENGTH];   /* what went wrong, reported when the store is closed */
+};
+
+/* Input list shared by the threads of a batch run, each thread takes the next entry in turn */
+struct BATCHENTRY
+{
+   char pdb_id[5];
+   int order;                 /* position in the input list */
+   int analysed;              /* set once the rows of the entry are ready for the result store */
+   struct HELIXROW *helix;
+   int helices_total;
+   struct PAIRROW *pair;
+   int pairs_total;
+};
+
+struct BATCH
+{
+   struct BATCHENTRY *entry;
+   int entries_total;
+   int entries_max;
+   int next_entry;            /* next entry to be taken by a thread */
+   int pair_threads;          /* threads sharing the helix pairs of each entry */
+   int entry_threads;         /* threads taking entries from the list, whose reports on stdout then come in turn */
+   char *pdb_dir;
+   char *dssp_dir;
+   int binary;                /* set to write binary structure files instead of analysing the entries */
+   int ca_only;               /* set to analyse the entries from their DSSP files alone */
+   int outputs;               /* XHELIX_OUTPUT_ bits of the files written for each entry */
+   int compression;           /* XHELIX_COMPRESS_ type of the files written */
+   struct RESULTSTORE *store; /* result store of the run, NULL if none */
+   int failed;                /* set once an entry has failed, no more entries are then taken */
+};
+
+/* A DSSP or PDB input held in memory whole, mapped from its file where possible */
+struct TEXTINPUT
+{
+   const char *text;
+   size_t size;
+   size_t next;               /* offset of the next record */
+   int end;                   /* set once a record has run into the end of the text, as feof() */
+   void *map;                 /* mapping of the file, NULL if the text was read or given */
+   size_t map_size;
+   char *copy;                /* text read from a stream that could not be mapped */
+   struct INFLATER *inflater; /* background inflation of a gzip input, NULL for plain text */
+};
+
+/* A gzip input being inflated by a thread of its own into a region of memory set aside for it. The readers */
+/* take the text as far as produced, and wait for more under lock */
+struct INFLATER
+{
+   pthread_t thread;
+   pthread_mutex_t lock;
+   pthread_cond_t more;
+   int running;               /* set if the thread was started, else the text was inflated whole at the start */
+   size_t produced;           /* bytes of text inflated so far */
+   int done;
+   int failed;                /* the gzip data were truncated or corrupt */
+   int stop;                  /* set to end the thread early */
+   unsigned char *region;
+   size_t reserved;
+   const unsigned char *compressed;
+   size_t compressed_size;
+};
+
+/* An output file compressed by a thread of its own. The entry writes the output into a pipe as it would into */
+/* the file, and the thread compresses what comes out of the pipe into the file */
+struct DEFLATER
+{
+   pthread_t thread;
+   int source;                /* read end of the pipe */
+   FILE *fp;                  /* the compressed file */
+   int compression;
+   int failed;                /* the file could not be compressed or written whole */
+#ifdef HAVE_ZLIB
+   z_stream gzip;
+#endif
+#ifdef HAVE_ZSTD
+   ZSTD_CCtx *zstd;
+#endif
+   unsigned char in[DEFLATE_CHUNK];
+   unsigned char out[DEFLATE_CHUNK];
+   struct DEFLATER *next;     /* next compressed output of the entry */
+};
+
+/* Current line of a reader. Lines that have all the columns looked at are read where they are in the input; */
+/* shorter ones are copied into buffer over what is left of the lines before, as fgets() would have */
+struct LINEVIEW
+{
+   const char *line;
+   int columns;               /* columns looked at by the reader */
+   const char *pending;       /* last line read in place, to be brought into the buffer under a short line */
+   int zero_column;           /* column of the pending line that the reader has set to '0', -1 for none */
+   char buffer[DLINLEN];
+};
+
+/* Tokens of an mmCIF input, taken from its current line */
+struct CIFREADER
+{
+   struct TEXTINPUT *input;
+   const char *line;
+   int length;                /* length of the line without its newline */
+   int next;                  /* column of the next token */
+   const char *token;         /* token taken but not yet used */
+   int token_length;
+   int token_quoted;
+   int *column_field;         /* CIF_ field of each column of the atom_site loop, -1 for none */
+   int columns_total;
+   int first_model;
+};
+
+/* Fields of an atom_site row, by CIF_ field, NULL for a column that the loop does not have */
+struct CIFROW
+{
+   const char *value[CIF_FIELDS];
+   int length[CIF_FIELDS];
+   int quoted[CIF_FIELDS];
+};
+
+/* A column of a binary structure file being written */
+struct BYTES
+{
+   unsigned char *data;
+   size_t size;
+   size_t max;
+   struct ARENA *arena;
+};
+
+/* The columns of a binary structure file being written, and the values that the next are written against */
+struct BINARYWRITER
+{
+   struct ARENA *arena;
+   struct BYTES stream[BINARY_STREAMS];
+   char *name;                /* table of 4 character atom names */
+   int names_total;
+   int names_max;
+   char *resname;             /* table of 3 character residue names */
+   int resnames_total;
+   int resnames_max;
+   int atoms_total;
+   int run_atoms;             /* atoms of the residue run being built */
+   int run_resname;
+   char run_chain;
+   char run_sub_type;
+   long long run_seq;
+   long long seq;             /* residue number of the last run written */
+   long long serial;
+   long long coordinate[3];   /* in thousandths */
+};
+
+/* A binary structure input being decoded, an atom at a time from all its columns */
+struct BINARYREADER
+{
+   const unsigned char *next[BINARY_STREAMS];
+   const unsigned char *end[BINARY_STREAMS];
+   const char *names;
+   const char *resnames;
+   unsigned long long atoms_total;
+   unsigned long long names_total;
+   unsigned long long resnames_total;
+   unsigned long long atoms_read;
+   unsigned long long run_atoms;  /* atoms left in the residue run */
+   long long serial;
+   long long seq;
+   long long coordinate[3];
+   char resname[4];
+   char chain;
+   char res_sub_type;
+};
+
+/* An atom of a structure input as the readers take it, the names laid out as in a PDB file */
+struct ATOMSITE
+{
+   int serial;
+   char atom_name[5];
+   char resname[4];
+   char chain;                /* '0' for none */
+   double seq;                /* residue number, without the insertion code */
+   char res_sub_type;         /* insertion code */
+   double x;
+   double y;
+   double z;
+};
+
+/* Progress of a reader through the DSSP helices, as the atoms of the structure file come in order */
+struct HELIXWALK
+{
+   int i;                     /* helix */
+   int j;                     /* residue of the helix */
+   int m;                     /* atoms of the helix so far */
+   int n;                     /* atoms of all helices so far */
+   float last_residue_in_helix;
+};
+
+/* powers of ten that scale the decoded decimals, all exact */
+double powers_of_ten[EXACT_DIGITS+1]={1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+
+/* names of the atom_site items taken from an mmCIF file, by CIF_ field */
+const char *cif_field_name[CIF_FIELDS]={"group_PDB", "id", "type_symbol", "label_atom_id", "auth_atom_id", "label_comp_id", "auth_comp_id",
+   "label_asym_id", "auth_asym_id", "label_seq_id", "auth_seq_id", "pdbx_PDB_ins_code", "Cartn_x", "Cartn_y", "Cartn_z", "pdbx_PDB_model_num"};
+
+/* hydrogen bond donor and electrostatic info by residue and atom name, compiled in from translation.txt */
+struct TRANSLATION
+{
+   unsigned long long key;    /* residue and atom name as interned by atom_key() */
+   unsigned char hdonor;
+   unsigned char charge;
+};
+
+#include "translation.h"
+
+/* covalent and vdW radii by element code */
+float cov_radius[5]={0.0, 0.77, 0.73, 0.75, 1.02};
+float vdw_radius[5]={0.0, 1.70, 1.52, 1.55, 1.80};
+
+/* All the memory used for one protein comes from an arena of blocks that are handed out in order */
+/* and taken back in one step by arena_reset() when the next protein starts */
+
+struct ARENABLOCK
+{
+   struct ARENABLOCK *next;   /* older block */
+   size_t size;               /* bytes that can be handed out, after this header */
+   size_t used;
+};
+
+struct ARENA
+{
+   struct ARENABLOCK *block;  /* block being handed out, older blocks follow on */
+   void *last;                /* most recent allocation, which can grow in place */
+   size_t used;               /* bytes handed out since the last reset */
+   size_t failed;             /* bytes of the first block there was no memory for since the last reset, 0 if none */
+};
 
 /* For a helix containing 100 residues: there are 97 local axes, 98 local origins, 32 bending angles */
+/* The per-residue arrays of all the helices of a protein are held contiguously, one slot per residue */
+/* plus a spare slot that ends each helix; a helix points at its own run of slots, starting at offset */
 
 struct HELIX
 {
    int helix_no;
    char pdb[5];
    char chain;    
-   char residues[MAXRESIDUES+1];
-   float residue_numbers[MAXRESIDUES];
-   float ca_coord[MAXRESIDUES][3];
-   double unit_local_axis[MAXRESIDUES-3][3];
-   double origin[MAXRESIDUES-2][3];
-   double bending_angle[MAXRESIDUES/3];
+   int offset;                   /* first slot of the helix in the per-protein residue arrays */
+   char *residues;
+   float *residue_numbers;
+   float (*ca_coord)[3];
+   double (*unit_local_axis)[3];
+   double (*axis_sum)[3];        /* axis_sum[g] is the sum of the unit local axes before axis g */
+   int *unset_axes;              /* unset_axes[g] counts the axes before axis g with a component of -1, as unset ones have */
+   double (*origin)[3];
+   double *bending_angle;
    double max_bending_angle;
    int residues_total;
    int atoms_total;
    char geometry;      /* S for short, U for unknown, K for kinked, C for curved, L for linear */
 };
 
-struct ATOM
+/* The helix atoms of a protein are held helix by helix in one array per field: the atoms */
+/* of helix i start at helix_start[i] and there are helix[i].atoms_total of them */
+
+struct ATOMSTORE
 {
-   int atom_number;
-   char atom_name[5];
-   char residue_name[4];
-   char chain;
-   float residue_number;
-   float atom_coord[3];
-   int hdonor;                /* 1 for hbond donor or 0 if not */
-   int charge;                /* 0 for neutral, 1 for positive, 2 for negative */
+   int atoms_total;
+   int atoms_max;             /* atoms allocated */
+   struct ARENA *arena;       /* where the arrays are grown */
+   int *helix_start;          /* first atom of each helix, helices total + 1 entries */
+   float *x;
+   float *y;
+   float *z;
+   unsigned char *element;    /* ELEMENT_ code from the atom name */
+   unsigned char *atom_class; /* CLASS_ bits from the atom name */
+   unsigned char *hdonor;     /* 1 for hbond donor or 0 if not */
+   unsigned char *charge;     /* 0 for neutral, 1 for positive, 2 for negative */
+   int *residue;              /* index of the residue in its helix */
+   float *residue_number;
+   int *atom_number;
+   char (*atom_name)[5];
+   char (*residue_name)[4];
+   char *chain;
 };
 
-struct DISTANCE
+struct CONTACT
 {
+   int atom1;                 /* atom number in helix 1 */
+   int atom2;                 /* atom number in helix 2 */
    float distance;
-   char atom_name1[5];
-   char atom_name2[5];
-   float residue_number1;
-   float residue_number2;
-   int helix_number1;
-   int helix_number2;
+   char type;                 /* C for covalent, E for electrostatic, H for hbond, V for vdw, - for none */
+};
+
+struct CONTACTLIST
+{
+   struct CONTACT *contact;
+   int contacts_total;
+   int contacts_max;          /* contacts allocated */
+   struct ARENA *arena;
 };
 
 struct HELIXPAIR
@@ -175,69 +693,450 @@ struct HELIXPAIR
    double angle2;             /* the interhelical dihedral angle using only the axis vectors in the contact area */
    double distance;           /* length of line of closest approach between the 2 helix axes using first method */
 };
-   
+
+/* Sparse store of the neighbouring helix pairs of a protein. Pairs are added in the order of the */
+/* neighbour scan (by helix two, then helix one), so the store stays sorted and is searched by halving */
+
+struct PAIRSTORE
+{
+   struct HELIXPAIR *pair;
+   int pairs_total;
+   int pairs_max;
+   struct ARENA *arena;             /* pairs allocated */
+};
+
+/* Range of the tasks of a pool still to be done by one thread, an idle thread steals the back half of another's */
+struct TASKRANGE
+{
+   int next;
+   int end;
+   pthread_mutex_t lock;
+};
+
+struct TASKPOOL
+{
+   struct TASKRANGE *range;   /* one per thread */
+   int threads_total;
+   void (*task)(void *context, int task, int thread);
+   void *context;
+};
+
+struct TASKTHREAD
+{
+   struct TASKPOOL *pool;
+   int thread;
+};
+
+/* A run of helix one atoms of a helix pair, scanned for contacts as one task */
+struct TILE
+{
+   int pair;                  /* helix pair in the pair store */
+   int first_atom;            /* first atom of helix one scanned, relative to the helix */
+   int last_atom;             /* one past the last */
+   struct HELIXPAIR counts;   /* bond counts of the tile */
+   struct CONTACTLIST *contacts;
+};
+
+/* The helix pairs of a protein, tested and scanned by a pool of threads and merged back in pair order */
+struct PAIRSCAN
+{
+   struct HELIX *helix;
+   struct ATOMSTORE *atoms;
+   struct CELLGRID *grid;
+   struct PAIRSTORE *pair_store;
+   int *candidate;            /* candidate helix pairs, as from helix_candidates() */
+   char *neighbour;           /* set for the candidates that are neighbours */
+   struct TILE *tile;
+   int tiles_total;
+   int threads_total;
+   struct ARENA **arena;      /* one per thread, the first is the arena of the protein; those of the context */
+   struct SCANSCRATCH **scratch;   /* one per thread */
+};
+
+/* Bounding capsule of a helix, the axis segment from its first to last C-alpha widened by radius */
+
+struct CAPSULE
+{
+   double p0[3];              /* first C-alpha */
+   double p1[3];              /* last C-alpha */
+   double radius;
+   double lo[3];              /* bounding box of the capsule */
+   double hi[3];
+};
+
+/* Node of the bounding-volume hierarchy over the helix capsules */
+
+struct HELIXNODE
+{
+   double lo[3];              /* bounding box of all capsules below the node */
+   double hi[3];
+   int left;                  /* child nodes, -1 for a leaf */
+   int right;
+   int first;                 /* first entry of the node's helices in the sorted helix order */
+   int count;                 /* number of helices below the node */
+};
+
+/* Uniform cell grid over all helix atoms of a protein, used to find atom pairs within CONTACT_CUTOFF */
+/* Atoms are numbered globally as in the atom store, helix_start[helix] + atom number in helix. The */
+/* helix assigner puts the backbone residues in a grid of its own, numbered as in the backbone */
+
+struct CELLGRID
+{
+   double min[3];             /* lowest corner of the grid */
+   double cell;               /* edge length of a cell (never less than GRID_CELL, or HBOND_CA_DISTANCE) */
+   int cells[3];              /* number of cells along X, Y and Z */
+   int *cell_start;           /* first entry of each cell in atom_list (cells total + 1 entries) */
+   int *atom_list;            /* global atom numbers sorted by cell, ascending within a cell */
+   int *atom_cell;            /* cell of each atom, by global atom number */
+   int *helix_start;          /* global number of the first atom of each helix, NULL for residues */
+   int atoms_max;             /* most atoms in one helix */
+};
+
+/* Helix records of a protein being built, a residue at a time, as by read_helices() */
+struct HELIXBUILD
+{
+   struct HELIX *helix;
+   char *residues;
+   float *residue_numbers;
+   int helices_max;
+   int slots_max;
+   int i;                     /* helix being built */
+   int k;                     /* residues of it so far */
+   float (*ca)[3];            /* C-alphas of the helix residues in turn, NULL unless taken from the DSSP file */
+   int cas_total;
+   int cas_max;
+   struct ARENA *arena;
+};
+
+/* A backbone hydrogen bond of the helix assigner, to or from residue */
+struct HBOND
+{
+   int residue;               /* -1 for none */
+   double energy;
+};
+
+/* The backbone of a protein as the helix assigner takes it, a residue at a time */
+struct BACKBONE
+{
+   double (*n)[3];
+   double (*ca)[3];
+   double (*c)[3];
+   double (*o)[3];
+   double (*h)[3];            /* amide hydrogen, placed as by DSSP */
+   double *seq;
+   int *number;               /* DSSP numbering, one left out at each break in the chain */
+   struct HBOND (*acceptor)[2];  /* the two strongest bonds from the N-H of each residue */
+   struct HBOND (*donor)[2];     /* the two strongest bonds to its O */
+   char (*resname)[4];
+   char *chain;
+   char *res_sub_type;
+   char *letter;              /* one letter code */
+   unsigned char *present;    /* BACKBONE_ bits of the atoms found */
+   int residues_total;
+   int residues_max;
+   struct ARENA *arena;
+};
+
+/* A ladder of beta bridges, residues i_front..i_back paired with j_front..j_back */
+struct BRIDGE
+{
+   int type;
+   char chain;
+   int order;                 /* order found, to keep the sort stable */
+   int i_front;
+   int i_back;
+   int j_front;
+   int j_back;
+   int length;                /* bridges in the ladder */
+};
+
+/* Scratch lists of one thread scanning the grid */
+struct SCANSCRATCH
+{
+   int *candidates;           /* atoms near the atom being tested */
+   int *near;                 /* the candidates within cutoffs.reach */
+   double *near_d2;           /* squared distances of the near candidates */
+};
+
+/* Squared distance limits of each contact type, by element code (or H-bond key) of the two atoms. */
+/* Each is the largest squared distance whose float distance still passes the original test, */
+/* so the limits can be applied before any square root is taken */
+struct CUTOFFS
+{
+   double covalent[5][5];
+   double vdw[5][5];          /* vdW bond, 106% of the radii sum */
+   double packing[5][5];      /* residue contact, radii sum + TOLERANCE */
+   double hbond[HBOND_KEYS][HBOND_KEYS];
+   double electrostatic;
+   double reach;              /* largest of all the limits */
+};
+
+struct CUTOFFS cutoffs;
+
+/* the twenty amino acids and their one letter codes, as given by DSSP */
+const char amino_acid_name[]="ALAARGASNASPCYSGLNGLUGLYHISILELEULYSMETPHEPROSERTHRTRPTYRVAL";
+const char amino_acid_letter[]="ARNDCQEGHILKMFPSTWYV";
+
+/* the cutoffs and the distance kernel are set up by the first context made */
+pthread_once_t kernels_once=PTHREAD_ONCE_INIT;
+
+/* Function that lists, in order, the candidates (atom numbers relative to x, y and z) within reach */
+/* of an atom and their squared distances; the scalar version is replaced at run time by a vector one */
+int distance_scalar(float ax, float ay, float az, const float *x, const float *y, const float *z, const int *candidate, int candidates_total, double reach, int *near, double *near_d2);
+int (*distance_kernel)(float, float, float, const float*, const float*, const float*, const int*, int, double, int*, double*)=distance_scalar;
+
+/* Function that works out the DSSP hydrogen bond energies of a residue with each of its neighbours, before */
+/* rounding; the scalar version is replaced at run time by a vector one */
+void hbond_scalar(struct BACKBONE*, int i, const int *neighbour, int neighbours_total, double *given, double *taken);
+void (*hbond_kernel)(struct BACKBONE*, int, const int*, int, double*, double*)=hbond_scalar;
+
 /* Prototypes */
 
-struct HELIX* read_helices(FILE *fpi_dssp, int *helices_total, char *pdb_id);
-struct ATOM** read_atom(FILE *fpi_pdb, struct HELIX*, int *helices_total, int *helices_atom_total);
-void get_atom_info(struct ATOM**, struct HELIX*, int *helices_total);
-void get_ca_coords(struct HELIX*, struct ATOM**, int *helices_total);
-void get_local_axis(int helix_number, struct HELIX*);
-void get_bending_angle(int helix_number, struct HELIX*);
-void fit(int helix_number, struct HELIX*);
-double** matinv3(double **h);
-double** matinv2(double **p);
-void destroy_matrix3(double **s);
-void destroy_matrix2(double **q);
-struct HELIXPAIR** neighbours(int *helices_total); 
-struct DISTANCE** residue_distance(int helix1, int helix2, struct HELIX*, struct HELIXPAIR**);
-struct DISTANCE** atom_distance(int helix1, int helix2, struct HELIX*, struct ATOM**, struct HELIXPAIR**);
-void destroy_residue_residue(struct DISTANCE**, struct HELIX*, int helix_number);
-void destroy_atom_atom(struct DISTANCE**, struct HELIX*, int helix_number);
-void two_helix_all_vectors(int helix_A, int helix_B, struct HELIX*, struct HELIXPAIR**);
-void two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX*, struct HELIXPAIR**);
-void destroy_helix_atom(struct ATOM**, int *helices_total);
-void destroy_helix_pair(struct HELIXPAIR**, int *helices_total);
+struct ARENA* make_arena(void);
+struct ARENABLOCK* arena_block(size_t size);
+void arena_unblock(struct ARENABLOCK*);
+void* arena_alloc(struct ARENA*, size_t size);
+void* arena_realloc(struct ARENA*, void *old, size_t old_size, size_t size);
+void arena_reset(struct ARENA*);
+void destroy_arena(struct ARENA*);
+int open_text(struct TEXTINPUT*, FILE *fp);
+int memory_text(struct TEXTINPUT*, const char *text, size_t size);
+int start_text(struct TEXTINPUT*);
+void* inflate_text(void *inflater);
+void wait_text(struct TEXTINPUT*, size_t bytes);
+int text_failed(struct TEXTINPUT*);
+void close_text(struct TEXTINPUT*);
+void rewind_text(struct TEXTINPUT*);
+int next_record(struct TEXTINPUT*, int size, const char **record);
+void view_line(struct LINEVIEW*, const char *record, int length, int strip);
+void zero_column(struct LINEVIEW*, int column);
+double decode_number(const char *field, int width);
+int decode_integer(const char *field, int width);
+struct HELIX* read_helices(struct TEXTINPUT *dssp, int *helices_total, char *pdb_id, int ca_only, struct ARENA*);
+void start_helices(struct HELIXBUILD*, struct ARENA*);
+void helix_residue(struct HELIXBUILD*, char *pdb_id, char chain, float res_number, char residue, const float *ca);
+void end_helix(struct HELIXBUILD*);
+struct HELIX* finish_helices(struct HELIXBUILD*, int *helices_total);
+struct HELIX* assign_helices(struct TEXTINPUT *structure, int *helices_total, char *pdb_id, struct ARENA*);
+int backbone_site(void *backbone, struct ATOMSITE*);
+int add_residue(struct BACKBONE*);
+void complete_backbone(struct BACKBONE*);
+char residue_letter(const char *resname);
+void backbone_hbonds(struct BACKBONE*);
+int compare_residues(const void *a, const void *b);
+void hbond_energies(struct BACKBONE*, int i, int *neighbour, int neighbours_total, double *given, double *taken);
+void choose_hbond_kernel(void);
+#ifdef X86_KERNELS
+void hbond_avx2(struct BACKBONE*, int i, const int *neighbour, int neighbours_total, double *given, double *taken);
+#endif
+void keep_hbond(struct BACKBONE*, int donor, int acceptor, double energy);
+int test_bond(struct BACKBONE*, int a, int b);
+int no_break(struct BACKBONE*, int a, int b);
+int test_bridge(struct BACKBONE*, int i, int j);
+void beta_bridges(struct BACKBONE*, char *structure_type);
+int compare_pairs(const void *a, const void *b);
+int compare_bridges(const void *a, const void *b);
+void helix_structure(struct BACKBONE*, char *structure_type);
+void init_helix(struct HELIX*, int offset, char *residues, float *residue_numbers);
+struct HELIX* next_helix(struct HELIX*, int i, int *helices_max, char **residues, float **residue_numbers, int *slots_max, struct ARENA*);
+struct ATOMSTORE* read_atom(struct TEXTINPUT *pdb, struct HELIX*, int *helices_total, int *helices_atom_total, struct ARENA*);
+struct ATOMSTORE* start_walk(struct HELIXWALK*, int helices_total, struct ARENA*);
+int walk_residue(struct HELIXWALK*, struct HELIX*, float current_residue_number);
+void walk_atom(struct HELIXWALK*, float current_residue_number);
+int walk_on(struct HELIXWALK*, struct HELIX*, struct ATOMSTORE*, int helices_total, float current_residue_number);
+void end_walk(struct HELIXWALK*, struct ATOMSTORE*, int helices_total, int *helices_atom_total);
+int cif_text(struct TEXTINPUT*);
+int cif_token(struct CIFREADER*, const char **token, int *quoted);
+int cif_keyword(const char *token, int length);
+int cif_value(struct CIFROW*, int field);
+double cif_number(struct CIFROW*, int field);
+int cif_atom_site(struct CIFREADER*, struct ARENA*);
+int cif_row(struct CIFREADER*, struct CIFROW*);
+struct ATOMSTORE* read_cif_atoms(struct TEXTINPUT *cif, struct HELIX*, int *helices_total, int *helices_atom_total, struct ARENA*);
+void cif_atom_name(struct CIFROW*, char *atom_name);
+void cif_residue_name(struct CIFROW*, char *resname);
+char cif_chain(struct CIFROW*);
+char cif_insertion(struct CIFROW*);
+float insertion_number(char res_sub_type);
+int binary_text(struct TEXTINPUT*);
+int open_binary(struct BINARYREADER*, struct TEXTINPUT *binary);
+int next_binary(struct BINARYREADER*, struct ATOMSITE*);
+struct ATOMSTORE* read_binary_atoms(struct TEXTINPUT *binary, struct HELIX*, int *helices_total, int *helices_atom_total, struct ARENA*);
+int write_binary(struct XHELIX*, char *pdb_id, struct TEXTINPUT *structure, FILE *fp);
+int structure_sites(struct TEXTINPUT *structure, int (*site)(void*, struct ATOMSITE*), void *data, struct ARENA*);
+int pdb_sites(struct TEXTINPUT *pdb, int (*site)(void*, struct ATOMSITE*), void *data);
+int cif_sites(struct TEXTINPUT *cif, int (*site)(void*, struct ATOMSITE*), void *data, struct ARENA*);
+int binary_site(void *writer, struct ATOMSITE*);
+void end_run(struct BINARYWRITER*);
+int binary_name(struct ARENA*, char **table, int width, int *names_total, int *names_max, const char *name);
+void put_byte(struct BYTES*, unsigned char byte);
+void put_varint(struct BYTES*, unsigned long long value);
+void put_signed(struct BYTES*, long long value);
+int get_varint(const unsigned char **next, const unsigned char *end, unsigned long long *value);
+int get_signed(const unsigned char **next, const unsigned char *end, long long *value);
+void put_u32(unsigned char *bytes, unsigned long long value);
+unsigned long long get_u32(const unsigned char *bytes);
+void put_double(unsigned char *bytes, double value);
+double get_double(const unsigned char *bytes);
+size_t column_bytes(int width, unsigned long long rows);
+const unsigned char* group_column(const unsigned char *group, const struct RESULTCOLUMN*, int c);
+int add_atom(struct ATOMSTORE*);
+void type_atom(struct ATOMSTORE*, int atom);
+int get_ca_coords(struct HELIX*, struct ATOMSTORE*, int *helices_total, struct ENTRYSTATE*);
+int get_local_axis(int helix_number, struct HELIX*, struct ENTRYSTATE*);
+void sum_axes(int helix_number, struct HELIX*);
+void axis_run(struct HELIX*, int first, int last, double total[3]);
+int get_bending_angle(int helix_number, struct HELIX*, struct ENTRYSTATE*);
+int fit(int helix_number, struct HELIX*, struct ARENA*, struct ENTRYSTATE*);
+double** matinv3(double **h, struct ARENA*);
+double** matinv2(double **p, struct ARENA*);
+double** make_matrix(int n, struct ARENA*);
+struct PAIRSTORE* neighbours(struct ARENA*);
+struct HELIXPAIR* add_pair(struct PAIRSTORE*, int helix1, int helix2);
+struct HELIXPAIR* find_pair(struct PAIRSTORE*, int helix1, int helix2);
+int* helix_candidates(struct HELIX*, int *helices_total, int *candidates_total, struct ARENA*);
+double capsule_distance(struct CAPSULE*, struct CAPSULE*);
+int compare_candidates(const void *a, const void *b);
+int residue_distance(int helix1, int helix2, struct HELIX*);
+struct CELLGRID* make_cell_grid(struct HELIX*, struct ATOMSTORE*, int *helices_total, struct ARENA*);
+struct SCANSCRATCH* make_scan_scratch(struct CELLGRID*, struct ARENA*);
+int near_atoms(struct CELLGRID*, struct SCANSCRATCH*, int atom, int helix_number);
+int size_grid(struct CELLGRID*, double *max);
+int grid_cell(struct CELLGRID*, double x, double y, double z);
+int fill_grid(struct CELLGRID*, int cells_total, int points_total, struct ARENA*);
+int grid_near(struct CELLGRID*, int point, int first, int last, int *list);
+struct CONTACTLIST* make_contact_list(struct ARENA*);
+void add_contact(struct CONTACTLIST*, int atom1, int atom2, float distance, char type);
+double squared_cutoff(float distance);
+float hbond_length(int class1, int donor1, int class2, int donor2);
+void make_cutoffs(void);
+void choose_distance_kernel(void);
+#ifdef X86_KERNELS
+int distance_avx2(float ax, float ay, float az, const float *x, const float *y, const float *z, const int *candidate, int candidates_total, double reach, int *near, double *near_d2);
+int distance_avx512(float ax, float ay, float az, const float *x, const float *y, const float *z, const int *candidate, int candidates_total, double reach, int *near, double *near_d2);
+#endif
+void contact_scan(int helix1, int helix2, int first_atom, int last_atom, struct ATOMSTORE*, struct CELLGRID*, struct SCANSCRATCH*, struct HELIXPAIR*, struct CONTACTLIST*);
+int atom_distance(int helix1, int helix2, struct HELIX*, struct ATOMSTORE*, struct CONTACTLIST*, struct HELIXPAIR*, struct ENTRYSTATE*);
+struct PAIRSCAN* make_pair_scan(struct HELIX*, struct ATOMSTORE*, struct CELLGRID*, struct PAIRSTORE*, int *candidate, int candidates_total, int threads_total, struct ARENA **arena);
+void neighbour_task(void *scan, int task, int thread);
+void make_tiles(struct PAIRSCAN*);
+void tile_task(void *scan, int task, int thread);
+int merge_tiles(struct PAIRSCAN*, int tile, struct HELIXPAIR*, struct CONTACTLIST*);
+void run_tasks(int tasks_total, int threads_total, void (*task)(void*, int, int), void *context);
+int take_task(struct TASKPOOL*, int thread);
+void* task_worker(void *task_thread);
+int two_helix_all_vectors(int helix_A, int helix_B, struct HELIX*, struct HELIXPAIR*, struct ENTRYSTATE*);
+int two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX*, struct HELIXPAIR*, struct ENTRYSTATE*);
 // dmf 7.29.17
-void create_filenames(char *pdb_id);
+void create_filenames(char *pdb_id, struct ENTRYSTATE*);
+int analyse_entry(struct XHELIX*, char *pdb_id, struct TEXTINPUT *dssp, struct TEXTINPUT *pdb);
+int finish_entry(struct XHELIX*, struct ENTRYSTATE*, int status);
+int keep_results(struct XHELIX*, struct HELIX*, int helices_total, struct PAIRSTORE*);
+void clear_results(struct XHELIX*);
+void init_kernels(void);
+int entry_error(struct ENTRYSTATE*, int status, const char *format, ...);
+int arena_error(struct ENTRYSTATE*, struct ARENA **arena, int arenas_total);
+int open_output(struct ENTRYSTATE*, int output, char *filename, struct ARENA*, FILE **fp);
+void write_output(FILE *fp, const char *format, ...);
+void close_output(FILE *fp);
+int open_deflater(struct ENTRYSTATE*, char *filename, FILE **fp);
+void* deflate_output(void *deflater);
+int deflate_chunk(struct DEFLATER*, size_t size, int finish);
+int close_deflaters(struct ENTRYSTATE*, int status);
+void add_entry(struct BATCH*, char *pdb_id);
+void drop_repeats(struct BATCH*);
+int compare_entries(const void *a, const void *b);
+void* batch_worker(void *batch);
+int batch_entry(struct XHELIX*, char *pdb_id, char *PDBDIR, char *DSSPDIR);
+int batch_binary(struct XHELIX*, char *pdb_id, char *PDBDIR);
+FILE* open_structure(char *pdb_id, char *PDBDIR, int binary);
+int output_bits(char *list);
+int compression_type(char *name);
+struct RESULTSTORE* open_results(char *filename);
+int store_results(struct BATCH*, int e, struct XHELIX*);
+int gather_rows(struct RESULTSTORE*, struct BATCHENTRY*);
+int write_group(struct RESULTSTORE*, const char *table, const void *rows, size_t row_size, const struct RESULTCOLUMN *column, int columns_total, int rows_total);
+int close_results(struct RESULTSTORE*);
+int add_key(struct RESULTSTORE*, const char *pdb, char chain, int helix_no, char table, int row);
+int compare_keys(const void *a, const void *b);
+int query_results(char *filename, char *query);
+int compare_ints(const void *a, const void *b);
+
+/* the x-helix program, left out when building the library */
+#ifndef XHELIX_LIBRARY
 
 /* --------------------------------Entry Point---------------------------- */
 
-int main(void)     
+int main(int argc, char *argv[])     
 {
    /* Variables */
 
-   FILE *fpi_dssp;
-   FILE *fpi_pdb;
    FILE *fpi_cath;
-   FILE *fpo_helices;
-   FILE *fpo_packing;
-   FILE *fpo_shape;
-   struct HELIX *helix;
-   struct ATOM **helix_atom;
-   struct DISTANCE **residue_residue;
-   struct HELIXPAIR **helix_pair;
-   struct DISTANCE **atom_atom;
-   int g,h,i,j;
-   int helices_total;
-   int helices_atom_total;
+   struct BATCH batch;
+   pthread_t *thread;
+   int i;
+   int threads_total;
    char pdb_id[5];
    char temp_pdb[5]="";
-   char dsspfile[50];
-   char PDBDIR[39];
-   char DSSPDIR[41];
-   char pdbfile[50];
-   char obpdbfile[40];
+   char PDBDIR[40];                  /* up to 38 characters read, and a '/' added */
+   char DSSPDIR[42];
    char cathfile[50]="";
    char line[CLINLEN];
-    
-    // dmf 6.30.17
-    FILE *fpo_pyaxis;
+   char *query_file=NULL;
+   char *query=NULL;
 
 #ifdef DEBUG
 	printf("\n\tHello world!\n\tDebugging mode active\n\n"); 
 #endif
 
+   /* entries are analysed by as many threads as there are processors, unless set by -t */
+
+   threads_total=(int)sysconf(_SC_NPROCESSORS_ONLN);
+
+   /* with -b the structures of the entries are written as binary files instead, see write_binary() */
+
+   /* with -c the entries are analysed from the C-alphas of their DSSP files alone, see xhelix_set_ca_only() */
+
+   /* with -o only the output files named in a comma separated list are written, e.g. -o packing,shape, */
+   /* see output_bits(); all eight are written otherwise, axis.py as well as axis_cgo.py */
+
+   /* with -z gzip or -z zstd the output files are compressed as they are written, each by a thread of its */
+   /* own, and named with .gz or .zst added, see open_deflater() */
+
+   /* with -r the helices and packed pairs of all the entries also go into one result store, see write_group(); */
+   /* with -q a result store is looked up by <pdb code>[:<chain>[:<helix>]] instead, see query_results() */
+
+   batch.binary=0;
+   batch.ca_only=0;
+   batch.outputs=XHELIX_OUTPUT_ALL;
+   batch.compression=XHELIX_COMPRESS_NONE;
+   batch.store=NULL;
+
+   for(i=1;i<argc;i++)
+   {
+      if((!strcmp(argv[i],"-t")) && (i+1<argc)) threads_total=atoi(argv[++i]);
+      else if(!strcmp(argv[i],"-b")) batch.binary=1;
+      else if(!strcmp(argv[i],"-c")) batch.ca_only=1;
+      else if((!strcmp(argv[i],"-o")) && (i+1<argc) && ((batch.outputs=output_bits(argv[++i]))>=0)) continue;
+      else if((!strcmp(argv[i],"-z")) && (i+1<argc) && ((batch.compression=compression_type(argv[++i]))>=0)) continue;
+      else if((!strcmp(argv[i],"-r")) && (i+1<argc) && (batch.store==NULL)) batch.store=open_results(argv[++i]);
+      else if((!strcmp(argv[i],"-q")) && (i+2<argc))
+      {
+         query_file=argv[++i];
+         query=argv[++i];
+      }
+      else
+      {
+         printf("Usage: %s [-t threads] [-b] [-c] [-o helices,packing,shape,axis,geom,contact,pymol,cgo|all|none] [-z gzip|zstd] [-r results.xhr]\n",argv[0]);
+         printf("       %s -q results.xhr pdb[:chain[:helix]]\n",argv[0]);
+         exit(1);
+      }
+   }
+
+   if(query!=NULL) return query_results(query_file, query);
+
+   if(threads_total<1) threads_total=1;
+
    printf("\nInput filename read by taking first four characters of each line.\n");
    printf("Four characters: <pdb code>\n\n");
 
@@ -267,8 +1166,16 @@ int main(void)
       exit(1);
    }
 
+   batch.entry=(struct BATCHENTRY *) malloc(ENTRIES_START*sizeof(struct BATCHENTRY));
+   batch.entries_total=0;
+   batch.entries_max=ENTRIES_START;
+   batch.next_entry=0;
+   batch.failed=0;
+   batch.pdb_dir=PDBDIR;
+   batch.dssp_dir=DSSPDIR;
+
 // ***** cath.txt read loop *****
-// the following reads in each line from the cathfile input list and processes it
+// the following reads in each line from the cathfile input list and lists it for analysis
    while(!feof(fpi_cath)) 
    {
       fgets(line, CLINLEN, fpi_cath);
@@ -291,1269 +1198,5644 @@ int main(void)
       {
          strcpy(temp_pdb,pdb_id);
 
-         strcpy(dsspfile,DSSPDIR);
-         strcat(dsspfile,pdb_id);
-         strcat(dsspfile,".dssp");
+         add_entry(&batch, pdb_id);
+      }
+   }
+// end of cathfile input read loop
+// ***** end of cath.txt read loop *****
+    
+   fclose(fpi_cath);
 
-         strcpy(pdbfile,PDBDIR);
-         strcat(pdbfile,"pdb");
-         strcat(pdbfile,pdb_id);
-         strcat(pdbfile,".ent");
+   /* an entry listed twice would have two threads writing the same files, so it is analysed once */
 
-// dmf 6.28.17 change to allow 1xyz.pdb as a default alternate to pdb1xyz.ent
-         strcpy(obpdbfile,PDBDIR);
-         strcat(obpdbfile,pdb_id);
-         strcat(obpdbfile,".pdb");
+   drop_repeats(&batch);
 
-         printf("\nAnalysis of %s in progress\n",pdb_id);
-         printf("Input Files: %s, %s\n\n",dsspfile,pdbfile);
+   /* threads that would have no entry of their own share out the helix pairs of the entries instead */
 
-          // dmf 7.29.17 create the output filenames
-          create_filenames(pdb_id);
-          
-// ** moved from above **
-          
-          // dmf 7.25.17 - want to modify output_packing to include identifying string.
-          // therefore, this statement needs to be moved to after file input, below.
-          if((fpo_packing=fopen(output_packing, "w"))==NULL)
-          {
-              printf("\n\n** Error writing to file '%s'!",output_packing);
-              exit(1);
-          }
-          
-          fprintf(fpo_packing,"Protein\tHelix1\tHelix2\tCont 1\tCont 2\tGlobal Angle\tLocal Angle\tDistance\tCovalnt\tElectro\tH-Bond\tVDW\n");
-          
-          // dmf 7.25.17 - want to modify output_shape to include identifying string.
-          // therefore, this statement needs to be moved to after file input, below.
-          if((fpo_shape=fopen(output_shape, "w"))==NULL)
-          {
-              printf("\n\n** Error writing to file '%s'!",output_shape);
-              exit(1);
-          }
-          
-          fprintf(fpo_shape,"Protein\tChain\tHelix\tLength\tGeom\tMax Bending Angle\n");
-          
-// ** end of moved from above **
+   batch.pair_threads=1;
 
-// dmf 7.25.17 - want to modify output_helices to include identifying string. 
-         if((fpo_helices=fopen(output_helices, "w"))==NULL)
-         {
-            printf("\n\n** Error writing to file '%s'!",output_helices);
-            exit(1);
-         }
+   if(threads_total>batch.entries_total)
+   {
+      if(batch.entries_total>0) batch.pair_threads=threads_total/batch.entries_total;
 
-         if((fpi_dssp=fopen(dsspfile,"r"))==NULL)
-         {
-            printf("\n\nError opening %s\n",dsspfile);
-            exit(1);
-         }
+      threads_total=batch.entries_total;
+   }
 
-         helix=read_helices(fpi_dssp, &helices_total, pdb_id);
+   batch.entry_threads=threads_total;
 
-         fclose(fpi_dssp);
+   if(threads_total<=1)
+   {
+      batch_worker(&batch);
+   }
+   else
+   {
+      thread=(pthread_t *) malloc(threads_total*sizeof(pthread_t));
 
-         if((fpi_pdb=fopen(pdbfile,"r"))==NULL)
+      for(i=0;i<threads_total;i++)
+      {
+         if(pthread_create(&thread[i], NULL, batch_worker, &batch))
          {
-            if((fpi_pdb=fopen(obpdbfile,"r"))==NULL)
-            {
-               printf("\n\nError opening %s\n",pdbfile);
-               printf("Error opening %s\n",obpdbfile);
-               exit(1);
-            }
+            printf("\n\n** Error starting thread %d!\n",i);
+            exit(1);
          }
+      }
 
-         helix_atom=read_atom(fpi_pdb, helix, &helices_total, &helices_atom_total);
+      for(i=0;i<threads_total;i++) pthread_join(thread[i], NULL);
 
-         fclose(fpi_pdb);
+      free(thread);
+   }
 
-         get_atom_info(helix_atom, helix, &helices_total);
+   /* after an error the result store still gets its index, of the entries stored before the one that failed, */
+   /* unless it is the store itself that could not be written */
 
-         get_ca_coords(helix, helix_atom, &helices_total);
+   if((batch.store!=NULL) && close_results(batch.store)) batch.failed=1;
 
-         for(i=0;i<helices_total;i++)
-         {
-            get_local_axis(i, helix);
+   /* the rows of entries analysed after one that failed, or after the store failed, were never stored */
 
-            get_bending_angle(i, helix);
-       
-            fit(i, helix);
-         } 
-   
-         for(i=0;i<helices_total;i++)
-         {
-            fprintf(fpo_helices,"protein: %s, chain: %c, helix: %d, start residue: %.2f, last residue: %.2f\n",helix[i].pdb,helix[i].chain,helix[i].helix_no,helix[i].residue_numbers[0],helix[i].residue_numbers[helix[i].residues_total-1]);
-            fprintf(fpo_helices,"number of residues: %d, sequence: %s\n",helix[i].residues_total,helix[i].residues);
-            fprintf(fpo_helices,"maximum bending angle: %f degrees, overall geometry: %c\n\n",helix[i].max_bending_angle,helix[i].geometry);
-         }
+   for(i=0;i<batch.entries_total;i++)
+   {
+      free(batch.entry[i].helix);
+      free(batch.entry[i].pair);
+   }
 
-         fprintf(fpo_helices,"Total Number of Helices = %d\n\n",helices_total);
+   free(batch.entry);
 
-         helix_pair=neighbours(&helices_total);
+   return batch.failed ? 1 : 0;
+}
+// end of main();
+#endif
 
-         fprintf(fpo_helices,"Neighbouring Helices\n\n");
+/* ------------------------------------------------------------------------- */
 
-         for(j=0;j<helices_total;j++)
-         {
-            printf(".");
-            fflush(stdout);
-    
-            for(i=0;i<=j;i++)
-            {
-               residue_residue=residue_distance(i, j, helix, helix_pair);
-          
-               destroy_residue_residue(residue_residue, helix, i);
+/* Function to analyse one PDB entry from the texts of its DSSP and PDB files (a NULL DSSP text to assign the */
+/* helices from the structure), keep its results in the context */
+/* and write the output files asked for; all its memory comes from the context's arena and its helix pairs */
+/* are shared out among the context's threads. Returns XHELIX_OK or an error code, with the message in the context */
+int analyse_entry(struct XHELIX *context, char *pdb_id, struct TEXTINPUT *dssp, struct TEXTINPUT *pdb)
+{
+   /* Variables */
 
-               if(helix_pair[i][j].neighbours==1)
-               {
-                  atom_atom=atom_distance(i, j, helix, helix_atom, helix_pair);
-
-                  fprintf(fpo_helices,"helix %d & ",helix_pair[i][j].helix_one);
-                  fprintf(fpo_helices,"helix %d  ",helix_pair[i][j].helix_two);
-                  fprintf(fpo_helices,"neighbours: %d  ",helix_pair[i][j].neighbours);
-                  fprintf(fpo_helices,"packed: %d  ",helix_pair[i][j].packed);
-                  fprintf(fpo_helices,"helix %d contact residues: %d  ",helix_pair[i][j].helix_one,helix_pair[i][j].h1_residues);
-                  fprintf(fpo_helices,"helix %d contact residues: %d  ",helix_pair[i][j].helix_two,helix_pair[i][j].h2_residues);
-                  fprintf(fpo_helices,"helix %d first contact residue: %d  ",helix_pair[i][j].helix_one,helix_pair[i][j].h1_start);
-                  fprintf(fpo_helices,"last contact residue: %d  ",helix_pair[i][j].h1_end);
-                  fprintf(fpo_helices,"helix %d first contact residue: %d  ",helix_pair[i][j].helix_two,helix_pair[i][j].h2_start);
-                  fprintf(fpo_helices,"last contact residue: %d  ",helix_pair[i][j].h2_end);
-                  fprintf(fpo_helices,"covalents: %d  ",helix_pair[i][j].covalent);
-                  fprintf(fpo_helices,"electrostatics: %d  ",helix_pair[i][j].electrostatic);
-                  fprintf(fpo_helices,"hbonds: %d  ",helix_pair[i][j].hbond);
-                  fprintf(fpo_helices,"vdws: %d\n",helix_pair[i][j].vdw);
-                  destroy_atom_atom(atom_atom, helix, i);
-               }
-            }
-         }
+   struct ENTRYSTATE state;
+   struct ENTRYSTATE *entry=&state;
+   struct ARENA *arena;
+   struct HELIX *helix;
+   struct ATOMSTORE *atoms;
+   struct CONTACTLIST *contacts;
+   struct PAIRSTORE *pair_store;
+   struct HELIXPAIR *helix_pair;
+   struct CELLGRID *grid;
+   struct PAIRSCAN *scan;
+   int *candidate;
+   int i,j,k,t;
+   int status;
+   int threads_total;
+   int helices_total;
+   int candidates_total;
+   int helices_atom_total;
 
-         fprintf(fpo_helices,"\nPacked Helices: Angles & Distance of Closest Approach\n\n");
 
-         for(j=0;j<helices_total;j++)
-         {
-            for(i=0;i<=j;i++)             
-            {
-               if((helix_pair[i][j].packed==1) && (helix[i].residues_total>=4) && (helix[j].residues_total>=4))
-               {
-                  two_helix_all_vectors(i, j, helix, helix_pair);
-             
-                  two_helix_contact_vectors(i, j, helix, helix_pair);
+   memset(entry, 0, sizeof(struct ENTRYSTATE));
 
-                  fprintf(fpo_helices,"Helix %d & Helix %d\n",i,j);
-                  fprintf(fpo_helices,"Global Angle (from all vectors): %f degrees\nLocal Angle (from contact vectors): %f degrees\nInteraxial Distance: %f Angstroms\n\n",helix_pair[i][j].angle1,helix_pair[i][j].angle2,helix_pair[i][j].distance);
-               }
-            }
-         }
+   entry->outputs=context->outputs;
+   entry->compression=context->compression;
+   entry->verbose=context->verbose;
 
-         fprintf(fpo_helices,"\nAtomic List\n\n");
+   arena=context->arena;
+   threads_total=context->threads_total;
 
-         for(i=0;i<helices_total;i++)
-         {
-            for(j=0;j<helix[i].atoms_total;j++)
-            {
-               fprintf(fpo_helices,"atom: %d,%s  hbond donor: %d  charge: %d  residue: %s  residue number: %.2f  chain: %c\n",helix_atom[i][j].atom_number,helix_atom[i][j].atom_name,helix_atom[i][j].hdonor,helix_atom[i][j].charge,helix_atom[i][j].residue_name,helix_atom[i][j].residue_number,helix_atom[i][j].chain);
-            }
+   /* all the memory of the previous protein is given back in one go, by the threads' arenas too */
 
-            fprintf(fpo_helices,"\n");
-         }
+   for(t=0;t<threads_total;t++) arena_reset(context->thread_arena[t]);
 
-         fprintf(fpo_helices,"total number of helical atoms = %d\n\n",helices_atom_total);
+   clear_results(context);
 
-         fclose(fpo_helices);
+    // dmf 7.29.17 create the output filenames
+    create_filenames(pdb_id, entry);
+    
+// ** moved from above **
+    
+    // dmf 7.25.17 - want to modify output_packing to include identifying string.
+    // therefore, this statement needs to be moved to after file input, below.
+    if((status=open_output(entry, XHELIX_OUTPUT_PACKING, entry->output_packing, arena, &entry->fpo_packing))) return finish_entry(context, entry, status);
+    
+    write_output(entry->fpo_packing,"Protein\tHelix1\tHelix2\tCont 1\tCont 2\tGlobal Angle\tLocal Angle\tDistance\tCovalnt\tElectro\tH-Bond\tVDW\n");
+    
+    // dmf 7.25.17 - want to modify output_shape to include identifying string.
+    // therefore, this statement needs to be moved to after file input, below.
+    if((status=open_output(entry, XHELIX_OUTPUT_SHAPE, entry->output_shape, arena, &entry->fpo_shape))) return finish_entry(context, entry, status);
+    
+    write_output(entry->fpo_shape,"Protein\tChain\tHelix\tLength\tGeom\tMax Bending Angle\n");
+    
+// ** end of moved from above **
 
-         for(j=0;j<helices_total;j++)
-         {
-            for(i=0;i<=j;i++)             
-            {
-               if((helix_pair[i][j].packed==1) && (helix[i].residues_total>=4) && (helix[j].residues_total>=4))
-               {
-                  // output to "output_packing", file is already open with header text
-                  fprintf(fpo_packing,"%s\t%d\t%d\t%d\t%d\t",helix[i].pdb,helix[i].helix_no,helix[j].helix_no,helix_pair[i][j].h1_residues,helix_pair[i][j].h2_residues); 
-                  fprintf(fpo_packing,"%f\t%f\t%f\t",helix_pair[i][j].angle1,helix_pair[i][j].angle2,helix_pair[i][j].distance);
-                  fprintf(fpo_packing,"%d\t%d\t%d\t%d\n",helix_pair[i][j].covalent,helix_pair[i][j].electrostatic,helix_pair[i][j].hbond,helix_pair[i][j].vdw);
-               }
-            }      
-         }
+// dmf 7.25.17 - want to modify output_helices to include identifying string. 
+   if((status=open_output(entry, XHELIX_OUTPUT_HELICES, entry->output_helices, arena, &entry->fpo_helices))) return finish_entry(context, entry, status);
 
-         fclose(fpo_packing);
+   /* the files written helix by helix and pair by pair are opened here too, and written in the order they */
+   /* were before; there are no contacts in the C-alpha mode */
 
-         for(i=0;i<helices_total;i++)
-         {
-            // output to "output_shape", file is already open with header text
-            fprintf(fpo_shape,"%s\t%c\t%d\t%d\t",helix[i].pdb,helix[i].chain,helix[i].helix_no,helix[i].residues_total);
-            fprintf(fpo_shape,"%c\t%f\n",helix[i].geometry,helix[i].max_bending_angle);     
-         }      
+   if((status=open_output(entry, XHELIX_OUTPUT_AXIS, entry->output_axis, arena, &entry->fpo_axis))) return finish_entry(context, entry, status);
 
-         fclose(fpo_shape);
+   if((status=open_output(entry, XHELIX_OUTPUT_GEOM, entry->output_geom, arena, &entry->fpo_geom))) return finish_entry(context, entry, status);
 
-         printf("  Done\n");
+   if((status=open_output(entry, XHELIX_OUTPUT_PYMOL, entry->pymol_axis, arena, &entry->fpo_pyaxis))) return finish_entry(context, entry, status);
 
-         free(helix);
+   if((status=open_output(entry, XHELIX_OUTPUT_CGO, entry->pymol_cgo, arena, &entry->fpo_cgo))) return finish_entry(context, entry, status);
 
-         destroy_helix_atom(helix_atom, &helices_total);
+   /* the CGO script has a list of cylinders for the helix axes, then one for the contact vectors, each loaded */
+   /* by a single call; the cylinders are drawn as the axis.py distances are, 0.40 wide in 0xffcc00 */
 
-         destroy_helix_pair(helix_pair, &helices_total);
-          
-         // add tail information to axis.py
-         // dmf 7.25.17 - want to modify pymol_axis to include identifying string
-         // dmf 7.27.17 note that this file is opened and appended to in several different
-         // functions, so this "a+" is required here.
-         if((fpo_pyaxis=fopen(pymol_axis, "a+"))==NULL)
-         {
-            printf("\n\n** Error appending to file '%s'!",pymol_axis);
-            exit(1);
-         }
-         fprintf(fpo_pyaxis,"set dash_gap, 0, cont*\n");
-         fprintf(fpo_pyaxis,"set dash_radius, 0.40\n");
-         fprintf(fpo_pyaxis,"set dash_round_ends, 0\n");
-         fprintf(fpo_pyaxis,"set dash_color, 0xffcc00, dist*\n");
-         fprintf(fpo_pyaxis,"hide labels, dist*\n");
-         fclose(fpo_pyaxis);
+   write_output(entry->fpo_cgo,"# helix axes and contact vectors of %s as PyMOL CGO cylinders\n",pdb_id);
+   write_output(entry->fpo_cgo,"from pymol import cmd\nfrom pymol.cgo import CYLINDER\n\n");
+   write_output(entry->fpo_cgo,"s=[0.40, 1.0, 0.8, 0.0, 1.0, 0.8, 0.0]\n\naxes=[\n");
 
-      }
+   if(!context->ca_only && (status=open_output(entry, XHELIX_OUTPUT_CONTACT, entry->output_contact, arena, &entry->fpo_contact))) return finish_entry(context, entry, status);
+
+   /* in the C-alpha mode the DSSP file is all there is; without it the helices are assigned from the */
+   /* structure, as DSSP would assign them */
+
+   if(((dssp==NULL) && (context->ca_only || (pdb==NULL))) || ((pdb==NULL) && (!context->ca_only)))
+   {
+      return finish_entry(context, entry, entry_error(entry, XHELIX_ERROR_INPUT, "No %s input for %s", (dssp==NULL) ? "DSSP" : "structure", pdb_id));
    }
-// end of cathfile input read and process loop
-// ***** end of cath.txt read loop *****
-    
-   fclose(fpi_cath);
 
-   return 0;
-}
-// end of main();
+   if(dssp!=NULL)
+   {
+      helix=read_helices(dssp, &helices_total, pdb_id, context->ca_only, arena);
 
-/* ------------------------------------------------------------------------- */
-      
-/* Function to read DSSP file, get residues in helices, and initialise helix array */
-struct HELIX* read_helices(FILE *fpi_dssp, int *helices_total, char *pdb_id)
-{
-   /* Variables */
+      if(text_failed(dssp)) return finish_entry(context, entry, entry_error(entry, XHELIX_ERROR_INPUT, "Error decompressing the DSSP file of %s", pdb_id));
 
-   char line[DLINLEN];
-   struct HELIX *helix;
-   char res[7];
-   char res_sub_type;
-   float res_number;
-   float res_sub_number;
-   int g,h,i=0,j,k=0;
-   char previous_structure='Z';
-   char current_structure='X';
+      if((status=arena_error(entry, &arena, 1))) return finish_entry(context, entry, status);
+   }
+   else if((helix=assign_helices(pdb, &helices_total, pdb_id, arena))==NULL)
+   {
+      if((status=arena_error(entry, &arena, 1))) return finish_entry(context, entry, status);
+
+      if(text_failed(pdb)) return finish_entry(context, entry, entry_error(entry, XHELIX_ERROR_INPUT, "Error decompressing the PDB file of %s", pdb_id));
 
+      return finish_entry(context, entry, entry_error(entry, XHELIX_ERROR_INPUT, "Error in the binary structure file of %s", pdb_id));
+   }
 
-   helix=(struct HELIX *) calloc(MAXHELICES,sizeof(struct HELIX));
+   if(context->ca_only)
+   {
+      /* the C-alphas came with the helices, and no atoms are read: the helices are shaped and their */
+      /* neighbours found as usual, but there are no contacts and so no packed pairs */
 
-   /* fill the array of the structure HELIX with junk for debugging */ 
+      atoms=NULL;
+      grid=NULL;
+      helices_atom_total=0;
 
-   for (g=0; g<MAXHELICES; g++)
+      for(i=0;i<helices_total;i++) helix[i].atoms_total=0;
+   }
+   else
    {
-      helix[g].residues_total=-1;
-      helix[g].helix_no=-1;
-      helix[g].atoms_total=-1;
-      helix[g].max_bending_angle=0;
-      helix[g].chain='Z';
-      helix[g].geometry='S';
+      /* the structure may come as a PDB, an mmCIF or a binary file */
 
-      for (h=0; h<MAXRESIDUES; h++)
-      {
-         helix[g].residues[h]='Z';
-         helix[g].residue_numbers[h]=-1;
-         helix[g].ca_coord[h][0]=-9999;
-         helix[g].ca_coord[h][1]=-9999;
-         helix[g].ca_coord[h][2]=-9999;
-      }
-      helix[g].residues[h+1]='\0';
+      if(binary_text(pdb)) atoms=read_binary_atoms(pdb, helix, &helices_total, &helices_atom_total, arena);
+      else if(cif_text(pdb)) atoms=read_cif_atoms(pdb, helix, &helices_total, &helices_atom_total, arena);
+      else atoms=read_atom(pdb, helix, &helices_total, &helices_atom_total, arena);
 
-      for (h=0; h<MAXRESIDUES-3; h++)
-      {
-         helix[g].unit_local_axis[h][0]=-1;    
-         helix[g].unit_local_axis[h][1]=-1;    
-         helix[g].unit_local_axis[h][2]=-1;
-      }
+      if(text_failed(pdb)) return finish_entry(context, entry, entry_error(entry, XHELIX_ERROR_INPUT, "Error decompressing the PDB file of %s", pdb_id));
 
-      for (h=0; h<MAXRESIDUES-2; h++)
-      {
-         helix[g].origin[h][0]=-1;
-         helix[g].origin[h][1]=-1;
-         helix[g].origin[h][2]=-1; 
-      }
+      if((status=arena_error(entry, &arena, 1))) return finish_entry(context, entry, status);
 
-      for (h=0; h<MAXRESIDUES/3; h++)
-      {
-         helix[g].bending_angle[h]=-1;
-      }         
-   }
+      if(atoms==NULL) return finish_entry(context, entry, entry_error(entry, XHELIX_ERROR_INPUT, "Error in the binary structure file of %s", pdb_id));
 
-   /* start getting the dssp file line by line, and get to important bit */
+      if((status=get_ca_coords(helix, atoms, &helices_total, entry))) return finish_entry(context, entry, status);
 
-   do
-   {
-      fgets(line, DLINLEN, fpi_dssp); 
+      if((grid=make_cell_grid(helix, atoms, &helices_total, arena))==NULL) return finish_entry(context, entry, arena_error(entry, &arena, 1));
    }
-   while(!feof(fpi_dssp) && line[2]!='#');
-  
-   /* i is number of helices */
-   /* k is number of residues in each helix */
 
-   while(!feof(fpi_dssp))
+   if((contacts=make_contact_list(arena))==NULL) return finish_entry(context, entry, arena_error(entry, &arena, 1));
+
+   for(i=0;i<helices_total;i++)
    {
-      fgets(line, DLINLEN, fpi_dssp);
-  
-      if(line[strlen(line)-1]=='\n') line[strlen(line)-1]='\0';
+      if((status=get_local_axis(i, helix, entry))) return finish_entry(context, entry, status);
 
-      if(line[13]!='!')
-      {
-         if(line[11]==' ') line[11]='0';
+      sum_axes(i, helix);
+
+      if((status=get_bending_angle(i, helix, entry))) return finish_entry(context, entry, status);
  
-         for(j=0; j<6; j++) res[j]=line[j+5];  
-         res[6]='\0';
-        
-         /* get residue number, e.g. residue 10 becomes 10.00 */
+      if((status=fit(i, helix, arena, entry))) return finish_entry(context, entry, status);
+   } 
 
-         res_number=atof(res);
-       
-         res_sub_type=' ';
-         res_sub_number=0.0;
+   write_output(entry->fpo_cgo,"]\n\ncmd.load_cgo(axes, \"%s_axes\")\n\ncontacts=[\n",pdb_id);
 
-         /* get residue sub-label if it exists */
+   for(i=0;i<helices_total;i++)
+   {
+      write_output(entry->fpo_helices,"protein: %s, chain: %c, helix: %d, start residue: %.2f, last residue: %.2f\n",helix[i].pdb,helix[i].chain,helix[i].helix_no,helix[i].residue_numbers[0],helix[i].residue_numbers[helix[i].residues_total-1]);
+      write_output(entry->fpo_helices,"number of residues: %d, sequence: %s\n",helix[i].residues_total,helix[i].residues);
+      write_output(entry->fpo_helices,"maximum bending angle: %f degrees, overall geometry: %c\n\n",helix[i].max_bending_angle,helix[i].geometry);
+   }
 
-         if(line[10]!=' ' && line[10]!='0' && line[10]!='1' && line[10]!='2' && line[10]!='3' && line[10]!='4' && line[10]!='5' && line[10]!='6' && line[10]!='7' && line[10]!='8' && line[10]!='9')
-         {
-            res_sub_type=line[10];
-            res_sub_number=res_sub_type-64;
-            res_sub_number=res_sub_number/100;
-         }
+   write_output(entry->fpo_helices,"Total Number of Helices = %d\n\n",helices_total);
 
-         /* this has converted residue 1A into 1.01, residue 2B into 2.02 etc. */
+   if((pair_store=neighbours(arena))==NULL) return finish_entry(context, entry, arena_error(entry, &arena, 1));
 
-         res_number+=res_sub_number;
+   if((candidate=helix_candidates(helix, &helices_total, &candidates_total, arena))==NULL) return finish_entry(context, entry, arena_error(entry, &arena, 1));
 
-         current_structure=line[16];    /* update current secondary structure type */
+   /* the neighbour tests and then the contact scans of the neighbours are shared out among the threads, */
+   /* their results are merged in pair order so that the output does not depend on the number of threads */
 
+   if((scan=make_pair_scan(helix, atoms, grid, pair_store, candidate, candidates_total, threads_total, context->thread_arena))==NULL)
+   {
+      return finish_entry(context, entry, arena_error(entry, context->thread_arena, threads_total));
+   }
 
-         if(current_structure=='I' || current_structure=='G' || current_structure=='H')    /* if secondary structure of this line is a helix... */
-         {
-            strcpy(helix[i].pdb,pdb_id);
+   run_tasks(candidates_total, threads_total, neighbour_task, scan);
 
-            helix[i].chain=line[11];
-                  
-            helix[i].residue_numbers[k]=res_number;
-         
-            helix[i].residues[k]=line[13];
-            helix[i].residues[k+1]='\0'; 
+   for(k=0;k<candidates_total;k++)
+   {
+      if(!scan->neighbour[k]) continue;
 
-            /* and increment k (the helix residue number) for the next residue of existing helix */
+      if((helix_pair=add_pair(pair_store, candidate[2*k], candidate[2*k+1]))==NULL) return finish_entry(context, entry, arena_error(entry, &arena, 1));
 
-            k++;
-       
-            if(k==MAXRESIDUES)
-            {
-               printf("\n\nMaximum helix residue number has been reached for helix %d\n",i);
-               exit(1);
-            }
-         }
+      helix_pair->neighbours=1;
+   }
 
-         /* if secondary structure of this line is not a helix and the structure from */
-         /* the previous line was... then assume end of helix and reset k (helix residue number) */
-         /* and increment i (the helix number) in preparation for start of next helix. */
+   make_tiles(scan);
 
-         else if((current_structure!='I' || current_structure!='G' || current_structure!='H') && (previous_structure=='I' || previous_structure=='G' || previous_structure=='H'))
-         {
-            helix[i].residues_total=k;
+   if((status=arena_error(entry, &arena, 1))) return finish_entry(context, entry, status);
 
-            helix[i].helix_no=i;
+   /* a thread whose arena ran out went on without the contact lists, which are not used once it has */
 
-            k=0;
+   run_tasks(scan->tiles_total, threads_total, tile_task, scan);
 
-            i++;        
+   if((status=arena_error(entry, context->thread_arena, threads_total))) return finish_entry(context, entry, status);
 
-            if(i==MAXHELICES)
-            {
-               printf("\n\nMaximum number of helices allowed has been reached\n");
-               exit(1);
-            }
-         }
+   write_output(entry->fpo_helices,"Neighbouring Helices\n\n");
 
-         previous_structure=current_structure;         
+   k=0;
+   t=0;
+
+   for(j=0;j<helices_total;j++)
+   {
+      if(entry->verbose==XHELIX_VERBOSE_PROGRESS)
+      {
+         printf(".");
+         fflush(stdout);
       }
 
-      else if((line[13]=='!') && (previous_structure=='I' || previous_structure=='G' || previous_structure=='H'))
+      /* only the helix pairs with overlapping capsules can be neighbours */
+
+      for(;(k<candidates_total) && (candidate[2*k+1]==j);k++)
       {
-         previous_structure='Z';
-         current_structure='X';
+         i=candidate[2*k];
+
+         if(((helix_pair=find_pair(pair_store, i, j))!=NULL) && (atoms==NULL))
+         {
+            write_output(entry->fpo_helices,"helix %d & helix %d  neighbours: %d\n",helix_pair->helix_one,helix_pair->helix_two,helix_pair->neighbours);
+         }
+         else if(helix_pair!=NULL)
+         {
+            t=merge_tiles(scan, t, helix_pair, contacts);
+
+            if((status=arena_error(entry, &arena, 1))) return finish_entry(context, entry, status);
+
+            if((status=atom_distance(i, j, helix, atoms, contacts, helix_pair, entry))) return finish_entry(context, entry, status);
+
+            write_output(entry->fpo_helices,"helix %d & ",helix_pair->helix_one);
+            write_output(entry->fpo_helices,"helix %d  ",helix_pair->helix_two);
+            write_output(entry->fpo_helices,"neighbours: %d  ",helix_pair->neighbours);
+            write_output(entry->fpo_helices,"packed: %d  ",helix_pair->packed);
+            write_output(entry->fpo_helices,"helix %d contact residues: %d  ",helix_pair->helix_one,helix_pair->h1_residues);
+            write_output(entry->fpo_helices,"helix %d contact residues: %d  ",helix_pair->helix_two,helix_pair->h2_residues);
+            write_output(entry->fpo_helices,"helix %d first contact residue: %d  ",helix_pair->helix_one,helix_pair->h1_start);
+            write_output(entry->fpo_helices,"last contact residue: %d  ",helix_pair->h1_end);
+            write_output(entry->fpo_helices,"helix %d first contact residue: %d  ",helix_pair->helix_two,helix_pair->h2_start);
+            write_output(entry->fpo_helices,"last contact residue: %d  ",helix_pair->h2_end);
+            write_output(entry->fpo_helices,"covalents: %d  ",helix_pair->covalent);
+            write_output(entry->fpo_helices,"electrostatics: %d  ",helix_pair->electrostatic);
+            write_output(entry->fpo_helices,"hbonds: %d  ",helix_pair->hbond);
+            write_output(entry->fpo_helices,"vdws: %d\n",helix_pair->vdw);
+         }
+      }
+   }
 
-         helix[i].residues_total=k;
+   /* with C-alphas alone the global angle is given for every pair of neighbours instead */
 
-         helix[i].helix_no=i;
+   if(atoms==NULL)
+   {
+      write_output(entry->fpo_helices,"\nNeighbouring Helices: Angles from C-alphas\n\n");
 
-         k=0;
+      for(k=0;k<pair_store->pairs_total;k++)
+      {
+         helix_pair=&pair_store->pair[k];
 
-         i++;
+         i=helix_pair->helix_one;
+         j=helix_pair->helix_two;
 
-         if(i==MAXHELICES)
+         if((helix[i].residues_total>=4) && (helix[j].residues_total>=4))
          {
-            printf("\n\nMaximum number of helices allowed has been reached\n");
-            exit(1);
+            if((status=two_helix_all_vectors(i, j, helix, helix_pair, entry))) return finish_entry(context, entry, status);
+
+            write_output(entry->fpo_helices,"Helix %d & Helix %d\n",i,j);
+            write_output(entry->fpo_helices,"Global Angle (from all vectors): %f degrees\n\n",helix_pair->angle1);
          }
-      }                     
+      }
    }
 
-   *helices_total=i;
+   write_output(entry->fpo_helices,"\nPacked Helices: Angles & Distance of Closest Approach\n\n");
 
-   return helix;
-}
+   for(k=0;k<pair_store->pairs_total;k++)
+   {
+      helix_pair=&pair_store->pair[k];
 
-/* ------------------------------------------------------------------------- */
+      i=helix_pair->helix_one;
+      j=helix_pair->helix_two;
 
-/* Function to read PDB file and get atom details if they are in the DSSP defined helices */
-struct ATOM** read_atom(FILE *fpi_pdb, struct HELIX *helix, int *helices_total, int *helices_atom_total)
-{
-   /* Variables */
+      if((helix_pair->packed==1) && (helix[i].residues_total>=4) && (helix[j].residues_total>=4))
+      {
+         if((status=two_helix_all_vectors(i, j, helix, helix_pair, entry))) return finish_entry(context, entry, status);
+       
+         if((status=two_helix_contact_vectors(i, j, helix, helix_pair, entry))) return finish_entry(context, entry, status);
 
-   struct ATOM **helix_atom;
-   char line[LINLEN];
-//   char coord[9];
-// dmf 6.27.17
-   char coord[10];
-   char resseq[6];
-   char resname[4];
-   char chain;
-   char res_sub_type;
-   float res_sub_number;
-   float current_residue_number=-1.5;
-   float last_residue_in_helix=-1.5;
-   char number[6];
-   int g,h,i=0,j=0,k,l,m=0,n=0;
-
-
-   /* Allocate the memory for the 2d array dynamically
-   *
-   * -- max atoms per helix (1000-2000)-->
-   *        |
-   *  number of helices
-   *        \/
-   */
- 
-   helix_atom = (struct ATOM **) calloc(*helices_total,sizeof(struct ATOM*));
-   
-   for(k=0; k<*helices_total; k++)
-   {
-      helix_atom[k] = (struct ATOM *) calloc(MAXHELIXATOMS,sizeof(struct ATOM));
+         write_output(entry->fpo_helices,"Helix %d & Helix %d\n",i,j);
+         write_output(entry->fpo_helices,"Global Angle (from all vectors): %f degrees\nLocal Angle (from contact vectors): %f degrees\nInteraxial Distance: %f Angstroms\n\n",helix_pair->angle1,helix_pair->angle2,helix_pair->distance);
+      }
    }
 
-   /* fill all atom and residue numbers in entire 2-D array with junk */
+   write_output(entry->fpo_helices,"\nAtomic List\n\n");
 
-   for(g=0; g<*helices_total; g++)
+   for(i=0;(atoms!=NULL) && (entry->fpo_helices!=NULL) && (i<helices_total);i++)
    {
-      for(h=0; h<MAXHELIXATOMS; h++)
-      {            
-         helix_atom[g][h].atom_number=-1;
-         helix_atom[g][h].residue_number=-1;
-         helix_atom[g][h].chain='Z';
-         helix_atom[g][h].atom_coord[0]=-9999;
-         helix_atom[g][h].atom_coord[1]=-9999;
-         helix_atom[g][h].atom_coord[2]=-9999;
-         helix_atom[g][h].hdonor=0;
-         helix_atom[g][h].charge=0;
-      }   
+      for(j=atoms->helix_start[i];j<atoms->helix_start[i]+helix[i].atoms_total;j++)
+      {
+         write_output(entry->fpo_helices,"atom: %d,%s  hbond donor: %d  charge: %d  residue: %s  residue number: %.2f  chain: %c\n",atoms->atom_number[j],atoms->atom_name[j],atoms->hdonor[j],atoms->charge[j],atoms->residue_name[j],atoms->residue_number[j],atoms->chain[j]);
+      }
+
+      write_output(entry->fpo_helices,"\n");
    }
 
-   /* Read input file until all helices are completed */
+   write_output(entry->fpo_helices,"total number of helical atoms = %d\n\n",helices_atom_total);
 
-   while(!feof(fpi_pdb) && strncmp(line,"END",3))
+   for(k=0;k<pair_store->pairs_total;k++)
    {
-      fgets(line, LINLEN, fpi_pdb);
-
-      if(line[strlen(line)-1]=='\n') line[strlen(line)-1]='\0';
+      helix_pair=&pair_store->pair[k];
 
-      /* If record name is ATOM or HETATM and the atom name is not H ... */
+      i=helix_pair->helix_one;
+      j=helix_pair->helix_two;
 
-      if((line[13]!='H') && (!strncmp(line,"ATOM  ",6) || !strncmp(line,"HETATM",6)))
+      if((helix_pair->packed==1) && (helix[i].residues_total>=4) && (helix[j].residues_total>=4))
       {
-         if(line[21]==' ') line[21]='0';
-         chain=line[21];
+         // output to "output_packing", file is already open with header text
+         write_output(entry->fpo_packing,"%s\t%d\t%d\t%d\t%d\t",helix[i].pdb,helix[i].helix_no,helix[j].helix_no,helix_pair->h1_residues,helix_pair->h2_residues); 
+         write_output(entry->fpo_packing,"%f\t%f\t%f\t",helix_pair->angle1,helix_pair->angle2,helix_pair->distance);
+         write_output(entry->fpo_packing,"%d\t%d\t%d\t%d\n",helix_pair->covalent,helix_pair->electrostatic,helix_pair->hbond,helix_pair->vdw);
+      }
+   }
 
-         for(k=0;k<3;k++) resname[k]=line[k+17];	
-         resname[3]='\0';
+   for(i=0;i<helices_total;i++)
+   {
+      // output to "output_shape", file is already open with header text
+      write_output(entry->fpo_shape,"%s\t%c\t%d\t%d\t",helix[i].pdb,helix[i].chain,helix[i].helix_no,helix[i].residues_total);
+      write_output(entry->fpo_shape,"%c\t%f\n",helix[i].geometry,helix[i].max_bending_angle);     
+   }      
 
-         /* if the chain is right and the residue is not a water molecule */
+   if(entry->verbose==XHELIX_VERBOSE_PROGRESS) printf("  Done\n");
+   else if(entry->verbose==XHELIX_VERBOSE_LINES) printf("Analysis of %s done\n",pdb_id);
+    
+   // add tail information to axis.py
+   write_output(entry->fpo_pyaxis,"set dash_gap, 0, cont*\n");
+   write_output(entry->fpo_pyaxis,"set dash_radius, 0.40\n");
+   write_output(entry->fpo_pyaxis,"set dash_round_ends, 0\n");
+   write_output(entry->fpo_pyaxis,"set dash_color, 0xffcc00, dist*\n");
+   write_output(entry->fpo_pyaxis,"hide labels, dist*\n");
 
-         if((chain==helix[i].chain) && (strcmp(resname,"HOH")))        
-         {
-            /* current residue number from PDB atom list */
-            /* e.g. residue 1 becomes 1.00 */
+   write_output(entry->fpo_cgo,"]\n\ncmd.load_cgo(contacts, \"%s_contacts\")\n",pdb_id);
 
-            for(k=0;k<5;k++) resseq[k]=line[k+22];
-	
-            resseq[5]='\0';
-            current_residue_number=atof(resseq);
+   if(keep_results(context, helix, helices_total, pair_store)) return finish_entry(context, entry, arena_error(entry, &arena, 1));
 
-            res_sub_type=' ';
-            res_sub_number=0.0;
+   return finish_entry(context, entry, XHELIX_OK);
+}
 
-            /* get residue sub-label if it exists */
+/* ------------------------------------------------------------------------- */
 
-            if(line[26]!=' ' && line[26]!='0' && line[26]!='1' && line[26]!='2' && line[26]!='3' && line[26]!='4' && line[26]!='5' && line[26]!='6' && line[26]!='7' && line[26]!='8' && line[26]!='9') 
-            {
-               res_sub_type=line[26];
-               res_sub_number=res_sub_type-64;
-               res_sub_number=res_sub_number/100;
-            }
+/* Function to close the output files of an entry and pass its status, and any message, back to the context */
+int finish_entry(struct XHELIX *context, struct ENTRYSTATE *entry, int status)
+{
+   close_output(entry->fpo_helices);
+   close_output(entry->fpo_packing);
+   close_output(entry->fpo_shape);
+   close_output(entry->fpo_axis);
+   close_output(entry->fpo_geom);
+   close_output(entry->fpo_contact);
+   close_output(entry->fpo_pyaxis);
+   close_output(entry->fpo_cgo);
 
-            /* this has converted residue 1A into 1.01, residue 1Z into 1.26 etc. */
+   /* the compressing threads end once the files have been closed, and all of them written */
 
-            current_residue_number+=res_sub_number;
+   status=close_deflaters(entry, status);
 
-            /* For within a helix, where j (helix residue number) must be incremented before assignments to atom variables are made */
+   if(status!=XHELIX_OK) strcpy(context->message, entry->message);
 
-            if((current_residue_number==helix[i].residue_numbers[j+1]) && (last_residue_in_helix==helix[i].residue_numbers[j]))
-            {
-               j++;
-            }
+   return status;
+}
 
-            /* For start or within helix, where PDB residue number equals helix residue number */
+/* ------------------------------------------------------------------------- */
 
-            if(current_residue_number==helix[i].residue_numbers[j])
-            {
-               /* atom_number */
+/* Function to copy the helices and helix pairs of an entry into the result records of the context. Returns 0, */
+/* or -1 if there is no memory for them */
+int keep_results(struct XHELIX *context, struct HELIX *helix, int helices_total, struct PAIRSTORE *pair_store)
+{
+   /* Variables */
 
-               for(k=0;k<5;k++) number[k]=line[k+6];
-    
-               number[5]='\0';
-               helix_atom[i][m].atom_number=atoi(number);
-	
-               /* atom name */
+   struct XHELIX_HELIX *result;
+   struct XHELIX_PAIR *pair_result;
+   struct HELIXPAIR *helix_pair;
+   int i,k;
 
-               for(k=0;k<4;k++) helix_atom[i][m].atom_name[k]=line[k+12];
-	
-               helix_atom[i][m].atom_name[4]='\0';
 
-               /* residue name */
-        
-               strcpy(helix_atom[i][m].residue_name,resname);
+   result=(struct XHELIX_HELIX *) arena_alloc(context->arena,(helices_total+1)*sizeof(struct XHELIX_HELIX));
+   pair_result=(struct XHELIX_PAIR *) arena_alloc(context->arena,(pair_store->pairs_total+1)*sizeof(struct XHELIX_PAIR));
 
-               /* chain */
+   if((result==NULL) || (pair_result==NULL)) return -1;
 
-               helix_atom[i][m].chain=chain;
-                  	
-               /* residue number */
+   for(i=0;i<helices_total;i++)
+   {
+      strcpy(result[i].pdb,helix[i].pdb);
+      result[i].chain=helix[i].chain;
+      result[i].helix_no=helix[i].helix_no;
+      result[i].residues_total=helix[i].residues_total;
+      result[i].residues=helix[i].residues;
+      result[i].residue_numbers=helix[i].residue_numbers;
+      result[i].atoms_total=helix[i].atoms_total;
+      result[i].geometry=helix[i].geometry;
+      result[i].max_bending_angle=helix[i].max_bending_angle;
+
+      if(helix[i].residues_total>=4)
+      {
+         result[i].axes_total=helix[i].residues_total-3;
+         result[i].axis=(const double (*)[3]) helix[i].unit_local_axis;
+         result[i].origin=(const double (*)[3]) helix[i].origin;
+      }
 
-               helix_atom[i][m].residue_number=current_residue_number;
+      /* one bending angle for every third axis but the last three */
 
-               /* co-ordinates */
+      if(helix[i].residues_total>=7)
+      {
+         result[i].bending_angles_total=(helix[i].residues_total-4)/3;
+         result[i].bending_angle=helix[i].bending_angle;
+      }
+   }
 
-               k=30;
-              
-               for(g=0;g<3;g++)
-               {
+   for(k=0;k<pair_store->pairs_total;k++)
+   {
+      helix_pair=&pair_store->pair[k];
+
+      pair_result[k].helix_one=helix_pair->helix_one;
+      pair_result[k].helix_two=helix_pair->helix_two;
+      pair_result[k].packed=helix_pair->packed;
+      pair_result[k].h1_residues=helix_pair->h1_residues;
+      pair_result[k].h2_residues=helix_pair->h2_residues;
+      pair_result[k].h1_start=helix_pair->h1_start;
+      pair_result[k].h1_end=helix_pair->h1_end;
+      pair_result[k].h2_start=helix_pair->h2_start;
+      pair_result[k].h2_end=helix_pair->h2_end;
+      pair_result[k].covalent=helix_pair->covalent;
+      pair_result[k].electrostatic=helix_pair->electrostatic;
+      pair_result[k].hbond=helix_pair->hbond;
+      pair_result[k].vdw=helix_pair->vdw;
+      pair_result[k].angle1=helix_pair->angle1;
+      pair_result[k].angle2=helix_pair->angle2;
+      pair_result[k].distance=helix_pair->distance;
+   }
 
-                  for(h=0;h<9;h++) coord[h]=line[h+k];
-               
-                  coord[9]='\0';
-               
-                  helix_atom[i][m].atom_coord[g]=atof(coord);
+   context->helix=result;
+   context->helices_total=helices_total;
+   context->pair=pair_result;
+   context->pairs_total=pair_store->pairs_total;
 
-                  k=k+8;
-               }
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
 
-               last_residue_in_helix=current_residue_number; /* update last residue number in helix */
+/* Function to let go of the results of the last entry, and its message, before the next one is analysed */
+void clear_results(struct XHELIX *context)
+{
+   context->helix=NULL;
+   context->helices_total=0;
+   context->pair=NULL;
+   context->pairs_total=0;
+   context->message[0]='\0';
+}
 
-               m++;    /* m represents total atoms in a helix */
+/* ------------------------------------------------------------------------- */
 
-               n++;    /* n represents total atoms in all helices */
-            }
+/* Function to set up the contact cutoffs and the distance and hydrogen bond kernels, once for the whole process */
+void init_kernels(void)
+{
+   make_cutoffs();
+   choose_distance_kernel();
+   choose_hbond_kernel();
+}
 
-            /* for a search for the start of another helix */ 
+/* ------------------------------------------------------------------------- */
 
-            if((current_residue_number!=helix[i].residue_numbers[j]) && (last_residue_in_helix==helix[i].residue_numbers[j]))
-            {
-               j++;
-            }
+/* Function to generate an analysis context, NULL if there is no memory for it */
+struct XHELIX* xhelix_create(void)
+{
+   /* Variables */
 
-            /* when a helix is at an end */
+   struct XHELIX *context;
 
-            if(j==helix[i].residues_total)
-            {
-               helix[i].atoms_total=m;
-               i++;
-               j=0;  
-               m=0; 
-            }
 
-            /* when all helices are completed */
+   pthread_once(&kernels_once, init_kernels);
 
-            if(i==*helices_total)
-            {
-               break;
-            }            
-         }
-      }
+   if((context=(struct XHELIX *) calloc(1,sizeof(struct XHELIX)))==NULL) return NULL;
+
+   if((context->arena=make_arena())==NULL)
+   {
+      free(context);
+      return NULL;
+   }
+
+   if((context->thread_arena=(struct ARENA **) malloc(sizeof(struct ARENA *)))==NULL)
+   {
+      destroy_arena(context->arena);
+      free(context);
+      return NULL;
    }
 
-  *helices_atom_total=n;        
+   context->thread_arena[0]=context->arena;
+   context->threads_total=1;
+   context->outputs=XHELIX_OUTPUT_NONE;
 
-  return helix_atom;
+   return context;
 }
 
 /* ------------------------------------------------------------------------- */
 
-/* Function to update ATOM structures in the helix_atom 2-D array with hydrogen bond donor and electrostatic info */
-void get_atom_info(struct ATOM **helix_atom, struct HELIX *helix, int *helices_total)
+/* Free up the context, and the results held in it */
+void xhelix_destroy(struct XHELIX *context)
 {
    /* Variables */
 
-   int i,j,k,l;
-   FILE *fp;            // dmf 7.27.17 - leave as fp
-   char line[LINLEN];
-   char residue[4];
-   char atom[5];
-   char hbond[2];
-   char electro[2];
-   int hbond_donor;
-   int electrostatic;
+   int t;
 
 
-   if((fp=fopen("translation.txt","r")) == NULL)
-   {
-      printf("\n\nError opening translation.txt\n");
-      exit(1);
-   }
-  
-   while(!feof(fp))
-   {
-      fgets(line,LINLEN,fp);
+   if(context==NULL) return;
 
-      if(line[strlen(line)-1]=='\n') line[strlen(line)-1]='\0';
-    
-      for(k=0;k<3;k++) residue[k]=line[k];
-      residue[3]='\0';
-    
-      for(l=0;l<4;l++) atom[l]=line[4+l];     
-      atom[4]='\0';
-    
-      hbond[0]=line[9];                      
-      hbond[1]='\0';
-      hbond_donor=atoi(hbond);
-       
-      electro[0]=line[11];                   
-      electro[1]='\0';
-      electrostatic=atoi(electro);
-     
-      for(i=0;i<*helices_total;i++)
-      {
-         for(j=0;j<helix[i].atoms_total;j++)
-         {
-            if((!strcmp(residue,helix_atom[i][j].residue_name)) && (!strcmp(atom,helix_atom[i][j].atom_name)))
-            {
-               helix_atom[i][j].hdonor=hbond_donor;
-               helix_atom[i][j].charge=electrostatic;
-            }
-         }
-      }
-   }
-// printf("\n\nresidue %s, atom %s, hbond %d, charge %d\n",residue,atom,hbond_donor,electrostatic);
+   for(t=1;t<context->threads_total;t++) destroy_arena(context->thread_arena[t]);
 
-   fclose(fp);
+   free(context->thread_arena);
+   destroy_arena(context->arena);
+   free(context);
 }
 
 /* ------------------------------------------------------------------------- */
 
-/* Little function to get CA co-ordinates from one structure to another */
-void get_ca_coords(struct HELIX *helix, struct ATOM **helix_atom, int *helices_total)
-{  
+/* Function to set the number of threads sharing the helix pairs of each entry, each thread past the first */
+/* has an arena of its own for its contact lists; if they cannot all be made there are fewer threads */
+void xhelix_set_threads(struct XHELIX *context, int threads_total)
+{
    /* Variables */
 
-   int i,j,k;
-   float current_residue;
-   float previous_residue;
+   struct ARENA **thread_arena;
+   int t;
 
 
-   for (i=0;i<*helices_total;i++)
-   {
-      k=0;              /* set back to zero for new helix */
+   if(threads_total<1) threads_total=1;
 
-      previous_residue=-1.5;   /* reset for new helix */
+   for(t=threads_total;t<context->threads_total;t++) destroy_arena(context->thread_arena[t]);
 
-      for(j=0;j<helix[i].atoms_total;j++)
-      {
-         current_residue=helix_atom[i][j].residue_number;
+   if(threads_total<context->threads_total) context->threads_total=threads_total;
 
-         if((!strcmp(helix_atom[i][j].atom_name," CA ")) && (current_residue!=previous_residue))
-         {
-            helix[i].ca_coord[k][0]=helix_atom[i][j].atom_coord[0];
-            helix[i].ca_coord[k][1]=helix_atom[i][j].atom_coord[1];
-            helix[i].ca_coord[k][2]=helix_atom[i][j].atom_coord[2];
+   if((thread_arena=(struct ARENA **) realloc(context->thread_arena,threads_total*sizeof(struct ARENA *)))==NULL) return;
 
-            k++;        /* k is number of CA atoms */
+   context->thread_arena=thread_arena;
 
-            previous_residue=current_residue;
-         }
+   for(t=context->threads_total;(t<threads_total) && ((thread_arena[t]=make_arena())!=NULL);t++);
 
-         if(k==helix[i].residues_total+1)
-         {
-            printf("\n\n*** Maximum number of helix CA co-ordinates transferred ***\n");
-            exit(1);
-         }
-      }
-   }
+   context->threads_total=t;
 }
 
 /* ------------------------------------------------------------------------- */
 
-/* Function to get the unit local axes (upto 97 in a 100 residue helix) of a single helix */
-/* and then to get the local helix origins (upto 98 in a 100 residue helix */
-void get_local_axis(int helix_number, struct HELIX *helix)
-{  
+/* Function to choose the output files written for each entry, as XHELIX_OUTPUT_ bits */
+void xhelix_set_outputs(struct XHELIX *context, int outputs)
+{
+   context->outputs=outputs & XHELIX_OUTPUT_ALL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to choose how the output files are compressed, as a XHELIX_COMPRESS_ type; returns XHELIX_ERROR_OUTPUT, */
+/* and leaves the setting as it was, for a type that was not built in */
+int xhelix_set_compression(struct XHELIX *context, int compression)
+{
+#ifndef HAVE_ZLIB
+   if(compression==XHELIX_COMPRESS_GZIP) return XHELIX_ERROR_OUTPUT;
+#endif
+#ifndef HAVE_ZSTD
+   if(compression==XHELIX_COMPRESS_ZSTD) return XHELIX_ERROR_OUTPUT;
+#endif
+   if((compression<XHELIX_COMPRESS_NONE) || (compression>XHELIX_COMPRESS_ZSTD)) return XHELIX_ERROR_OUTPUT;
+
+   context->compression=compression;
+
+   return XHELIX_OK;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to set the progress reports on stdout, XHELIX_VERBOSE_ or 0 for none */
+void xhelix_set_verbose(struct XHELIX *context, int verbose)
+{
+   context->verbose=verbose;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to turn the C-alpha mode on or off: the helix C-alphas are taken from the DSSP file and no */
+/* structure is read, so there are shapes, axes and neighbours but no atom contacts or packed pairs */
+void xhelix_set_ca_only(struct XHELIX *context, int ca_only)
+{
+   context->ca_only=(ca_only!=0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to analyse an entry from its DSSP and PDB files */
+int xhelix_analyse_files(struct XHELIX *context, const char *pdb_id, const char *dssp_file, const char *pdb_file)
+{
    /* Variables */
 
-   int i,j;
-   double vec12[3];
-   double vec23[3];
-   double vec34[3];
-   double dv13[3];
-   double dv24[3];
-   double cross_product[3];
-   double dot_product;
-   double mag_cross_product;
-   double dmag;
-   double emag;
-   double costheta;
-   double costheta1;
-   double radmag;
-   double rad[3];
-   FILE *fpo_axis;
+   FILE *fpi_dssp=NULL;
+   FILE *fpi_pdb=NULL;
+   int status;
 
-   i=helix_number;
 
-   if(i==0)
+   /* a failed analysis leaves no results, not those of the entry before */
+
+   clear_results(context);
+
+   if((dssp_file!=NULL) && ((fpi_dssp=fopen(dssp_file,"r"))==NULL))
    {
-// dmf 7.25.17 - want to modify output_axis to include identifying string. 
-      if((fpo_axis=fopen(output_axis, "w"))==NULL)
-      {
-         printf("\n\n** Error writing to file '%s'!",output_axis);
-         exit(1);
-      }
+      snprintf(context->message,MESSAGE_LENGTH,"Error opening %s",dssp_file);
+      return XHELIX_ERROR_INPUT;
    }
-   else   
+
+   if((pdb_file!=NULL) && ((fpi_pdb=fopen(pdb_file,"r"))==NULL))
    {
-// dmf 7.25.17 - want to modify output_axis to include identifying string. 
-      if((fpo_axis=fopen(output_axis, "a+"))==NULL)
-      {
-         printf("\n\n** Error appending to file '%s'!",output_axis);
-         exit(1);
-      }
+      if(fpi_dssp!=NULL) fclose(fpi_dssp);
+      snprintf(context->message,MESSAGE_LENGTH,"Error opening %s",pdb_file);
+      return XHELIX_ERROR_INPUT;
    }
-    
-   fprintf(fpo_axis,"Helix Number %d\n\n",i);
 
-// dmf 6.27.17 need to start assembling the PyMol script file here...
-    
-   if(helix[i].residues_total>=4)
+   status=xhelix_analyse_streams(context, pdb_id, fpi_dssp, fpi_pdb);
+
+   if(fpi_dssp!=NULL) fclose(fpi_dssp);
+   if(fpi_pdb!=NULL) fclose(fpi_pdb);
+
+   return status;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to analyse an entry read from open DSSP and PDB streams, which are left open */
+int xhelix_analyse_streams(struct XHELIX *context, const char *pdb_id, FILE *fpi_dssp, FILE *fpi_pdb)
+{
+   /* Variables */
+
+   struct TEXTINPUT dssp;
+   struct TEXTINPUT pdb;
+   char id[5];
+   int status;
+
+
+   /* the PDB code is four characters, as in the input list of x-helix */
+
+   strncpy(id,pdb_id,4);
+   id[4]='\0';
+
+   clear_results(context);
+
+   memset(&dssp, 0, sizeof(struct TEXTINPUT));
+
+   if((fpi_dssp!=NULL) && open_text(&dssp, fpi_dssp))
    {
-      for(j=0;j<helix[i].residues_total-3;j++)
-      {
-         /* get 4 consecutive CA atoms */
-         /* j = CA atom number */
-         /* [0] = X-axis, [1] = Y-axis, [2] = Z-axis */
-         /* vectors joining CA atoms */
+      snprintf(context->message,MESSAGE_LENGTH,"Error reading the DSSP file of %s",id);
+      return XHELIX_ERROR_INPUT;
+   }
 
-         if(helix[i].ca_coord[j][0]==-9999 || helix[i].ca_coord[j][1]==-9999 || helix[i].ca_coord[j][2]==-9999 || helix[i].ca_coord[j+1][0]==-9999 || helix[i].ca_coord[j+1][1]==-9999 || helix[i].ca_coord[j+1][2]==-9999 || helix[i].ca_coord[j+2][0]==-9999 || helix[i].ca_coord[j+2][1]==-9999 || helix[i].ca_coord[j+2][2]==-9999 || helix[i].ca_coord[j+3][0]==-9999 || helix[i].ca_coord[j+3][1]==-9999 || helix[i].ca_coord[j+3][2]==-9999)
-         {
-            printf("\n\n** error - c-alpha atom limit breached in vector analysis\n");
-            exit(1);
-         }
+   memset(&pdb, 0, sizeof(struct TEXTINPUT));
 
-         vec12[0]=helix[i].ca_coord[j+1][0] - helix[i].ca_coord[j][0];
-         vec12[1]=helix[i].ca_coord[j+1][1] - helix[i].ca_coord[j][1];
-         vec12[2]=helix[i].ca_coord[j+1][2] - helix[i].ca_coord[j][2];
+   if((fpi_pdb!=NULL) && open_text(&pdb, fpi_pdb))
+   {
+      close_text(&dssp);
+      snprintf(context->message,MESSAGE_LENGTH,"Error reading the PDB file of %s",id);
+      return XHELIX_ERROR_INPUT;
+   }
 
-         vec23[0]=helix[i].ca_coord[j+2][0] - helix[i].ca_coord[j+1][0];
-         vec23[1]=helix[i].ca_coord[j+2][1] - helix[i].ca_coord[j+1][1];
-         vec23[2]=helix[i].ca_coord[j+2][2] - helix[i].ca_coord[j+1][2];
+   status=analyse_entry(context, id, (fpi_dssp!=NULL) ? &dssp : NULL, (fpi_pdb!=NULL) ? &pdb : NULL);
 
-         vec34[0]=helix[i].ca_coord[j+3][0] - helix[i].ca_coord[j+2][0];
-         vec34[1]=helix[i].ca_coord[j+3][1] - helix[i].ca_coord[j+2][1];
-         vec34[2]=helix[i].ca_coord[j+3][2] - helix[i].ca_coord[j+2][2];
+   close_text(&dssp);
+   close_text(&pdb);
 
-         /* difference of vectors joining CA atoms */
-         /* these vectors are perpendicular to the helix axis */
+   return status;
+}
 
-         dv13[0]=vec12[0] - vec23[0];
-         dv13[1]=vec12[1] - vec23[1];
-         dv13[2]=vec12[2] - vec23[2];
+/* ------------------------------------------------------------------------- */
 
-         dv24[0]=vec23[0] - vec34[0];
-         dv24[1]=vec23[1] - vec34[1];
-         dv24[2]=vec23[2] - vec34[2];
+/* Function to write the structure read from an open PDB or mmCIF stream to an open stream in the binary format, */
+/* which later analyses read fastest; both are left open */
+int xhelix_write_binary(struct XHELIX *context, const char *pdb_id, FILE *fpi_pdb, FILE *fpo_binary)
+{
+   /* Variables */
 
-         /* x, y, z components of the cross-product vector (the axis) */
+   struct TEXTINPUT pdb;
+   char id[5];
+   int status;
 
-         cross_product[0]=(dv13[1] * dv24[2]) - (dv13[2] * dv24[1]);
-         cross_product[1]=(dv13[2] * dv24[0]) - (dv13[0] * dv24[2]);
-         cross_product[2]=(dv13[0] * dv24[1]) - (dv13[1] * dv24[0]);
 
-         /* get unit vectors of the axis */
+   strncpy(id,pdb_id,4);
+   id[4]='\0';
 
-         mag_cross_product=sqrt(SQR(cross_product[0])+SQR(cross_product[1])+SQR(cross_product[2]));
+   context->message[0]='\0';
 
-         cross_product[0]=cross_product[0]/mag_cross_product;
-         cross_product[1]=cross_product[1]/mag_cross_product;
-         cross_product[2]=cross_product[2]/mag_cross_product;
-         
-         helix[i].unit_local_axis[j][0]=cross_product[0];
-         helix[i].unit_local_axis[j][1]=cross_product[1];
-         helix[i].unit_local_axis[j][2]=cross_product[2];
+   if(open_text(&pdb, fpi_pdb))
+   {
+      snprintf(context->message,MESSAGE_LENGTH,"Error reading the PDB file of %s",id);
+      return XHELIX_ERROR_INPUT;
+   }
 
-         fprintf(fpo_axis,"unit local axis %d: X %f, Y %f, Z %f\n",j,helix[i].unit_local_axis[j][0],helix[i].unit_local_axis[j][1],helix[i].unit_local_axis[j][2]);
-     
-         dmag=sqrt(SQR(dv13[0]) + SQR(dv13[1]) + SQR(dv13[2]));
-         emag=sqrt(SQR(dv24[0]) + SQR(dv24[1]) + SQR(dv24[2]));
-         dot_product=(dv13[0]*dv24[0]) + (dv13[1]*dv24[1]) + (dv13[2]*dv24[2]);
-         costheta=dot_product/(dmag*emag);
+   /* the columns are built in the arena, so the results of the last analysis are let go */
 
-         /* radius of local helix cylinder */
+   arena_reset(context->arena);
 
-         costheta1=1.0-costheta;
-         radmag=sqrt(dmag*emag)/(costheta1*2.0);
+   clear_results(context);
 
-         /* local helix origins */
-         /* convert dv13 and dv24 to unit vectors */
+   status=write_binary(context, id, &pdb, fpo_binary);
 
-         dv13[0]=dv13[0]/dmag;
-         dv13[1]=dv13[1]/dmag;
-         dv13[2]=dv13[2]/dmag;
+   close_text(&pdb);
 
-         /* convert vectors to length of cylinder radius */
+   return status;
+}
 
-         rad[0]=radmag*dv13[0];
-         rad[1]=radmag*dv13[1];
-         rad[2]=radmag*dv13[2];
+/* ------------------------------------------------------------------------- */
 
-         /* get two helix origins for each local helix axis */
-         /* this is the first.... */
+/* Function to analyse an entry from DSSP and PDB texts held in memory */
+int xhelix_analyse_text(struct XHELIX *context, const char *pdb_id, const char *dssp, size_t dssp_size, const char *pdb, size_t pdb_size)
+{
+   /* Variables */
 
-         helix[i].origin[j][0]=helix[i].ca_coord[j+1][0]-rad[0];
-         helix[i].origin[j][1]=helix[i].ca_coord[j+1][1]-rad[1];
-         helix[i].origin[j][2]=helix[i].ca_coord[j+1][2]-rad[2];
+   struct TEXTINPUT dssp_text;
+   struct TEXTINPUT pdb_text;
+   char id[5];
+   int status;
 
-         dv24[0]=dv24[0]/emag;
-         dv24[1]=dv24[1]/emag;
-         dv24[2]=dv24[2]/emag;
 
-         rad[0]=radmag*dv24[0];
-         rad[1]=radmag*dv24[1];
-         rad[2]=radmag*dv24[2];
+   strncpy(id,pdb_id,4);
+   id[4]='\0';
 
-         /* and the second....  */
-         /* this is actually recorded over by the first origin of the next local axis, except at the very last axis! */
+   clear_results(context);
 
-         helix[i].origin[j+1][0]=helix[i].ca_coord[j+2][0]-rad[0];
-         helix[i].origin[j+1][1]=helix[i].ca_coord[j+2][1]-rad[1];
-         helix[i].origin[j+1][2]=helix[i].ca_coord[j+2][2]-rad[2];
+   /* the texts are read where they are, without a copy, unless they are gzip data */
 
-         fprintf(fpo_axis,"helix origin %d: X %f, Y %f, Z %f\n",j,helix[i].origin[j][0],helix[i].origin[j][1],helix[i].origin[j][2]);
-         fprintf(fpo_axis,"helix origin %d: X %f, Y %f, Z %f\n\n",j+1,helix[i].origin[j+1][0],helix[i].origin[j+1][1],helix[i].origin[j+1][2]);
-          
+   memset(&dssp_text, 0, sizeof(struct TEXTINPUT));
 
-      }
+   if((dssp!=NULL) && memory_text(&dssp_text, dssp, dssp_size))
+   {
+      snprintf(context->message,MESSAGE_LENGTH,"Error reading the DSSP file of %s",id);
+      return XHELIX_ERROR_INPUT;
    }
-   else
+
+   memset(&pdb_text, 0, sizeof(struct TEXTINPUT));
+
+   if((pdb!=NULL) && memory_text(&pdb_text, pdb, pdb_size))
    {
-      fprintf(fpo_axis,"Helix %d is less than 4 residues and has no axis\n\n",i);
+      close_text(&dssp_text);
+      snprintf(context->message,MESSAGE_LENGTH,"Error reading the PDB file of %s",id);
+      return XHELIX_ERROR_INPUT;
    }
 
-   fclose(fpo_axis);
+   status=analyse_entry(context, id, (dssp!=NULL) ? &dssp_text : NULL, (pdb!=NULL) ? &pdb_text : NULL);
+
+   close_text(&dssp_text);
+   close_text(&pdb_text);
+
+   return status;
 }
 
 /* ------------------------------------------------------------------------- */
 
-/* Function to get the bending angle between two local axes of a single helix (angles between axes j--j+3, j+3--j+6, etc.) and then get the maximum bending angle in the helix */
-void get_bending_angle(int helix_number, struct HELIX *helix)
+/* Function to hand out the helices of the last entry analysed */
+int xhelix_helices(struct XHELIX *context, const struct XHELIX_HELIX **helix)
 {
-   /* Variables */
+   *helix=context->helix;
 
-   int i,j,k=0,l;
-   FILE *fpo_axis;
-   double angle;
-   double max_angle=0;
-   double pi;
+   return context->helices_total;
+}
 
-   // dmf 6.27.17 will add a axis.py file that will contain a workaround
-   // to display the axis elements for each helix in PyMol. Will also want
-   // to add a vector for the point of close approach.
-   FILE *fpo_pyaxis;
-   int vec_flag;
-   char pt_label[20], previous_pt_label[20];
-   char dLabel[20]; 
+/* ------------------------------------------------------------------------- */
 
-   i=helix_number;
+/* Function to hand out the neighbouring helix pairs of the last entry analysed */
+int xhelix_pairs(struct XHELIX *context, const struct XHELIX_PAIR **pair)
+{
+   *pair=context->pair;
 
-   pi=180.0/acos(-1.0);
+   return context->pairs_total;
+}
 
-// dmf 7.25.17 - want to modify output_axis to include identifying string.
-   if((fpo_axis=fopen(output_axis, "a+"))==NULL)
-   {
-      // dmf 6.28.17 note that this is the same files as output_axis, so exists
-      printf("\n\n** Error appending to file '%s'!",output_axis);
-      exit(1);
-   }
+/* ------------------------------------------------------------------------- */
 
-    if(i==0)
-    // dmf 6.28.17 handle initialization and appending to pymol output file
-    {
-// dmf 7.25.17 - want to modify pymol_axis to include identifying string. 
-        if((fpo_pyaxis=fopen(pymol_axis, "w"))==NULL)
-        {
-            printf("\n\n** Error writing to file '%s'!",pymol_axis);
-            exit(1);
-        }
-    }
-    else
-    {
-// dmf 7.25.17 - want to modify pymol_axis to include identifying string. 
-        if((fpo_pyaxis=fopen(pymol_axis, "a+"))==NULL)
-        {
-            printf("\n\n** Error appending to file '%s'!",pymol_axis);
-            exit(1);
-        }
-    }
-    
-   if(helix[i].residues_total>=7)
+/* Function to say what went wrong with the last entry analysed, empty if nothing did */
+const char* xhelix_error(struct XHELIX *context)
+{
+   return context->message;
+}
+
+/* ------------------------------------------------------------------------- */
+
+#ifndef XHELIX_LIBRARY
+/* Function to turn a comma separated list of output file names into XHELIX_OUTPUT_ bits, -1 if a name is unknown */
+int output_bits(char *list)
+{
+   /* Variables */
+
+   static const char *output_name[OUTPUT_NAMES]={"helices", "packing", "shape", "axis", "geom", "contact", "pymol", "cgo"};
+   char *name;
+   char *next;
+   int outputs=XHELIX_OUTPUT_NONE;
+   int k;
+
+
+   for(name=list;name!=NULL;name=next)
    {
-       // set a flag processing new helix
-       vec_flag=0;
-       
-      for (j=0; j<helix[i].residues_total-6; j+=3)   /* j is axis number and must be incremented by three */
-      // dmf 6.28.17 exploit this j+=3 loop to handle outputing axis points for
-      //     display in pymol
+      if((next=strchr(name,','))!=NULL) *next++='\0';
+
+      if(!strcmp(name,"all")) outputs|=XHELIX_OUTPUT_ALL;
+      else if(strcmp(name,"none"))
       {
-         if((helix[i].unit_local_axis[j][0]!=-1) && (helix[i].unit_local_axis[j][1]!=-1) && (helix[i].unit_local_axis[j][2]!=-1) && (helix[i].unit_local_axis[j+3][0]!=-1) && (helix[i].unit_local_axis[j+3][1]!=-1) && (helix[i].unit_local_axis[j+3][2]!=-1))
-         {
-            angle=helix[i].unit_local_axis[j][0] * helix[i].unit_local_axis[j+3][0] + helix[i].unit_local_axis[j][1] * helix[i].unit_local_axis[j+3][1] + helix[i].unit_local_axis[j][2] * helix[i].unit_local_axis[j+3][2];
+         for(k=0;(k<OUTPUT_NAMES) && strcmp(name,output_name[k]);k++);
 
-            helix[i].bending_angle[k]=acos(angle)*pi;
+         if(k==OUTPUT_NAMES) return -1;
 
-            fprintf(fpo_axis,"Bending angle between axis %d and axis %d: %f degrees\n",j,j+3,helix[i].bending_angle[k]);
+         outputs|=1<<k;
+      }
+   }
 
-            k++;   /* k is bend_number and must be incremented by one */
-             
-             // dmf 6.27.17 need to start assembling the PyMol script file here... (want these points as vectors)
-             // - identify by helix_number + segment_number (so can create helix axis objects for each individual helix)
-             // - possibly only record every third axis point (in fact, should do this, otherwise will have a ton of points)
-             // - structure will be:
-             //			pseudoatom pt1, pos=[x1, y1, z1]
-             //			pseudoatom pt2, pos=[x2, y2, z2]
-             //			distance /pt1, /pt2
-             //			set dash_gap, 0
-             // - use "pt1" as identifier (e.g. helix[#]pt[#]) - "i" identifies the helix, "j" identifies the segment
-             // - want helix[i].origin[j][0], [1], [2] values
-             // - last two lines can be added before file is closed
+   return outputs;
+}
 
-             // set the label for the axis point
-             sprintf(pt_label,"h%dp%d",i,j);
-             
-             // write the coordinates of the axis point
-             fprintf(fpo_pyaxis, "pseudoatom %s, pos=[ %f, %f, %f]\n", pt_label, helix[i].origin[j][0], helix[i].origin[j][1], helix[i].origin[j][2]);
-             
-             // write the distance statement if there's a previous point
-             if (vec_flag) {
-                 // may want the distance objects to have specific names (add later)
-				 sprintf(dLabel,"%s_Axis",pt_label); 
-                 fprintf(fpo_pyaxis, "distance %s, /%s, /%s\n", dLabel, previous_pt_label, pt_label);
-                 strcpy(previous_pt_label,pt_label);
-             } else {
-                 strcpy(previous_pt_label,pt_label);
-                 // next point, will write a distance statement
-                 vec_flag = 1;
-             }
-         }
-         else
-         {
-            fprintf(fpo_axis,"*** Invalid axis has been chosen ***\n");
-            printf("\n\n*** Invalid axis has been chosen ***\n");
-            exit(1);
-         }
-      }
-      fprintf(fpo_axis,"\n");
+/* ------------------------------------------------------------------------- */
 
-      /* get maximum bending angle in helix */
+/* Function to turn the name given with -z into a XHELIX_COMPRESS_ type, -1 if it is unknown or not built in */
+int compression_type(char *name)
+{
+   if(!strcmp(name,"none")) return XHELIX_COMPRESS_NONE;
 
-      for (l=0; l<k; l++)
-      {
-         if(helix[i].bending_angle[l]>max_angle)
-         {
-            max_angle=helix[i].bending_angle[l];
-         }
-      }
-      helix[i].max_bending_angle=max_angle;
+   if(!strcmp(name,"gzip"))
+   {
+#ifdef HAVE_ZLIB
+      return XHELIX_COMPRESS_GZIP;
+#else
+      printf("x-helix was built without zlib, for gzip outputs build with -DHAVE_ZLIB ... -lz\n");
+#endif
+   }
 
-      /* Assign geometry to helix - (K)inked or not */  
+   if(!strcmp(name,"zstd"))
+   {
+#ifdef HAVE_ZSTD
+      return XHELIX_COMPRESS_ZSTD;
+#else
+      printf("x-helix was built without zstd, for zstd outputs build with -DHAVE_ZSTD ... -lzstd\n");
+#endif
+   }
 
-      if(max_angle>=20.0) helix[i].geometry='K';
+   return -1;
+}
 
-      fprintf(fpo_axis,"Maximum bending angle: %f degrees\n\n",helix[i].max_bending_angle);
-   }
+/* ------------------------------------------------------------------------- */
 
-   else
+/* Function to add an entry to the end of the batch input list, growing it as needed */
+void add_entry(struct BATCH *batch, char *pdb_id)
+{
+   if(batch->entries_total==batch->entries_max)
    {
-      fprintf(fpo_axis,"Helix %d is less than 7 residues and does not have a bending angle\n\n",i);
+      batch->entries_max*=2;
+      batch->entry=(struct BATCHENTRY *) realloc(batch->entry,batch->entries_max*sizeof(struct BATCHENTRY));
+
+      if(batch->entry==NULL)
+      {
+         printf("\n\n** Error allocating input list of %d entries!\n",batch->entries_max);
+         exit(1);
+      }
    }
 
-   fclose(fpo_axis);
-   // dmf 7.28.17
-   fclose(fpo_pyaxis); 
-}    
+   memset(&batch->entry[batch->entries_total], 0, sizeof(struct BATCHENTRY));
+
+   strcpy(batch->entry[batch->entries_total].pdb_id,pdb_id);
+   batch->entry[batch->entries_total].order=batch->entries_total;
+   batch->entries_total++;
+}
 
 /* ------------------------------------------------------------------------- */
 
-/* Function to fit plane, circle, and line to the local helix origins */
-void fit(int helix_number, struct HELIX *helix)
+/* Function to remove the later listings of entries that appear more than once in the batch, */
+/* keeping the input order of the rest */
+void drop_repeats(struct BATCH *batch)
 {
    /* Variables */
 
-   int i,j,k,l;
-   double rx[MAXRESIDUES], ry[MAXRESIDUES], rz[MAXRESIDUES];
-   double rmp[MAXRESIDUES], rmc[MAXRESIDUES], rml[MAXRESIDUES];
-   double **matp;
-   double **matc;
-   double **matl;       /* matp[3][3],matc[3][3],matl[2][2] */
-   double rotmt[3][3];
-   double **pmat;
-   double **cmat;
-   double **lmat;       /* pmat[3][3],cmat[3][3],lmat[2][2] */
-   double v[3], ap[3], ac[3], al[2];
-   double vmag;
-   double x2, y2, z2, xy, xz, yz, x, y, z, x2y, xy2, y3, x3;
-   double bp1,bp2,bp3,bc1,bc2,bc3,bl1,bl2;
-   double sump, sumc, suml;
-   double rmsdp, radcsq;
-   double deno, rdeno, rnum, r;
-   double pp,pl,pm,pn;
-   double costheta, costheta1, theta, sintheta;
-   double a1,a2,a3,b1,b2,b3;
-   double rem;
-   double radc, rmsdc, rmsdl, r2, ratio;
-   int origins_total;
-   FILE *fpo_geom;
+   struct BATCHENTRY *sorted;
+   char *repeat;
+   int i,n=0;
 
 
-   i=helix_number;
+   if(batch->entries_total<2) return;
 
-   origins_total=helix[i].residues_total-2;
+   sorted=(struct BATCHENTRY *) malloc(batch->entries_total*sizeof(struct BATCHENTRY));
+   repeat=(char *) calloc(batch->entries_total,sizeof(char));
+
+   memcpy(sorted,batch->entry,batch->entries_total*sizeof(struct BATCHENTRY));
 
-   if(i==0)
+   qsort(sorted,batch->entries_total,sizeof(struct BATCHENTRY),compare_entries);
+
+   for(i=1;i<batch->entries_total;i++)
    {
-// dmf 7.25.17 - want to modify output_geom to include identifying string. 
-      if((fpo_geom=fopen(output_geom, "w"))==NULL)
-      {
-         printf("\n\n** Error writing to file '%s'!",output_geom);
-         exit(1);
-      }
+      if(!strcmp(sorted[i].pdb_id,sorted[i-1].pdb_id)) repeat[sorted[i].order]=1;
    }
-   else   
+
+   for(i=0;i<batch->entries_total;i++)
    {
-// dmf 7.25.17 - want to modify output_geom to include identifying string. 
-      if((fpo_geom=fopen(output_geom, "a+"))==NULL)
-      {
-         printf("\n\n** Error appending to file '%s'!",output_geom);
-         exit(1);
-      }
+      if(!repeat[i]) batch->entry[n++]=batch->entry[i];
    }
 
-   fprintf(fpo_geom,"Helix Number %d\n\n",i);
+   batch->entries_total=n;
 
-   if(helix[i].residues_total>=9)
-   {
-      /* calloc the 3x3 and 2x2 matrices */
+   free(sorted);
+   free(repeat);
+}
 
-      matp = (double **) calloc(3,sizeof(double *));
+/* ------------------------------------------------------------------------- */
 
-      for(j=0; j<3; j++)
-      {
-         matp[j] = (double *) calloc(3,sizeof(double));
-      }
+/* Function to order batch entries by PDB code, and by input position within a code */
+int compare_entries(const void *a, const void *b)
+{
+   const struct BATCHENTRY *entry1=(const struct BATCHENTRY *)a;
+   const struct BATCHENTRY *entry2=(const struct BATCHENTRY *)b;
+   int c;
 
-      matc = (double **) calloc(3,sizeof(double *));
+   c=strcmp(entry1->pdb_id,entry2->pdb_id);
 
-      for(j=0; j<3; j++)
-      {
-         matc[j] = (double *) calloc(3,sizeof(double));
-      }
+   if(c) return c;
 
-      for(j=0;j<3;j++)
-      {
-         for(k=0;k<3;k++)
-         {
-            matp[j][k]=0.0;
-            matc[j][k]=0.0;
-         }  
-      }
+   return entry1->order-entry2->order;
+}
 
-      matl = (double **) calloc(2,sizeof(double *));
+/* ------------------------------------------------------------------------- */
 
-      for(j=0; j<2; j++)
-      {
-         matl[j] = (double *) calloc(2,sizeof(double));
-      }
+/* Function run by each thread of a batch: takes entries from the list until none are left or one has failed, */
+/* analysing them with a context of its own that writes the output files asked for */
+void* batch_worker(void *data)
+{
+   /* Variables */
 
-      for(j=0;j<2;j++)
-      {
-         for(k=0;k<2;k++)
-         {
-            matl[j][k]=0.0;
-         }  
-      }
+   struct BATCH *batch;
+   struct XHELIX *context;
+   int e;
+   int status;
 
-      /* fitting least squares plane to local helix origins */
 
-      x2=0.0;
-      y2=0.0;
-      z2=0.0;
-      xy=0.0;
-      xz=0.0;
-      yz=0.0;
-      x=0.0;
-      y=0.0;
-      z=0.0;
+   batch=(struct BATCH *) data;
 
-      for(j=0;j<origins_total;j++)
-      {
-         if(helix[i].origin[j][0]==-1 || helix[i].origin[j][1]==-1 || helix[i].origin[j][2]==-1)
-         {
-            printf("\n\n** error - invalid local helix origin used in analysis\n\n");
-            exit(1);
-         }
+   if((context=xhelix_create())==NULL)
+   {
+      printf("\n\n** Error allocating memory for an analysis context!\n");
+      __atomic_store_n(&batch->failed, 1, __ATOMIC_RELAXED);
+      return NULL;
+   }
 
-         x2 = helix[i].origin[j][0] * helix[i].origin[j][0] + x2;
-         y2 = helix[i].origin[j][1] * helix[i].origin[j][1] + y2;
-         z2 = helix[i].origin[j][2] * helix[i].origin[j][2] + z2;
-         xy = helix[i].origin[j][0] * helix[i].origin[j][1] + xy;
-         xz = helix[i].origin[j][0] * helix[i].origin[j][2] + xz;
-         yz = helix[i].origin[j][1] * helix[i].origin[j][2] + yz;
-         x = helix[i].origin[j][0] + x;
-         y = helix[i].origin[j][1] + y;
-         z = helix[i].origin[j][2] + z;
-      }
+   xhelix_set_threads(context, batch->pair_threads);
+   xhelix_set_outputs(context, batch->outputs);
+   xhelix_set_compression(context, batch->compression);
+   /* each report of an entry is a single printf(), which stdio writes whole, but the marks of the helices */
+   /* scanned run on through the analysis and would break into the lines of the entries of other threads */
 
-      matp[0][0] = x2 + matp[0][0];
-      matp[0][1] = xy + matp[0][1];
-      matp[0][2] = xz + matp[0][2];
-      matp[1][0] = xy + matp[1][0];
-      matp[1][1] = y2 + matp[1][1];
-      matp[1][2] = yz + matp[1][2];
-      matp[2][0] = xz + matp[2][0];
-      matp[2][1] = yz + matp[2][1];
-      matp[2][2] = z2 + matp[2][2];
+   xhelix_set_verbose(context, (batch->entry_threads>1) ? XHELIX_VERBOSE_LINES : XHELIX_VERBOSE_PROGRESS);
+   xhelix_set_ca_only(context, batch->ca_only);
 
-      pmat=matinv3(matp);
+   for(;;)
+   {
+      /* the entries being analysed by the other threads are finished, but no new ones are started */
 
-      bp1=x;
-      bp2=y;
-      bp3=z;
+      if(__atomic_load_n(&batch->failed, __ATOMIC_RELAXED)) break;
 
-      for(j=0;j<3;j++)
-      {
-         ap[j]=pmat[j][0]*bp1+pmat[j][1]*bp2+pmat[j][2]*bp3;
-      }
+      e=__atomic_fetch_add(&batch->next_entry, 1, __ATOMIC_RELAXED);
 
-      sump=0.0;
+      if(e>=batch->entries_total) break;
 
-      for(j=0;j<origins_total;j++)
+      if(batch->binary) status=batch_binary(context, batch->entry[e].pdb_id, batch->pdb_dir);
+      else status=batch_entry(context, batch->entry[e].pdb_id, batch->pdb_dir, batch->dssp_dir);
+
+      if(status)
       {
-         rmp[j]=ap[0]*helix[i].origin[j][0] + ap[1]*helix[i].origin[j][1] + ap[2]*helix[i].origin[j][2] -1;
-         sump=sump+rmp[j]*rmp[j];
+         __atomic_store_n(&batch->failed, 1, __ATOMIC_RELAXED);
+         break;
       }
 
-      if(sump<0.0) fprintf(fpo_geom,"Fit to the plane is not good\n\n");
-
-      else
+      if((batch->store!=NULL) && (!batch->binary) && store_results(batch, e, context))
       {
-         rmsdp=sqrt(sump/origins_total);
-         fprintf(fpo_geom,"RMS deviation from best plane: %f\n",rmsdp);
+         __atomic_store_n(&batch->failed, 1, __ATOMIC_RELAXED);
+         break;
       }
+   }
 
-      /* converting to the normal form of the plane */
-      /* deno is denominator, pp is distance of plane from XY plane */
+   xhelix_destroy(context);
 
-      deno=sqrt(SQR(ap[0])+SQR(ap[1])+SQR(ap[2]));
-      pp=1.0/deno;
-      pl=ap[0]*pp;
-      pm=ap[1]*pp;
-      pn=ap[2]*pp;
+   return NULL;
+}
 
-      fprintf(fpo_geom,"L, M, and N of the best plane: %f, %f, %f\n",pl,pm,pn);
+/* ------------------------------------------------------------------------- */
 
-      /* reorientate the points so that the best fit plane coincides with the X-Y plane */
-      /* l,m,n of the normal to X-Y plane are (0,0,1) */
-      /* angle between normal to best fit plane & the X-Y plane */
-      /* vector normal to the l,m,n of the best fit and X-Y plane... */
+/* Function to open the DSSP and PDB files of a listed entry and analyse it. Returns 0, or -1 after reporting */
+/* an error, which stops the run */
+int batch_entry(struct XHELIX *context, char *pdb_id, char *PDBDIR, char *DSSPDIR)
+{
+   /* Variables */
 
-      for(j=0;j<3;j++)
-      {
-         v[j]=0.0;
-      }
+   FILE *fpi_dssp;
+   FILE *fpi_pdb=NULL;
+   char dsspfile[PATH_MAX];
+   char dsspgzfile[PATH_MAX];
+   char pdbfile[PATH_MAX];
+   int status=0;
 
-      v[0]=pm+v[0];
-      v[1]=-pl+v[1];
-      v[2]=0.0+v[2];
 
-      vmag=sqrt(SQR(v[0])+SQR(v[1])+SQR(v[2]));
-      v[0]=v[0]/vmag;
-      v[1]=v[1]/vmag;
-      v[2]=v[2]/vmag;
+   snprintf(dsspfile,PATH_MAX,"%s%s.dssp",DSSPDIR,pdb_id);
+   snprintf(pdbfile,PATH_MAX,"%spdb%s.ent",PDBDIR,pdb_id);
 
-      /* the rotation matrix required to make l,m,n as 0,0,1 */
+   /* gzip files as kept on the PDB mirrors are taken when the plain ones are not there */
+   snprintf(dsspgzfile,PATH_MAX,"%s%s.dssp.gz",DSSPDIR,pdb_id);
 
-      costheta=pn;
-      costheta1=1.0-pn;
-      theta=acos(pn);
-      sintheta=sin(theta);
-      a1=v[0]*sintheta;
-      a2=v[1]*sintheta;
-      a3=v[2]*sintheta;
-      b1=v[1]*v[2]*costheta1;
-      b2=v[2]*v[0]*costheta1;
-      b3=v[0]*v[1]*costheta1;
+   printf("\nAnalysis of %s in progress\nInput Files: %s, %s\n\n",pdb_id,dsspfile,pdbfile);
 
-      for(j=0;j<3;j++)
+   /* with no DSSP file the helices are assigned from the structure, unless there is to be no structure */
+
+   if(((fpi_dssp=fopen(dsspfile,"r"))==NULL) && ((fpi_dssp=fopen(dsspgzfile,"r"))==NULL))
+   {
+      if(context->ca_only)
       {
-         for(k=0;k<3;k++)
-         {
-            rotmt[j][k]=0.0;
-         }  
+         printf("\n\nError opening %s\nError opening %s\n",dsspfile,dsspgzfile);
+         return -1;
       }
 
-      rotmt[0][0]=costheta+SQR(v[0])*costheta1+rotmt[0][0];
-      rotmt[1][1]=costheta+SQR(v[1])*costheta1+rotmt[1][1];
-      rotmt[2][2]=costheta+SQR(v[2])*costheta1+rotmt[2][2];
-      rotmt[0][1]=b3-a3+rotmt[0][1];
-      rotmt[1][0]=b3+a3+rotmt[1][0];
-      rotmt[2][0]=b2-a2+rotmt[2][0];
-      rotmt[0][2]=b2+a2+rotmt[0][2];
-      rotmt[1][2]=b1-a1+rotmt[1][2];
-      rotmt[2][1]=b1+a1+rotmt[2][1];
-
-      /* rotating the points so that they lie in the X-Y plane */
+      printf("No %s or %s, helices of %s assigned from its structure\n\n",dsspfile,dsspgzfile,pdb_id);
+   }
 
-      for(j=0;j<MAXRESIDUES;j++)
-      {
-         rx[j]=0.0;
-         ry[j]=0.0;
-         rz[j]=0.0;
-      }
+   if((!context->ca_only) && ((fpi_pdb=open_structure(pdb_id, PDBDIR, 1))==NULL)) status=-1;
+   else if(xhelix_analyse_streams(context, pdb_id, fpi_dssp, fpi_pdb)!=XHELIX_OK)
+   {
+      printf("\n\n%s\n",xhelix_error(context));
+      status=-1;
+   }
 
-      for(j=0;j<origins_total;j++)
-      {
-         rx[j]=rotmt[0][0]*helix[i].origin[j][0]+rotmt[0][1]*helix[i].origin[j][1]+rotmt[0][2]*helix[i].origin[j][2]+rx[j];
-         ry[j]=rotmt[1][0]*helix[i].origin[j][0]+rotmt[1][1]*helix[i].origin[j][1]+rotmt[1][2]*helix[i].origin[j][2]+ry[j];
-         rz[j]=rotmt[2][0]*helix[i].origin[j][0]+rotmt[2][1]*helix[i].origin[j][1]+rotmt[2][2]*helix[i].origin[j][2]+rz[j];
-      }
+   if(fpi_dssp!=NULL) fclose(fpi_dssp);
+   if(fpi_pdb!=NULL) fclose(fpi_pdb);
 
-      /* translating the points so that they lie in the X-Y plane of the form ax+by=0 */
+   return status;
+}
 
-      for(j=0;j<origins_total;j++)
-      {
-         rx[j]=rx[j];
-         ry[j]=ry[j];
-         rz[j]=rz[j]-pp;
-      }
+/* ------------------------------------------------------------------------- */
+
+/* Function to write the structure of a listed entry as <pdb code>.xhb in the current directory, for later runs */
+/* to read in place of its PDB or mmCIF file. Returns 0, or -1 after reporting an error, which stops the run */
+int batch_binary(struct XHELIX *context, char *pdb_id, char *PDBDIR)
+{
+   /* Variables */
+
+   FILE *fpi_pdb;
+   FILE *fpo_binary;
+   char binaryfile[10];
+   int status;
+
+
+   strcpy(binaryfile,pdb_id);
+   strcat(binaryfile,".xhb");
+
+   if((fpi_pdb=open_structure(pdb_id, PDBDIR, 0))==NULL) return -1;
+
+   if((fpo_binary=fopen(binaryfile,"wb"))==NULL)
+   {
+      printf("\n\nError opening %s\n",binaryfile);
+      fclose(fpi_pdb);
+      return -1;
+   }
+
+   status=xhelix_write_binary(context, pdb_id, fpi_pdb, fpo_binary);
+
+   if((fclose(fpo_binary)) && (status==XHELIX_OK))
+   {
+      printf("\n\nError writing %s\n",binaryfile);
+      status=XHELIX_ERROR_OUTPUT;
+   }
+   else if(status!=XHELIX_OK) printf("\n\n%s\n",xhelix_error(context));
+
+   fclose(fpi_pdb);
+
+   if(status!=XHELIX_OK) return -1;
+
+   printf("\nBinary structure of %s written to %s\n",pdb_id,binaryfile);
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to open the structure file of a listed entry, taking the first there of <pdb code>.xhb (if binary is set), */
+/* pdb<pdb code>.ent, its gzip file, <pdb code>.pdb and the mmCIF <pdb code>.cif and its gzip file; NULL if none is */
+FILE* open_structure(char *pdb_id, char *PDBDIR, int binary)
+{
+   /* Variables */
+
+   FILE *fpi_pdb;
+   char binaryfile[PATH_MAX];
+   char pdbfile[PATH_MAX];
+   char pdbgzfile[PATH_MAX];
+   char obpdbfile[PATH_MAX];
+   char ciffile[PATH_MAX];
+   char cifgzfile[PATH_MAX];
+
+
+   /* a binary file written by an earlier run is fastest to read */
+   snprintf(binaryfile,PATH_MAX,"%s%s.xhb",PDBDIR,pdb_id);
+
+   snprintf(pdbfile,PATH_MAX,"%spdb%s.ent",PDBDIR,pdb_id);
+
+   /* gzip files as kept on the PDB mirrors are taken when the plain ones are not there */
+   snprintf(pdbgzfile,PATH_MAX,"%spdb%s.ent.gz",PDBDIR,pdb_id);
+
+// dmf 6.28.17 change to allow 1xyz.pdb as a default alternate to pdb1xyz.ent
+   snprintf(obpdbfile,PATH_MAX,"%s%s.pdb",PDBDIR,pdb_id);
+
+   /* and last an mmCIF file, for the structures too large for the PDB format */
+   snprintf(ciffile,PATH_MAX,"%s%s.cif",PDBDIR,pdb_id);
+   snprintf(cifgzfile,PATH_MAX,"%s%s.cif.gz",PDBDIR,pdb_id);
+
+   if((binary) && ((fpi_pdb=fopen(binaryfile,"rb"))!=NULL)) return fpi_pdb;
+
+   if(((fpi_pdb=fopen(pdbfile,"r"))==NULL) && ((fpi_pdb=fopen(pdbgzfile,"r"))==NULL))
+   {
+      if(((fpi_pdb=fopen(obpdbfile,"r"))==NULL) && ((fpi_pdb=fopen(ciffile,"r"))==NULL) && ((fpi_pdb=fopen(cifgzfile,"r"))==NULL))
+      {
+         printf("\n\nError opening %s\nError opening %s\nError opening %s\nError opening %s\nError opening %s\n",pdbfile,pdbgzfile,obpdbfile,ciffile,cifgzfile);
+         return NULL;
+      }
+   }
+
+   return fpi_pdb;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to open the result store of a batch run and write its header, the run stops if it cannot be written */
+struct RESULTSTORE* open_results(char *filename)
+{
+   /* Variables */
+
+   struct RESULTSTORE *store;
+   unsigned char header[RESULTS_HEADER_SIZE];
+
+
+   store=(struct RESULTSTORE *) calloc(1,sizeof(struct RESULTSTORE));
+
+   if((store->fp=fopen(filename,"wb"))==NULL)
+   {
+      printf("\n\nError opening %s\n",filename);
+      exit(1);
+   }
+
+   store->filename=filename;
+
+   pthread_mutex_init(&store->lock, NULL);
+
+   store->helix=(struct HELIXROW *) malloc(RESULTS_GROUP_ROWS*sizeof(struct HELIXROW));
+   store->pair=(struct PAIRROW *) malloc(RESULTS_GROUP_ROWS*sizeof(struct PAIRROW));
+
+   /* columns are written RESULTS_GROUP_ROWS values at a time, none wider than 8 bytes */
+
+   store->group=(unsigned char *) malloc(RESULTS_GROUP_ROWS*8+RESULTS_ALIGN);
+
+   store->keys_max=KEYS_START;
+   store->key=(struct KEYROW *) malloc(store->keys_max*sizeof(struct KEYROW));
+
+   memcpy(header, RESULTS_MAGIC, RESULTS_MAGIC_SIZE);
+   put_u32(header+RESULTS_MAGIC_SIZE, RESULTS_GROUP_ROWS);
+
+   fwrite(header, 1, RESULTS_HEADER_SIZE, store->fp);
+
+   store->offset=RESULTS_HEADER_SIZE;
+
+   return store;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to take the helices and packed pairs of an analysed entry as rows of the result store. The entries */
+/* ready in list order from the next one to be stored are then gathered into the row groups. Returns 0, or -1 once */
+/* the store has failed, the error being reported by close_results() */
+int store_results(struct BATCH *batch, int e, struct XHELIX *context)
+{
+   /* Variables */
+
+   struct RESULTSTORE *store;
+   struct BATCHENTRY *entry;
+   const struct XHELIX_HELIX *helix;
+   const struct XHELIX_PAIR *pair;
+   struct PAIRROW *row;
+   int helices_total;
+   int pairs_total;
+   int failed;
+   int i,j,k;
+
+
+   store=batch->store;
+   entry=&batch->entry[e];
+
+   helices_total=xhelix_helices(context, &helix);
+   pairs_total=xhelix_pairs(context, &pair);
+
+   entry->helix=(struct HELIXROW *) malloc((helices_total+1)*sizeof(struct HELIXROW));
+   entry->pair=(struct PAIRROW *) malloc((pairs_total+1)*sizeof(struct PAIRROW));
+
+   for(i=0;i<helices_total;i++)
+   {
+      memcpy(entry->helix[i].pdb, helix[i].pdb, 4);
+      entry->helix[i].chain=helix[i].chain;
+      entry->helix[i].geometry=helix[i].geometry;
+      entry->helix[i].helix_no=helix[i].helix_no;
+      entry->helix[i].residues_total=helix[i].residues_total;
+      entry->helix[i].max_bending_angle=helix[i].max_bending_angle;
+   }
+
+   entry->helices_total=helices_total;
+   entry->pairs_total=0;
+
+   /* the pairs are those of helix_packing_pair.txt */
+
+   for(k=0;k<pairs_total;k++)
+   {
+      i=pair[k].helix_one;
+      j=pair[k].helix_two;
+
+      if((pair[k].packed!=1) || (helix[i].residues_total<4) || (helix[j].residues_total<4)) continue;
+
+      row=&entry->pair[entry->pairs_total++];
+
+      memcpy(row->pdb, helix[i].pdb, 4);
+      row->chain1=helix[i].chain;
+      row->chain2=helix[j].chain;
+      row->helix1=helix[i].helix_no;
+      row->helix2=helix[j].helix_no;
+      row->h1_residues=pair[k].h1_residues;
+      row->h2_residues=pair[k].h2_residues;
+      row->angle1=pair[k].angle1;
+      row->angle2=pair[k].angle2;
+      row->distance=pair[k].distance;
+      row->covalent=pair[k].covalent;
+      row->electrostatic=pair[k].electrostatic;
+      row->hbond=pair[k].hbond;
+      row->vdw=pair[k].vdw;
+   }
+
+   pthread_mutex_lock(&store->lock);
+
+   entry->analysed=1;
+
+   for(;(!store->failed) && (store->next_entry<batch->entries_total) && batch->entry[store->next_entry].analysed;store->next_entry++)
+   {
+      if(gather_rows(store, &batch->entry[store->next_entry])) store->failed=1;
+   }
+
+   failed=store->failed;
+
+   pthread_mutex_unlock(&store->lock);
+
+   return failed ? -1 : 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to add the rows of an entry to the row groups being gathered, writing out each group that fills; */
+/* called under the lock of the store. Returns 0, or -1 if the store could not be written or its index grown */
+int gather_rows(struct RESULTSTORE *store, struct BATCHENTRY *entry)
+{
+   /* Variables */
+
+   int status=0;
+   int k;
+
+
+   for(k=0;(k<entry->helices_total) && (!status);k++)
+   {
+      if((status=add_key(store, entry->helix[k].pdb, entry->helix[k].chain, entry->helix[k].helix_no, 'H', store->helix_rows++))) break;
+
+      store->helix[store->helices_total++]=entry->helix[k];
+
+      if(store->helices_total==RESULTS_GROUP_ROWS)
+      {
+         status=write_group(store, "HELX", store->helix, sizeof(struct HELIXROW), helix_column, HELIX_COLUMNS, store->helices_total);
+         store->helices_total=0;
+      }
+   }
+
+   for(k=0;(k<entry->pairs_total) && (!status);k++)
+   {
+      if((status=add_key(store, entry->pair[k].pdb, entry->pair[k].chain1, entry->pair[k].helix1, 'P', store->pair_rows))) break;
+      if((status=add_key(store, entry->pair[k].pdb, entry->pair[k].chain2, entry->pair[k].helix2, 'P', store->pair_rows++))) break;
+
+      store->pair[store->pairs_total++]=entry->pair[k];
+
+      if(store->pairs_total==RESULTS_GROUP_ROWS)
+      {
+         status=write_group(store, "PAIR", store->pair, sizeof(struct PAIRROW), pair_column, PAIR_COLUMNS, store->pairs_total);
+         store->pairs_total=0;
+      }
+   }
+
+   free(entry->helix);
+   free(entry->pair);
+
+   entry->helix=NULL;
+   entry->pair=NULL;
+
+   return status;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to write rows of one table to the result store as a row group. A result store is RESULTS_MAGIC and the */
+/* most rows in a row group of a table (4 bytes), then row groups one after another. A group starts with its table */
+/* ("HELX", "PAIR", "KEYS" or "TAIL"), rows, columns and bytes in all (4 bytes each), then has each column in turn, */
+/* the values of all its rows together, padded with zeros to RESULTS_ALIGN bytes. Text columns are fixed width and */
+/* not terminated, numbers are written lowest byte first, and every column starts aligned, so a mapped file is read */
+/* in place. The helix and pair groups come first, then one KEYS group with the index, see close_results(). Returns */
+/* 0, or -1 if the group could not be written */
+int write_group(struct RESULTSTORE *store, const char *table, const void *rows, size_t row_size, const struct RESULTCOLUMN *column, int columns_total, int rows_total)
+{
+   /* Variables */
+
+   unsigned char header[RESULTS_GROUP_HEADER];
+   const unsigned char *value;
+   unsigned char *next;
+   size_t bytes;
+   int c,r,first;
+
+
+   bytes=RESULTS_GROUP_HEADER;
+
+   for(c=0;c<columns_total;c++) bytes+=column_bytes(column[c].width, rows_total);
+
+   memcpy(header, table, 4);
+   put_u32(header+4, rows_total);
+   put_u32(header+8, columns_total);
+   put_u32(header+12, bytes);
+
+   fwrite(header, 1, RESULTS_GROUP_HEADER, store->fp);
+
+   /* a column is put together RESULTS_GROUP_ROWS values at a time, as the index may have more rows */
+
+   for(c=0;c<columns_total;c++)
+   {
+      for(first=0;first<rows_total;first+=RESULTS_GROUP_ROWS)
+      {
+         next=store->group;
+
+         for(r=first;(r<rows_total) && (r<first+RESULTS_GROUP_ROWS);r++)
+         {
+            value=(const unsigned char *) rows+r*row_size+column[c].offset;
+
+            if(column[c].type==COLUMN_INT) put_u32(next, (unsigned int) *(const int *) value);
+            else if(column[c].type==COLUMN_DOUBLE) put_double(next, *(const double *) value);
+            else memcpy(next, value, column[c].width);
+
+            next+=column[c].width;
+         }
+
+         if(r==rows_total) while((next-store->group)%RESULTS_ALIGN) *next++=0;
+
+         fwrite(store->group, 1, next-store->group, store->fp);
+      }
+   }
+
+   if(ferror(store->fp))
+   {
+      snprintf(store->message, MESSAGE_LENGTH, "Error writing the result store %s", store->filename);
+      return -1;
+   }
+
+   store->offset+=bytes;
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to write out the last row groups of the result store, then its index, sorted by protein, chain, helix, */
+/* table and row, and a TAIL group that ends the file with the offset of the index (8 bytes), and close it. Called */
+/* once the threads of the batch have finished; returns 0, or -1 after reporting why the store could not be written */
+int close_results(struct RESULTSTORE *store)
+{
+   /* Variables */
+
+   unsigned char tail[RESULTS_TAIL_SIZE];
+   unsigned long long index_offset;
+   int status;
+
+
+   /* a store that has failed is closed as it is, without its index */
+
+   if((!store->failed) && (store->helices_total>0)) store->failed=write_group(store, "HELX", store->helix, sizeof(struct HELIXROW), helix_column, HELIX_COLUMNS, store->helices_total);
+   if((!store->failed) && (store->pairs_total>0)) store->failed=write_group(store, "PAIR", store->pair, sizeof(struct PAIRROW), pair_column, PAIR_COLUMNS, store->pairs_total);
+
+   if(!store->failed)
+   {
+      qsort(store->key, store->keys_total, sizeof(struct KEYROW), compare_keys);
+
+      index_offset=store->offset;
+
+      store->failed=write_group(store, "KEYS", store->key, sizeof(struct KEYROW), key_column, KEY_COLUMNS, store->keys_total);
+   }
+
+   if(!store->failed)
+   {
+      memcpy(tail, "TAIL", 4);
+      put_u32(tail+4, 0);
+      put_u32(tail+8, 0);
+      put_u32(tail+12, RESULTS_TAIL_SIZE);
+      put_u32(tail+16, index_offset&0xffffffffULL);
+      put_u32(tail+20, index_offset>>32);
+
+      fwrite(tail, 1, RESULTS_TAIL_SIZE, store->fp);
+   }
+
+   if((fclose(store->fp)) && (!store->failed))
+   {
+      snprintf(store->message, MESSAGE_LENGTH, "Error writing the result store %s", store->filename);
+      store->failed=1;
+   }
+
+   status=0;
+
+   if(store->failed)
+   {
+      printf("\n\n%s\n",store->message);
+      status=-1;
+   }
+
+   pthread_mutex_destroy(&store->lock);
+
+   free(store->helix);
+   free(store->pair);
+   free(store->group);
+   free(store->key);
+   free(store);
+
+   return status;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to add a key to the index of the result store, growing it as needed; called under the lock of the store. */
+/* Returns 0, or -1 if there was no memory for a larger index */
+int add_key(struct RESULTSTORE *store, const char *pdb, char chain, int helix_no, char table, int row)
+{
+   /* Variables */
+
+   struct KEYROW *key;
+
+
+   if(store->keys_total==store->keys_max)
+   {
+      if((key=(struct KEYROW *) realloc(store->key,2*store->keys_max*sizeof(struct KEYROW)))==NULL)
+      {
+         snprintf(store->message, MESSAGE_LENGTH, "** Error allocating index of %d keys!", 2*store->keys_max);
+         return -1;
+      }
+
+      store->key=key;
+      store->keys_max*=2;
+   }
+
+   key=&store->key[store->keys_total++];
+
+   memcpy(key->pdb, pdb, 4);
+   key->chain=chain;
+   key->table=table;
+   key->helix_no=helix_no;
+   key->row=row;
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to order index keys by protein, chain, helix, table and row */
+int compare_keys(const void *a, const void *b)
+{
+   /* Variables */
+
+   const struct KEYROW *key1=(const struct KEYROW *)a;
+   const struct KEYROW *key2=(const struct KEYROW *)b;
+   int order;
+
+
+   if((order=memcmp(key1->pdb, key2->pdb, 4))) return order;
+   if(key1->chain!=key2->chain) return (unsigned char) key1->chain-(unsigned char) key2->chain;
+   if(key1->helix_no!=key2->helix_no) return (key1->helix_no<key2->helix_no) ? -1 : 1;
+   if(key1->table!=key2->table) return key1->table-key2->table;
+
+   return (key1->row<key2->row) ? -1 : (key1->row>key2->row);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to look up the helices and packed pairs of a protein, of one of its chains or of one helix in a result */
+/* store written with -r, query being <pdb code>[:<chain>[:<helix>]]. The store is mapped and only the index and */
+/* the rows found are read: the first key of the range is found by bisection, and each row where its group has it. */
+/* The rows are printed as in helix_shape.txt and helix_packing_pair.txt. Returns 0, the run stops on a bad store */
+int query_results(char *filename, char *query)
+{
+   /* Variables */
+
+   FILE *fp;
+   struct TEXTINPUT store;
+   const unsigned char *data;
+   const unsigned char *keys;
+   const unsigned char *group;
+   const unsigned char *column[KEY_COLUMNS];
+   const unsigned char **helix_group;
+   const unsigned char **pair_group;
+   int *pair_row;
+   char pdb[4];
+   char chain=0;
+   int helix_no=-1;
+   unsigned long long size;
+   unsigned long long offset;
+   unsigned long long index_offset;
+   unsigned long long keys_total;
+   unsigned long long bytes;
+   unsigned long long low,high,middle;
+   int helix_groups=0;
+   int pair_groups=0;
+   int pairs_found=0;
+   int g,k,r;
+   char *field;
+
+
+   /* the query: a protein, and maybe a chain and a helix number */
+
+   memset(pdb, 0, 4);
+
+   for(k=0;(k<4) && (query[k]!='\0') && (query[k]!=':');k++) pdb[k]=query[k];
+
+   if((field=strchr(query,':'))!=NULL)
+   {
+      chain=field[1];
+
+      if((chain!='\0') && ((field=strchr(field+1,':'))!=NULL)) helix_no=atoi(field+1);
+   }
+
+   if((fp=fopen(filename,"rb"))==NULL)
+   {
+      printf("\n\nError opening %s\n",filename);
+      exit(1);
+   }
+
+   if(open_text(&store, fp))
+   {
+      printf("\n\nError reading %s\n",filename);
+      exit(1);
+   }
+
+   data=(const unsigned char *) store.text;
+   size=store.size;
+
+   /* the tail gives the index, which follows the row groups */
+
+   if((size<RESULTS_HEADER_SIZE+RESULTS_TAIL_SIZE) || memcmp(data, RESULTS_MAGIC, RESULTS_MAGIC_SIZE) || memcmp(data+size-RESULTS_TAIL_SIZE, "TAIL", 4))
+   {
+      printf("\n\n%s is not a result store\n",filename);
+      exit(1);
+   }
+
+   index_offset=get_u32(data+size-8)|(get_u32(data+size-4)<<32);
+
+   if((index_offset<RESULTS_HEADER_SIZE) || (index_offset+RESULTS_GROUP_HEADER>size-RESULTS_TAIL_SIZE) || memcmp(data+index_offset, "KEYS", 4) || (get_u32(data+index_offset+8)!=KEY_COLUMNS) || (index_offset+get_u32(data+index_offset+12)!=size-RESULTS_TAIL_SIZE) || (group_column(data+index_offset, key_column, KEY_COLUMNS)!=data+size-RESULTS_TAIL_SIZE))
+   {
+      printf("\n\nError in the result store %s\n",filename);
+      exit(1);
+   }
+
+   keys=data+index_offset;
+   keys_total=get_u32(keys+4);
+
+   for(k=0;k<KEY_COLUMNS;k++) column[k]=group_column(keys, key_column, k);
+
+   /* the row groups of each table, in order, from their headers alone */
+
+   helix_group=(const unsigned char **) malloc((index_offset/RESULTS_GROUP_HEADER+1)*sizeof(unsigned char *));
+   pair_group=(const unsigned char **) malloc((index_offset/RESULTS_GROUP_HEADER+1)*sizeof(unsigned char *));
+
+   for(offset=RESULTS_HEADER_SIZE;offset<index_offset;offset+=bytes)
+   {
+      group=data+offset;
+
+      bytes=(offset+RESULTS_GROUP_HEADER<=index_offset) ? get_u32(group+12) : 0;
+
+      if((bytes<RESULTS_GROUP_HEADER) || (offset+bytes>index_offset) || (get_u32(group+4)>RESULTS_GROUP_ROWS))
+      {
+         printf("\n\nError in the result store %s\n",filename);
+         exit(1);
+      }
+
+      if(!memcmp(group, "HELX", 4) && (get_u32(group+8)==HELIX_COLUMNS) && (group_column(group, helix_column, HELIX_COLUMNS)==group+bytes)) helix_group[helix_groups++]=group;
+      else if(!memcmp(group, "PAIR", 4) && (get_u32(group+8)==PAIR_COLUMNS) && (group_column(group, pair_column, PAIR_COLUMNS)==group+bytes)) pair_group[pair_groups++]=group;
+   }
+
+   /* the first key not before the query */
+
+   low=0;
+   high=keys_total;
+
+   while(low<high)
+   {
+      middle=(low+high)/2;
+
+      k=memcmp(column[0]+4*middle, pdb, 4);
+
+      if((k==0) && (chain!='\0')) k=(int) column[1][middle]-(int) (unsigned char) chain;
+      if((k==0) && (chain!='\0') && (helix_no>=0)) k=((int) get_u32(column[3]+4*middle)<helix_no) ? -1 : ((int) get_u32(column[3]+4*middle)>helix_no);
+
+      if(k<0) low=middle+1;
+      else high=middle;
+   }
+
+   pair_row=(int *) malloc((keys_total+1)*sizeof(int));
+
+   printf("Protein\tChain\tHelix\tLength\tGeom\tMax Bending Angle\n");
+
+   for(;low<keys_total;low++)
+   {
+      if(memcmp(column[0]+4*low, pdb, 4)) break;
+      if((chain!='\0') && (column[1][low]!=(unsigned char) chain)) break;
+      if((chain!='\0') && (helix_no>=0) && ((int) get_u32(column[3]+4*low)!=helix_no)) break;
+
+      r=get_u32(column[4]+4*low);
+
+      /* the pairs are printed after the helices, in the order they were stored, and once only */
+
+      if(column[2][low]=='P')
+      {
+         pair_row[pairs_found++]=r;
+         continue;
+      }
+
+      if((g=r/RESULTS_GROUP_ROWS)>=helix_groups) continue;
+
+      group=helix_group[g];
+      r%=RESULTS_GROUP_ROWS;
+
+      if(r>=(int) get_u32(group+4)) continue;
+
+      printf("%.4s\t%c\t%d\t%d\t",group_column(group, helix_column, 0)+4*r,group_column(group, helix_column, 1)[r],(int) get_u32(group_column(group, helix_column, 2)+4*r),(int) get_u32(group_column(group, helix_column, 3)+4*r));
+      printf("%c\t%f\n",group_column(group, helix_column, 4)[r],get_double(group_column(group, helix_column, 5)+8*r));
+   }
+
+   qsort(pair_row, pairs_found, sizeof(int), compare_ints);
+
+   printf("\nProtein\tHelix1\tHelix2\tCont 1\tCont 2\tGlobal Angle\tLocal Angle\tDistance\tCovalnt\tElectro\tH-Bond\tVDW\n");
+
+   for(k=0;k<pairs_found;k++)
+   {
+      if((k>0) && (pair_row[k]==pair_row[k-1])) continue;
+
+      if((g=pair_row[k]/RESULTS_GROUP_ROWS)>=pair_groups) continue;
+
+      group=pair_group[g];
+      r=pair_row[k]%RESULTS_GROUP_ROWS;
+
+      if(r>=(int) get_u32(group+4)) continue;
+
+      printf("%.4s\t%d\t%d\t%d\t%d\t",group_column(group, pair_column, 0)+4*r,(int) get_u32(group_column(group, pair_column, 3)+4*r),(int) get_u32(group_column(group, pair_column, 4)+4*r),(int) get_u32(group_column(group, pair_column, 5)+4*r),(int) get_u32(group_column(group, pair_column, 6)+4*r));
+      printf("%f\t%f\t%f\t",get_double(group_column(group, pair_column, 7)+8*r),get_double(group_column(group, pair_column, 8)+8*r),get_double(group_column(group, pair_column, 9)+8*r));
+      printf("%d\t%d\t%d\t%d\n",(int) get_u32(group_column(group, pair_column, 10)+4*r),(int) get_u32(group_column(group, pair_column, 11)+4*r),(int) get_u32(group_column(group, pair_column, 12)+4*r),(int) get_u32(group_column(group, pair_column, 13)+4*r));
+   }
+
+   free(pair_row);
+   free(helix_group);
+   free(pair_group);
+
+   close_text(&store);
+   fclose(fp);
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to order two ints */
+int compare_ints(const void *a, const void *b)
+{
+   /* Variables */
+
+   int int1=*(const int *)a;
+   int int2=*(const int *)b;
+
+
+   return (int1<int2) ? -1 : (int1>int2);
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to run tasks 0 to tasks_total-1 of a pool on threads_total threads (the calling thread being the */
+/* first), each thread starting on an equal share and stealing from the others once its share is done. */
+/* task is called with context, the task number and the number of the thread running it */
+void run_tasks(int tasks_total, int threads_total, void (*task)(void*, int, int), void *context)
+{
+   /* Variables */
+
+   struct TASKPOOL pool;
+   struct TASKTHREAD *task_thread;
+   pthread_t *thread;
+   char *running;
+   int t;
+
+
+   if(threads_total>tasks_total) threads_total=tasks_total;
+
+   if(threads_total<=1)
+   {
+      for(t=0;t<tasks_total;t++) task(context, t, 0);
+
+      return;
+   }
+
+   pool.range=(struct TASKRANGE *) malloc(threads_total*sizeof(struct TASKRANGE));
+   pool.threads_total=threads_total;
+   pool.task=task;
+   pool.context=context;
+
+   task_thread=(struct TASKTHREAD *) malloc(threads_total*sizeof(struct TASKTHREAD));
+   thread=(pthread_t *) malloc(threads_total*sizeof(pthread_t));
+   running=(char *) calloc(threads_total,sizeof(char));
+
+   for(t=0;t<threads_total;t++)
+   {
+      pool.range[t].next=(int)((long)tasks_total*t/threads_total);
+      pool.range[t].end=(int)((long)tasks_total*(t+1)/threads_total);
+      pthread_mutex_init(&pool.range[t].lock, NULL);
+
+      task_thread[t].pool=&pool;
+      task_thread[t].thread=t;
+   }
+
+   /* the tasks of a thread that could not be started are stolen by the others */
+
+   for(t=1;t<threads_total;t++) running[t]=(pthread_create(&thread[t], NULL, task_worker, &task_thread[t])==0);
+
+   task_worker(&task_thread[0]);
+
+   for(t=1;t<threads_total;t++)
+   {
+      if(running[t]) pthread_join(thread[t], NULL);
+   }
+
+   for(t=0;t<threads_total;t++) pthread_mutex_destroy(&pool.range[t].lock);
+
+   free(running);
+   free(thread);
+   free(task_thread);
+   free(pool.range);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to take the next task for a thread of a pool, from its own range or else by stealing */
+/* the back half of the largest range left; returns -1 when no tasks are left */
+int take_task(struct TASKPOOL *pool, int thread)
+{
+   /* Variables */
+
+   struct TASKRANGE *range;
+   int t,task=-1;
+   int victim,left,most,mid,end;
+
+
+   range=&pool->range[thread];
+
+   pthread_mutex_lock(&range->lock);
+   if(range->next<range->end) task=range->next++;
+   pthread_mutex_unlock(&range->lock);
+
+   while(task<0)
+   {
+      victim=-1;
+      most=0;
+
+      for(t=0;t<pool->threads_total;t++)
+      {
+         if(t==thread) continue;
+
+         pthread_mutex_lock(&pool->range[t].lock);
+         left=pool->range[t].end-pool->range[t].next;
+         pthread_mutex_unlock(&pool->range[t].lock);
+
+         if(left>most)
+         {
+            most=left;
+            victim=t;
+         }
+      }
+
+      if(victim<0) return -1;
+
+      /* the victim may have moved on since, so look again under its lock */
+
+      pthread_mutex_lock(&pool->range[victim].lock);
+
+      left=pool->range[victim].end-pool->range[victim].next;
+      end=pool->range[victim].end;
+      mid=pool->range[victim].next+left/2;
+
+      if(left>0) pool->range[victim].end=mid;
+
+      pthread_mutex_unlock(&pool->range[victim].lock);
+
+      if(left>0)
+      {
+         task=mid;
+
+         pthread_mutex_lock(&range->lock);
+         range->next=mid+1;
+         range->end=end;
+         pthread_mutex_unlock(&range->lock);
+      }
+   }
+
+   return task;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function run by each thread of a pool: runs tasks until none are left */
+void* task_worker(void *data)
+{
+   /* Variables */
+
+   struct TASKTHREAD *task_thread;
+   int task;
+
+
+   task_thread=(struct TASKTHREAD *) data;
+
+   while((task=take_task(task_thread->pool, task_thread->thread))>=0)
+   {
+      task_thread->pool->task(task_thread->pool->context, task, task_thread->thread);
+   }
+
+   return NULL;
+}
+
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to take the rest of an input stream as one text: a regular file is mapped into memory, */
+/* anything else (a pipe, a memory stream) is read to the end. Returns 0, or -1 if it cannot be read */
+int open_text(struct TEXTINPUT *input, FILE *fp)
+{
+   /* Variables */
+
+   struct stat status;
+   void *map;
+   off_t offset;
+   size_t got;
+   size_t room=TEXT_START;
+   int fd;
+
+
+   memset(input, 0, sizeof(struct TEXTINPUT));
+
+   fd=fileno(fp);
+   offset=ftello(fp);
+
+   if((fd>=0) && (offset>=0) && (!fstat(fd, &status)) && (S_ISREG(status.st_mode)))
+   {
+      if(status.st_size<=offset)
+      {
+         input->text="";
+         return 0;
+      }
+
+      if((map=mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0))!=MAP_FAILED)
+      {
+         madvise(map, status.st_size, MADV_SEQUENTIAL);
+
+         input->map=map;
+         input->map_size=status.st_size;
+         input->text=(const char *) map+offset;
+         input->size=status.st_size-offset;
+
+         return start_text(input);
+      }
+   }
+
+   if((input->copy=(char *) malloc(room))==NULL) return -1;
+
+   while((got=fread(input->copy+input->size, 1, room-input->size, fp))>0)
+   {
+      input->size+=got;
+
+      if(input->size==room)
+      {
+         room*=2;
+
+         if((map=realloc(input->copy, room))==NULL)
+         {
+            close_text(input);
+            return -1;
+         }
+
+         input->copy=(char *) map;
+      }
+   }
+
+   if(ferror(fp))
+   {
+      close_text(input);
+      return -1;
+   }
+
+   input->text=input->copy;
+
+   return start_text(input);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to take a text already in memory as an input, it is read where it is. Returns 0, or -1 if it cannot be inflated */
+int memory_text(struct TEXTINPUT *input, const char *text, size_t size)
+{
+   memset(input, 0, sizeof(struct TEXTINPUT));
+
+   input->text=text;
+   input->size=size;
+
+   return start_text(input);
+}
+/* ------------------------------------------------------------------------- */
+
+/* Function to check an input for gzip data and, if it is compressed, to have a background thread inflate it */
+/* into memory that the readers take it from as it comes. Returns 0, or -1 if it cannot be inflated */
+int start_text(struct TEXTINPUT *input)
+{
+#ifdef HAVE_ZLIB
+   /* Variables */
+
+   struct INFLATER *inflater;
+   void *region;
+   size_t reserve;
+   size_t most;
+
+
+#endif
+   if((input->size<2) || ((unsigned char) input->text[0]!=0x1f) || ((unsigned char) input->text[1]!=0x8b)) return 0;
+
+#ifdef HAVE_ZLIB
+   /* room is set aside for the most that deflate can expand to, so the text never moves while it is */
+   /* being read; only the pages written are ever taken */
+
+   most=(sizeof(size_t)>4) ? INFLATE_MOST : INFLATE_MOST>>10;
+
+   reserve=(input->size<most/DEFLATE_RATIO) ? input->size*DEFLATE_RATIO+INFLATE_CHUNK : most;
+
+   while((region=mmap(NULL, reserve, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0))==MAP_FAILED)
+   {
+      if(reserve/2<input->size) return -1;
+
+      reserve/=2;
+   }
+
+   if((inflater=(struct INFLATER *) calloc(1,sizeof(struct INFLATER)))==NULL)
+   {
+      munmap(region, reserve);
+      return -1;
+   }
+
+   inflater->compressed=(const unsigned char *) input->text;
+   inflater->compressed_size=input->size;
+   inflater->region=(unsigned char *) region;
+   inflater->reserved=reserve;
+
+   pthread_mutex_init(&inflater->lock, NULL);
+   pthread_cond_init(&inflater->more, NULL);
+
+   input->inflater=inflater;
+   input->text=(const char *) region;
+   input->size=0;
+
+   /* without a thread of its own the text is inflated whole before it is read */
+
+   if(pthread_create(&inflater->thread, NULL, inflate_text, inflater))
+   {
+      inflate_text(inflater);
+   }
+   else inflater->running=1;
+
+   return 0;
+#else
+   return -1;
+#endif
+}
+
+#ifdef HAVE_ZLIB
+/* ------------------------------------------------------------------------- */
+
+/* Function run by the thread inflating a gzip input, member after member, a chunk at a time */
+void* inflate_text(void *data)
+{
+   /* Variables */
+
+   struct INFLATER *inflater;
+   z_stream stream;
+   size_t used=0;
+   size_t produced=0;
+   int status;
+   int stop=0;
+   int failed=0;
+
+
+   inflater=(struct INFLATER *) data;
+
+   memset(&stream, 0, sizeof(z_stream));
+
+   if(inflateInit2(&stream, 15+16)!=Z_OK) failed=1;
+
+   while(!failed && !stop)
+   {
+      /* zlib counts in 32 bits, so a very large input is fed in pieces */
+
+      if(stream.avail_in==0)
+      {
+         stream.next_in=(unsigned char *) inflater->compressed+used;
+         stream.avail_in=(inflater->compressed_size-used<INFLATE_FEED) ? inflater->compressed_size-used : INFLATE_FEED;
+         used+=stream.avail_in;
+      }
+
+      if(produced==inflater->reserved)
+      {
+         failed=1;
+         break;
+      }
+
+      stream.next_out=inflater->region+produced;
+      stream.avail_out=(inflater->reserved-produced<INFLATE_CHUNK) ? inflater->reserved-produced : INFLATE_CHUNK;
+
+      status=inflate(&stream, Z_NO_FLUSH);
+
+      produced=stream.next_out-inflater->region;
+
+      pthread_mutex_lock(&inflater->lock);
+      inflater->produced=produced;
+      stop=inflater->stop;
+      pthread_cond_broadcast(&inflater->more);
+      pthread_mutex_unlock(&inflater->lock);
+
+      if(status==Z_STREAM_END)
+      {
+         /* another member may follow, as in files joined with cat; anything else after the end is ignored, as by gzip */
+
+         if(stream.avail_in==0)
+         {
+            stream.next_in=(unsigned char *) inflater->compressed+used;
+            stream.avail_in=(inflater->compressed_size-used<INFLATE_FEED) ? inflater->compressed_size-used : INFLATE_FEED;
+            used+=stream.avail_in;
+         }
+
+         if((stream.avail_in<2) || (stream.next_in[0]!=0x1f) || (stream.next_in[1]!=0x8b)) break;
+
+         inflateReset(&stream);
+      }
+      else if((status!=Z_OK) && ((status!=Z_BUF_ERROR) || (used==inflater->compressed_size)))
+      {
+         failed=1;
+      }
+   }
+
+   inflateEnd(&stream);
+
+   pthread_mutex_lock(&inflater->lock);
+   inflater->failed=failed;
+   inflater->done=1;
+   pthread_cond_broadcast(&inflater->more);
+   pthread_mutex_unlock(&inflater->lock);
+
+   return NULL;
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to wait until an input has bytes more text after its next record, or has been inflated whole */
+void wait_text(struct TEXTINPUT *input, size_t bytes)
+{
+#ifdef HAVE_ZLIB
+   /* Variables */
+
+   struct INFLATER *inflater;
+
+
+   inflater=input->inflater;
+
+   if((inflater==NULL) || (input->size-input->next>=bytes)) return;
+
+   pthread_mutex_lock(&inflater->lock);
+
+   while((!inflater->done) && (inflater->produced-input->next<bytes)) pthread_cond_wait(&inflater->more, &inflater->lock);
+
+   input->size=inflater->produced;
+
+   pthread_mutex_unlock(&inflater->lock);
+#else
+   /* without zlib all the text is there from the start */
+
+   (void) input;
+   (void) bytes;
+#endif
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to tell whether the text read from an input was cut short by corrupt or truncated gzip data */
+int text_failed(struct TEXTINPUT *input)
+{
+#ifdef HAVE_ZLIB
+   /* Variables */
+
+   int failed;
+
+
+   if(input->inflater==NULL) return 0;
+
+   pthread_mutex_lock(&input->inflater->lock);
+   failed=input->inflater->failed && (input->next==input->inflater->produced);
+   pthread_mutex_unlock(&input->inflater->lock);
+
+   return failed;
+#else
+   (void) input;
+
+   return 0;
+#endif
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to unmap or free the text of an input, ending its inflation first */
+void close_text(struct TEXTINPUT *input)
+{
+#ifdef HAVE_ZLIB
+   /* Variables */
+
+   struct INFLATER *inflater;
+
+
+   if((inflater=input->inflater)!=NULL)
+   {
+      if(inflater->running)
+      {
+         pthread_mutex_lock(&inflater->lock);
+         inflater->stop=1;
+         pthread_mutex_unlock(&inflater->lock);
+
+         pthread_join(inflater->thread, NULL);
+      }
+
+      pthread_mutex_destroy(&inflater->lock);
+      pthread_cond_destroy(&inflater->more);
+      munmap(inflater->region, inflater->reserved);
+      free(inflater);
+   }
+
+#endif
+   if(input->map!=NULL) munmap(input->map, input->map_size);
+
+   free(input->copy);
+
+   memset(input, 0, sizeof(struct TEXTINPUT));
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to take an input back to its start, to be read again */
+void rewind_text(struct TEXTINPUT *input)
+{
+   input->next=0;
+   input->end=0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to find the next record of an input as fgets() with a buffer of size bytes would read it: up to */
+/* and including the next newline, but no more than size-1 characters. Returns its length and sets record, or */
+/* -1 when nothing is left. input->end is set as feof() would be, once a record has run into the end of the text */
+int next_record(struct TEXTINPUT *input, int size, const char **record)
+{
+   /* Variables */
+
+   const char *newline;
+   size_t left;
+   int length;
+
+
+   wait_text(input, size-1);
+
+   left=input->size-input->next;
+
+   if(left==0)
+   {
+      input->end=1;
+      return -1;
+   }
+
+   *record=input->text+input->next;
+
+   length=(left<(size_t)(size-1)) ? (int) left : size-1;
+
+   /* memchr() is the vectorised newline scan of the C library */
+
+   if((newline=(const char *) memchr(*record, '\n', length))!=NULL) length=newline-*record+1;
+   else if(length<size-1) input->end=1;
+
+   input->next+=length;
+
+   return length;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to make a record the current line of a reader. A record with all the columns the reader */
+/* looks at is read in place; a shorter one is laid over the lines before it in the buffer, newline and all */
+/* (taken off if strip is set), so its missing columns are what the old fgets() loops would have seen */
+void view_line(struct LINEVIEW *view, const char *record, int length, int strip)
+{
+   /* Variables */
+
+   int k;
+
+
+   k=(record[length-1]=='\n') ? length-1 : length;
+
+   if(k>=view->columns)
+   {
+      view->line=record;
+      view->pending=record;
+      view->zero_column=-1;
+      return;
+   }
+
+   /* the last line read in place is brought into the buffer first */
+
+   if(view->pending!=NULL)
+   {
+      memcpy(view->buffer, view->pending, view->columns);
+
+      if(view->zero_column>=0) view->buffer[view->zero_column]='0';
+
+      view->pending=NULL;
+   }
+
+   memcpy(view->buffer, record, length);
+   view->buffer[length]='\0';
+
+   if(strip)
+   {
+      k=strlen(view->buffer);
+
+      if((k>0) && (view->buffer[k-1]=='\n')) view->buffer[k-1]='\0';
+   }
+
+   view->line=view->buffer;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to note that a blank column of the current line reads as '0' from now on, as the old readers */
+/* wrote it into their line buffer */
+void zero_column(struct LINEVIEW *view, int column)
+{
+   if(view->line==view->buffer) view->buffer[column]='0';
+   else view->zero_column=column;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to decode a number from a fixed width field as atof() would the field copied out on its own. */
+/* Plain decimals are built up as an integer and scaled once, which rounds the same as strtod(); anything */
+/* that strtod() would read further (an exponent, hex, inf or nan) or too many digits is left to atof() */
+double decode_number(const char *field, int width)
+{
+   /* Variables */
+
+   char copy[LINLEN];
+   long long mantissa=0;
+   int k=0;
+   int digits=0;
+   int decimals=0;
+   int point=0;
+   int negative=0;
+   char c='\0';
+
+
+   while((k<width) && (IS_SPACE(field[k]))) k++;
+
+   if((k<width) && ((field[k]=='-') || (field[k]=='+'))) negative=(field[k++]=='-');
+
+   for(;k<width;k++)
+   {
+      c=field[k];
+
+      if((c>='0') && (c<='9'))
+      {
+         mantissa=10*mantissa+(c-'0');
+         digits++;
+         decimals+=point;
+      }
+      else if((c=='.') && (!point)) point=1;
+      else break;
+   }
+
+   if((k<width) && ((c=='e') || (c=='E') || (c=='x') || (c=='X') || (c=='i') || (c=='I') || (c=='n') || (c=='N'))) digits=EXACT_DIGITS+1;
+
+   if(digits>EXACT_DIGITS)
+   {
+      memcpy(copy, field, width);
+      copy[width]='\0';
+
+      return atof(copy);
+   }
+
+   if(digits==0) return 0.0;
+
+   return negative ? -(mantissa/powers_of_ten[decimals]) : mantissa/powers_of_ten[decimals];
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to decode a whole number from a fixed width field as atoi() would the field copied out on its own */
+int decode_integer(const char *field, int width)
+{
+   /* Variables */
+
+   int k=0;
+   int n=0;
+   int negative=0;
+
+
+   while((k<width) && (IS_SPACE(field[k]))) k++;
+
+   if((k<width) && ((field[k]=='-') || (field[k]=='+'))) negative=(field[k++]=='-');
+
+   for(;(k<width) && (field[k]>='0') && (field[k]<='9');k++) n=10*n+(field[k]-'0');
+
+   return negative ? -n : n;
+}
+
+/* ------------------------------------------------------------------------- */
+      
+/* Function to read DSSP file, get residues in helices, and initialise helix array */
+/* the helix records and residue slots are sized from the DSSP content, and one record beyond */
+/* the last helix is always kept (as before) for a helix that is still open at the end of the file. */
+/* With ca_only the helix C-alphas are also taken from the X-CA, Y-CA and Z-CA columns */
+struct HELIX* read_helices(struct TEXTINPUT *dssp, int *helices_total, char *pdb_id, int ca_only, struct ARENA *arena)
+{
+   /* Variables */
+
+   struct LINEVIEW view;
+   struct HELIXBUILD build;
+   const char *line;
+   const char *record;
+   char chain;
+   char res_sub_type;
+   float res_number;
+   float res_sub_number;
+   float ca[3];
+   int n;
+   char previous_structure='Z';
+   char current_structure='X';
+
+
+   start_helices(&build, arena);
+
+   if(ca_only)
+   {
+      build.cas_max=SLOTS_START;
+      build.ca=(float (*)[3]) arena_alloc(arena,build.cas_max*sizeof(float[3]));
+   }
+
+   /* the lines are taken as fgets() took them, but decoded where they lie in the input */
+
+   memset(&view, 0, sizeof(struct LINEVIEW));
+
+   view.columns=(ca_only) ? DSSP_CA_COLUMNS : DSSP_COLUMNS;
+   view.zero_column=-1;
+
+   /* start getting the dssp file line by line, and get to important bit */
+
+   do
+   {
+      if((n=next_record(dssp, DLINLEN, &record))>=0) view_line(&view, record, n, 0);
+   }
+   while(!dssp->end && view.line[2]!='#');
+  
+   /* i is number of helices */
+   /* k is number of residues in each helix */
+
+   /* as when read with fgets(), the last line is gone over again when the text ends with a newline */
+
+   while(!dssp->end)
+   {
+      if((n=next_record(dssp, DLINLEN, &record))>=0) view_line(&view, record, n, 1);
+
+      line=view.line;
+
+      if(line[13]!='!')
+      {
+         chain=line[11];
+
+         if(chain==' ')
+         {
+            chain='0';
+            zero_column(&view, 11);
+         }
+ 
+         /* get residue number, e.g. residue 10 becomes 10.00 */
+
+         res_number=decode_number(line+5, 6);
+       
+         res_sub_type=' ';
+         res_sub_number=0.0;
+
+         /* get residue sub-label if it exists */
+
+         if((line[10]!=' ') && ((line[10]<'0') || (line[10]>'9')))
+         {
+            res_sub_type=line[10];
+            res_sub_number=res_sub_type-64;
+            res_sub_number=res_sub_number/100;
+         }
+
+         /* this has converted residue 1A into 1.01, residue 2B into 2.02 etc. */
+
+         res_number+=res_sub_number;
+
+         current_structure=line[16];    /* update current secondary structure type */
+
+
+         if(current_structure=='I' || current_structure=='G' || current_structure=='H')    /* if secondary structure of this line is a helix... */
+         {
+            if(ca_only)
+            {
+               ca[0]=decode_number(line+115, 7);
+               ca[1]=decode_number(line+122, 7);
+               ca[2]=decode_number(line+129, 7);
+            }
+
+            helix_residue(&build, pdb_id, chain, res_number, line[13], (ca_only) ? ca : NULL);
+         }
+
+         /* if secondary structure of this line is not a helix and the structure from */
+         /* the previous line was... then assume end of helix */
+
+         else if((current_structure!='I' || current_structure!='G' || current_structure!='H') && (previous_structure=='I' || previous_structure=='G' || previous_structure=='H'))
+         {
+            end_helix(&build);
+         }
+
+         previous_structure=current_structure;         
+      }
+
+      else if((line[13]=='!') && (previous_structure=='I' || previous_structure=='G' || previous_structure=='H'))
+      {
+         previous_structure='Z';
+         current_structure='X';
+
+         end_helix(&build);
+      }                     
+   }
+
+   return finish_helices(&build, helices_total);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to start the helix records of a protein, the first filled with junk for debugging */
+void start_helices(struct HELIXBUILD *build, struct ARENA *arena)
+{
+   build->arena=arena;
+   build->helices_max=HELICES_START;
+   build->slots_max=SLOTS_START;
+   build->i=0;
+   build->k=0;
+   build->ca=NULL;
+   build->cas_total=0;
+   build->cas_max=0;
+
+   build->helix=(struct HELIX *) arena_alloc(arena,build->helices_max*sizeof(struct HELIX));
+
+   build->residues=(char *) arena_alloc(arena,build->slots_max*sizeof(char));
+   build->residue_numbers=(float *) arena_alloc(arena,build->slots_max*sizeof(float));
+
+   /* with no memory for them the helices are not built, and finish_helices() gives NULL */
+
+   if(arena->failed) return;
+
+   /* the other records are filled as they are reached */ 
+
+   init_helix(&build->helix[0], 0, build->residues, build->residue_numbers);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to add a residue to the helix being built, with its C-alpha if the helices are taking them */
+void helix_residue(struct HELIXBUILD *build, char *pdb_id, char chain, float res_number, char residue, const float *ca)
+{
+   /* Variables */
+
+   struct HELIX *helix;
+   int k;
+
+
+   if(build->arena->failed) return;
+
+   helix=&build->helix[build->i];
+   k=build->k;
+
+   /* make room for this residue and the spare slot that ends the helix */
+
+   if(helix->offset+k+2>build->slots_max)
+   {
+      build->residues=(char *) arena_realloc(build->arena,build->residues,build->slots_max*sizeof(char),2*build->slots_max*sizeof(char));
+      build->residue_numbers=(float *) arena_realloc(build->arena,build->residue_numbers,build->slots_max*sizeof(float),2*build->slots_max*sizeof(float));
+      build->slots_max*=2;
+
+      if(build->arena->failed) return;
+   }
+
+   strcpy(helix->pdb,pdb_id);
+
+   helix->chain=chain;
+                  
+   build->residue_numbers[helix->offset+k]=res_number;
+   build->residue_numbers[helix->offset+k+1]=-1;
+         
+   build->residues[helix->offset+k]=residue;
+   build->residues[helix->offset+k+1]='\0'; 
+
+   if(ca!=NULL)
+   {
+      if(build->cas_total==build->cas_max)
+      {
+         build->ca=(float (*)[3]) arena_realloc(build->arena,build->ca,build->cas_max*sizeof(float[3]),2*build->cas_max*sizeof(float[3]));
+         build->cas_max*=2;
+
+         if(build->ca==NULL) return;
+      }
+
+      memcpy(build->ca[build->cas_total++], ca, sizeof(float[3]));
+   }
+
+   /* and increment k (the helix residue number) for the next residue of existing helix */
+
+   build->k++;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to end the helix being built: reset k (helix residue number) and increment i (the helix number) */
+/* in preparation for start of next helix */
+void end_helix(struct HELIXBUILD *build)
+{
+   if(build->arena->failed) return;
+
+   build->helix[build->i].residues_total=build->k;
+
+   build->helix[build->i].helix_no=build->i;
+
+   build->k=0;
+
+   build->i++;        
+
+   build->helix=next_helix(build->helix, build->i, &build->helices_max, &build->residues, &build->residue_numbers, &build->slots_max, build->arena);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to give the helix records their slots once all helices are found. A helix still open is not */
+/* counted, but its record is always kept (as before); NULL if there was no memory for the helices */
+struct HELIX* finish_helices(struct HELIXBUILD *build, int *helices_total)
+{
+   /* Variables */
+
+   struct HELIX *helix;
+   char *residues;
+   float *residue_numbers;
+   struct ARENA *arena;
+   int g,h,i,k;
+   int slots_total;
+
+
+   helix=build->helix;
+   residues=build->residues;
+   residue_numbers=build->residue_numbers;
+   arena=build->arena;
+   i=build->i;
+   k=build->k;
+
+   *helices_total=i;
+
+   if(arena->failed) return NULL;
+
+   /* the slots in use run up to the spare slot of the last (open) helix record */
+
+   slots_total=helix[i].offset+k+1;
+
+   helix[0].ca_coord=(float (*)[3]) arena_alloc(arena,slots_total*sizeof(float[3]));
+   helix[0].unit_local_axis=(double (*)[3]) arena_alloc(arena,slots_total*sizeof(double[3]));
+   helix[0].axis_sum=(double (*)[3]) arena_alloc(arena,slots_total*sizeof(double[3]));
+   helix[0].unset_axes=(int *) arena_alloc(arena,slots_total*sizeof(int));
+   helix[0].origin=(double (*)[3]) arena_alloc(arena,slots_total*sizeof(double[3]));
+   helix[0].bending_angle=(double *) arena_alloc(arena,slots_total*sizeof(double));
+
+   if(arena->failed) return NULL;
+
+   /* fill all the slots with junk for debugging */
+
+   for(h=0; h<slots_total; h++)
+   {
+      for(g=0; g<3; g++)
+      {
+         helix[0].ca_coord[h][g]=-9999;
+         helix[0].unit_local_axis[h][g]=-1;
+         helix[0].origin[h][g]=-1;
+      }
+      helix[0].bending_angle[h]=-1;
+   }
+
+   /* and point every helix record at its own slots */
+
+   for(g=0; g<=i; g++)
+   {
+      helix[g].residues=residues+helix[g].offset;
+      helix[g].residue_numbers=residue_numbers+helix[g].offset;
+      helix[g].ca_coord=helix[0].ca_coord+helix[g].offset;
+      helix[g].unit_local_axis=helix[0].unit_local_axis+helix[g].offset;
+      helix[g].axis_sum=helix[0].axis_sum+helix[g].offset;
+      helix[g].unset_axes=helix[0].unset_axes+helix[g].offset;
+      helix[g].origin=helix[0].origin+helix[g].offset;
+      helix[g].bending_angle=helix[0].bending_angle+helix[g].offset;
+   }
+
+   /* C-alphas taken from the DSSP file go to the helices they were read with, a helix still open having none */
+
+   if(build->ca!=NULL)
+   {
+      for(g=0,k=0; g<i; g++)
+      {
+         for(h=0; h<helix[g].residues_total; h++,k++) memcpy(helix[g].ca_coord[h], build->ca[k], sizeof(float[3]));
+      }
+   }
+
+   return helix;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to find the helices of a protein from its structure, in place of a DSSP file: the backbone hydrogen */
+/* bonds, bridges and helices are worked out as DSSP (Kabsch and Sander) does, and the residues it would give H, */
+/* G or I make up the helix records as read_helices() would make them from its output */
+struct HELIX* assign_helices(struct TEXTINPUT *structure, int *helices_total, char *pdb_id, struct ARENA *arena)
+{
+   /* Variables */
+
+   struct BACKBONE backbone;
+   struct HELIXBUILD build;
+   char *structure_type;
+   float res_number;
+   int r;
+   int previous_helix=0;
+   int status;
+
+
+   /* the atoms are read here and again by the atom reader, so the input is taken back to its start */
+
+   memset(&backbone, 0, sizeof(struct BACKBONE));
+
+   backbone.arena=arena;
+
+   status=structure_sites(structure, backbone_site, &backbone, arena);
+
+   rewind_text(structure);
+
+   if((status) || (arena->failed)) return NULL;
+
+   complete_backbone(&backbone);
+
+   if((structure_type=(char *) arena_alloc(arena,(backbone.residues_total+1)*sizeof(char)))==NULL) return NULL;
+
+   backbone_hbonds(&backbone);
+
+   if(!arena->failed) beta_bridges(&backbone, structure_type);
+
+   if(!arena->failed) helix_structure(&backbone, structure_type);
+
+   if(arena->failed) return NULL;
+
+   /* the residues are gone over as the lines of a DSSP file, a break in the chain being a '!' line */
+
+   start_helices(&build, arena);
+
+   for(r=0;r<backbone.residues_total;r++)
+   {
+      if((r>0) && (backbone.number[r]!=backbone.number[r-1]+1))
+      {
+         if(previous_helix) end_helix(&build);
+
+         previous_helix=0;
+      }
+
+      /* chains with more than one character to their name cannot be told apart, so none of their residues are taken */
+
+      if((backbone.chain[r]!='\0') && ((structure_type[r]=='H') || (structure_type[r]=='G') || (structure_type[r]=='I')))
+      {
+         res_number=backbone.seq[r];
+         res_number+=insertion_number(backbone.res_sub_type[r]);
+
+         helix_residue(&build, pdb_id, backbone.chain[r], res_number, backbone.letter[r], NULL);
+
+         previous_helix=1;
+      }
+      else
+      {
+         if(previous_helix) end_helix(&build);
+
+         previous_helix=0;
+      }
+   }
+
+   return finish_helices(&build, helices_total);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to take the backbone atoms of each residue as the atoms of a structure come in, the first of each */
+/* name in a residue (so the first alternate location) being kept */
+int backbone_site(void *data, struct ATOMSITE *atom)
+{
+   /* Variables */
+
+   struct BACKBONE *backbone;
+   double (*position)[3]=NULL;
+   int r;
+   int bit=0;
+
+
+   backbone=(struct BACKBONE *) data;
+
+   r=backbone->residues_total-1;
+
+   /* a new residue starts when the chain, residue number, insertion code or residue name change */
+
+   if((r<0) || (atom->chain!=backbone->chain[r]) || (atom->seq!=backbone->seq[r]) || (atom->res_sub_type!=backbone->res_sub_type[r]) || (strcmp(atom->resname,backbone->resname[r])))
+   {
+      if((r=add_residue(backbone))<0) return -1;
+
+      backbone->chain[r]=atom->chain;
+      backbone->seq[r]=atom->seq;
+      backbone->res_sub_type[r]=atom->res_sub_type;
+      strcpy(backbone->resname[r],atom->resname);
+      backbone->present[r]=0;
+   }
+
+   if(!strcmp(atom->atom_name," N  "))
+   {
+      position=backbone->n;
+      bit=BACKBONE_N;
+   }
+   else if(!strcmp(atom->atom_name," CA "))
+   {
+      position=backbone->ca;
+      bit=BACKBONE_CA;
+   }
+   else if(!strcmp(atom->atom_name," C  "))
+   {
+      position=backbone->c;
+      bit=BACKBONE_C;
+   }
+   else if(!strcmp(atom->atom_name," O  "))
+   {
+      position=backbone->o;
+      bit=BACKBONE_O;
+   }
+
+   if((position==NULL) || (backbone->present[r]&bit)) return 0;
+
+   position[r][0]=atom->x;
+   position[r][1]=atom->y;
+   position[r][2]=atom->z;
+
+   backbone->present[r]|=bit;
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to add a residue to the end of the backbone, growing it as needed, and return its number; -1 if there */
+/* is no memory for it */
+int add_residue(struct BACKBONE *backbone)
+{
+   /* Variables */
+
+   int old_max;
+
+
+   if(backbone->residues_total==backbone->residues_max)
+   {
+      old_max=backbone->residues_max;
+
+      backbone->residues_max=(old_max) ? 2*old_max : SLOTS_START;
+
+      backbone->n=(double (*)[3]) arena_realloc(backbone->arena,backbone->n,old_max*sizeof(double[3]),backbone->residues_max*sizeof(double[3]));
+      backbone->ca=(double (*)[3]) arena_realloc(backbone->arena,backbone->ca,old_max*sizeof(double[3]),backbone->residues_max*sizeof(double[3]));
+      backbone->c=(double (*)[3]) arena_realloc(backbone->arena,backbone->c,old_max*sizeof(double[3]),backbone->residues_max*sizeof(double[3]));
+      backbone->o=(double (*)[3]) arena_realloc(backbone->arena,backbone->o,old_max*sizeof(double[3]),backbone->residues_max*sizeof(double[3]));
+      backbone->h=(double (*)[3]) arena_realloc(backbone->arena,backbone->h,old_max*sizeof(double[3]),backbone->residues_max*sizeof(double[3]));
+      backbone->seq=(double *) arena_realloc(backbone->arena,backbone->seq,old_max*sizeof(double),backbone->residues_max*sizeof(double));
+      backbone->number=(int *) arena_realloc(backbone->arena,backbone->number,old_max*sizeof(int),backbone->residues_max*sizeof(int));
+      backbone->acceptor=(struct HBOND (*)[2]) arena_realloc(backbone->arena,backbone->acceptor,old_max*sizeof(struct HBOND[2]),backbone->residues_max*sizeof(struct HBOND[2]));
+      backbone->donor=(struct HBOND (*)[2]) arena_realloc(backbone->arena,backbone->donor,old_max*sizeof(struct HBOND[2]),backbone->residues_max*sizeof(struct HBOND[2]));
+      backbone->resname=(char (*)[4]) arena_realloc(backbone->arena,backbone->resname,old_max*sizeof(char[4]),backbone->residues_max*sizeof(char[4]));
+      backbone->chain=(char *) arena_realloc(backbone->arena,backbone->chain,old_max*sizeof(char),backbone->residues_max*sizeof(char));
+      backbone->res_sub_type=(char *) arena_realloc(backbone->arena,backbone->res_sub_type,old_max*sizeof(char),backbone->residues_max*sizeof(char));
+      backbone->letter=(char *) arena_realloc(backbone->arena,backbone->letter,old_max*sizeof(char),backbone->residues_max*sizeof(char));
+      backbone->present=(unsigned char *) arena_realloc(backbone->arena,backbone->present,old_max*sizeof(unsigned char),backbone->residues_max*sizeof(unsigned char));
+
+      if(backbone->arena->failed) return -1;
+   }
+
+   return backbone->residues_total++;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to keep only the residues with all of N, CA, C and O, as DSSP does, and to number them as DSSP */
+/* does, with a number left out at each break: a new chain, or a peptide C-N longer than PEPTIDE_BOND_MAX */
+void complete_backbone(struct BACKBONE *backbone)
+{
+   /* Variables */
+
+   double d;
+   int r,s,k;
+
+
+   for(r=0,s=0;r<backbone->residues_total;r++)
+   {
+      if(backbone->present[r]!=BACKBONE_ALL) continue;
+
+      if(s<r)
+      {
+         for(k=0;k<3;k++)
+         {
+            backbone->n[s][k]=backbone->n[r][k];
+            backbone->ca[s][k]=backbone->ca[r][k];
+            backbone->c[s][k]=backbone->c[r][k];
+            backbone->o[s][k]=backbone->o[r][k];
+         }
+
+         backbone->seq[s]=backbone->seq[r];
+         backbone->chain[s]=backbone->chain[r];
+         backbone->res_sub_type[s]=backbone->res_sub_type[r];
+         strcpy(backbone->resname[s],backbone->resname[r]);
+      }
+
+      backbone->letter[s]=residue_letter(backbone->resname[s]);
+
+      if(s==0) backbone->number[s]=1;
+      else if((backbone->chain[s]!=backbone->chain[s-1]) || (SQR(backbone->c[s-1][0]-backbone->n[s][0])+SQR(backbone->c[s-1][1]-backbone->n[s][1])+SQR(backbone->c[s-1][2]-backbone->n[s][2])>SQR(PEPTIDE_BOND_MAX))) backbone->number[s]=backbone->number[s-1]+2;
+      else backbone->number[s]=backbone->number[s-1]+1;
+
+      /* the amide hydrogen lies 1 A from N, away from the carbonyl O of the residue before; at a break it is put on N */
+
+      for(k=0;k<3;k++) backbone->h[s][k]=backbone->n[s][k];
+
+      if((s>0) && (backbone->number[s]==backbone->number[s-1]+1) && (backbone->letter[s]!='P'))
+      {
+         d=sqrt(SQR(backbone->c[s-1][0]-backbone->o[s-1][0])+SQR(backbone->c[s-1][1]-backbone->o[s-1][1])+SQR(backbone->c[s-1][2]-backbone->o[s-1][2]));
+
+         for(k=0;k<3;k++) backbone->h[s][k]+=(backbone->c[s-1][k]-backbone->o[s-1][k])/d;
+      }
+
+      for(k=0;k<2;k++)
+      {
+         backbone->acceptor[s][k].residue=-1;
+         backbone->acceptor[s][k].energy=0.0;
+         backbone->donor[s][k].residue=-1;
+         backbone->donor[s][k].energy=0.0;
+      }
+
+      s++;
+   }
+
+   backbone->residues_total=s;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to give the one letter code of a residue name, X for one that is not one of the twenty */
+char residue_letter(const char *resname)
+{
+   /* Variables */
+
+   int k;
+
+
+   for(k=0;k<20;k++)
+   {
+      if(!strncmp(resname,amino_acid_name+3*k,3)) return amino_acid_letter[k];
+   }
+
+   return 'X';
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to find the two strongest backbone hydrogen bonds each residue gives and takes, from the DSSP */
+/* electrostatic energy, between residues with C-alphas closer than HBOND_CA_DISTANCE. The C-alphas are sorted */
+/* into a grid of cells that wide; the energies of a residue with all its neighbours are worked out together */
+/* and then kept in the order DSSP would meet them, so ties go the same way */
+void backbone_hbonds(struct BACKBONE *backbone)
+{
+   /* Variables */
+
+   struct ARENA *arena;
+   struct CELLGRID grid;
+   double max[3];
+   double d2;
+   int *neighbour;
+   double *energy_given;
+   double *energy_taken;
+   int neighbours_total;
+   int cells_total;
+   int i,j,k,l,n;
+
+
+   arena=backbone->arena;
+   n=backbone->residues_total;
+
+   if(n<2) return;
+
+   for(k=0;k<3;k++)
+   {
+      grid.min[k]=backbone->ca[0][k];
+      max[k]=backbone->ca[0][k];
+   }
+
+   for(i=1;i<n;i++)
+   {
+      for(k=0;k<3;k++)
+      {
+         if(backbone->ca[i][k]<grid.min[k]) grid.min[k]=backbone->ca[i][k];
+         if(backbone->ca[i][k]>max[k]) max[k]=backbone->ca[i][k];
+      }
+   }
+
+   grid.cell=HBOND_CA_DISTANCE;
+   grid.helix_start=NULL;
+   grid.atoms_max=n;
+
+   cells_total=size_grid(&grid, max);
+
+   grid.atom_cell=(int *) arena_alloc(arena,n*sizeof(int));
+   neighbour=(int *) arena_alloc(arena,n*sizeof(int));
+   energy_given=(double *) arena_alloc(arena,n*sizeof(double));
+   energy_taken=(double *) arena_alloc(arena,n*sizeof(double));
+
+   if(arena->failed) return;
+
+   for(i=0;i<n;i++) grid.atom_cell[i]=grid_cell(&grid, backbone->ca[i][0], backbone->ca[i][1], backbone->ca[i][2]);
+
+   if(fill_grid(&grid, cells_total, n, arena)) return;
+
+   for(i=0;i+1<n;i++)
+   {
+      /* the residues after i with C-alphas in reach, in order */
+
+      l=grid_near(&grid, i, i+1, n, neighbour);
+
+      for(k=0,neighbours_total=0;k<l;k++)
+      {
+         j=neighbour[k];
+
+         d2=SQR(backbone->ca[i][0]-backbone->ca[j][0])+SQR(backbone->ca[i][1]-backbone->ca[j][1])+SQR(backbone->ca[i][2]-backbone->ca[j][2]);
+
+         if(d2<SQR(HBOND_CA_DISTANCE)) neighbour[neighbours_total++]=j;
+      }
+
+      qsort(neighbour,neighbours_total,sizeof(int),compare_residues);
+
+      /* the energies of i with all its neighbours, as N-H of i to O of j and N-H of j to O of i */
+
+      hbond_energies(backbone, i, neighbour, neighbours_total, energy_given, energy_taken);
+
+      for(k=0;k<neighbours_total;k++)
+      {
+         j=neighbour[k];
+
+         keep_hbond(backbone, i, j, energy_given[k]);
+
+         if(j!=i+1) keep_hbond(backbone, j, i, energy_taken[k]);
+      }
+   }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to order residue numbers */
+int compare_residues(const void *a, const void *b)
+{
+   return *(const int *)a-*(const int *)b;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to work out the DSSP hydrogen bond energies of residue i with each of its neighbours, i giving the bond */
+/* (its N-H to their O) into given and taking it into taken. The energies come from the hydrogen bond kernel, and */
+/* are rounded to 0.001 and no lower than HBOND_ENERGY_MIN, and a proline gives no bonds */
+void hbond_energies(struct BACKBONE *backbone, int i, int *neighbour, int neighbours_total, double *given, double *taken)
+{
+   /* Variables */
+
+   int k;
+
+
+   hbond_kernel(backbone, i, neighbour, neighbours_total, given, taken);
+
+   for(k=0;k<neighbours_total;k++)
+   {
+      given[k]=round(given[k]*1000)/1000;
+      given[k]=(given[k]<HBOND_ENERGY_MIN) ? HBOND_ENERGY_MIN : given[k];
+
+      taken[k]=round(taken[k]*1000)/1000;
+      taken[k]=(taken[k]<HBOND_ENERGY_MIN) ? HBOND_ENERGY_MIN : taken[k];
+
+      if(backbone->letter[neighbour[k]]=='P') taken[k]=0.0;
+   }
+
+   if(backbone->letter[i]=='P')
+   {
+      for(k=0;k<neighbours_total;k++) given[k]=0.0;
+   }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to pick the hydrogen bond kernel, AVX2 when the processor has it (built with -DSCALAR_KERNEL, */
+/* the scalar one is always used) */
+void choose_hbond_kernel(void)
+{
+   hbond_kernel=hbond_scalar;
+
+#ifdef X86_KERNELS
+   __builtin_cpu_init();
+
+   if(__builtin_cpu_supports("avx2")) hbond_kernel=hbond_avx2;
+#endif
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to work out the hydrogen bond energies of a residue with its neighbours, one at a time */
+void hbond_scalar(struct BACKBONE *backbone, int i, const int *neighbour, int neighbours_total, double *given, double *taken)
+{
+   /* Variables */
+
+   double n[3],h[3],c[3],o[3];
+   double dho,dhc,dnc,dno;
+   double ho,hc,nc,no;
+   int j,k;
+
+
+   for(k=0;k<3;k++)
+   {
+      n[k]=backbone->n[i][k];
+      h[k]=backbone->h[i][k];
+      c[k]=backbone->c[i][k];
+      o[k]=backbone->o[i][k];
+   }
+
+   for(k=0;k<neighbours_total;k++)
+   {
+      j=neighbour[k];
+
+      /* i gives the bond */
+
+      dho=sqrt(SQR(h[0]-backbone->o[j][0])+SQR(h[1]-backbone->o[j][1])+SQR(h[2]-backbone->o[j][2]));
+      dhc=sqrt(SQR(h[0]-backbone->c[j][0])+SQR(h[1]-backbone->c[j][1])+SQR(h[2]-backbone->c[j][2]));
+      dnc=sqrt(SQR(n[0]-backbone->c[j][0])+SQR(n[1]-backbone->c[j][1])+SQR(n[2]-backbone->c[j][2]));
+      dno=sqrt(SQR(n[0]-backbone->o[j][0])+SQR(n[1]-backbone->o[j][1])+SQR(n[2]-backbone->o[j][2]));
+
+      given[k]=HBOND_COUPLING/dho-HBOND_COUPLING/dhc+HBOND_COUPLING/dnc-HBOND_COUPLING/dno;
+      given[k]=((dho<HBOND_DISTANCE_MIN) || (dhc<HBOND_DISTANCE_MIN) || (dnc<HBOND_DISTANCE_MIN) || (dno<HBOND_DISTANCE_MIN)) ? HBOND_ENERGY_MIN : given[k];
+
+      /* j gives the bond */
+
+      ho=sqrt(SQR(backbone->h[j][0]-o[0])+SQR(backbone->h[j][1]-o[1])+SQR(backbone->h[j][2]-o[2]));
+      hc=sqrt(SQR(backbone->h[j][0]-c[0])+SQR(backbone->h[j][1]-c[1])+SQR(backbone->h[j][2]-c[2]));
+      nc=sqrt(SQR(backbone->n[j][0]-c[0])+SQR(backbone->n[j][1]-c[1])+SQR(backbone->n[j][2]-c[2]));
+      no=sqrt(SQR(backbone->n[j][0]-o[0])+SQR(backbone->n[j][1]-o[1])+SQR(backbone->n[j][2]-o[2]));
+
+      taken[k]=HBOND_COUPLING/ho-HBOND_COUPLING/hc+HBOND_COUPLING/nc-HBOND_COUPLING/no;
+      taken[k]=((ho<HBOND_DISTANCE_MIN) || (hc<HBOND_DISTANCE_MIN) || (nc<HBOND_DISTANCE_MIN) || (no<HBOND_DISTANCE_MIN)) ? HBOND_ENERGY_MIN : taken[k];
+   }
+}
+
+#ifdef X86_KERNELS
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to work out the hydrogen bond energies of a residue with its neighbours, gathering four at a time. */
+/* The distances and energies are summed in the same order as in hbond_scalar(), so the results are the same */
+__attribute__((target("avx2")))
+void hbond_avx2(struct BACKBONE *backbone, int i, const int *neighbour, int neighbours_total, double *given, double *taken)
+{
+   /* Variables */
+
+   double (*point[8])[3];
+   double (*atom[8])[3];
+   int d,k,l;
+   __m256d vpoint[8][3];
+   __m256d diff[3];
+   __m256d distance[8];
+   __m256d coupling,distance_min,energy_min;
+   __m256d energy,close;
+   __m128i index;
+
+
+   /* the distances H-O, H-C, N-C and N-O with i giving the bond, then with i taking it */
+
+   point[0]=backbone->h; atom[0]=backbone->o;
+   point[1]=backbone->h; atom[1]=backbone->c;
+   point[2]=backbone->n; atom[2]=backbone->c;
+   point[3]=backbone->n; atom[3]=backbone->o;
+   point[4]=backbone->o; atom[4]=backbone->h;
+   point[5]=backbone->c; atom[5]=backbone->h;
+   point[6]=backbone->c; atom[6]=backbone->n;
+   point[7]=backbone->o; atom[7]=backbone->n;
+
+   for(d=0;d<8;d++)
+   {
+      for(k=0;k<3;k++) vpoint[d][k]=_mm256_set1_pd(point[d][i][k]);
+   }
+
+   coupling=_mm256_set1_pd(HBOND_COUPLING);
+   distance_min=_mm256_set1_pd(HBOND_DISTANCE_MIN);
+   energy_min=_mm256_set1_pd(HBOND_ENERGY_MIN);
+
+   for(l=0; l+4<=neighbours_total; l+=4)
+   {
+      /* coordinates are three doubles a residue */
+
+      index=_mm_mullo_epi32(_mm_loadu_si128((const __m128i *)(neighbour+l)),_mm_set1_epi32(3));
+
+      for(d=0;d<8;d++)
+      {
+         for(k=0;k<3;k++) diff[k]=_mm256_sub_pd(vpoint[d][k],_mm256_i32gather_pd(&atom[d][0][k],index,8));
+
+         distance[d]=_mm256_sqrt_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(diff[0],diff[0]),_mm256_mul_pd(diff[1],diff[1])),_mm256_mul_pd(diff[2],diff[2])));
+      }
+
+      for(d=0;d<8;d+=4)
+      {
+         energy=_mm256_sub_pd(_mm256_div_pd(coupling,distance[d]),_mm256_div_pd(coupling,distance[d+1]));
+         energy=_mm256_add_pd(energy,_mm256_div_pd(coupling,distance[d+2]));
+         energy=_mm256_sub_pd(energy,_mm256_div_pd(coupling,distance[d+3]));
+
+         close=_mm256_or_pd(_mm256_cmp_pd(distance[d],distance_min,_CMP_LT_OQ),_mm256_cmp_pd(distance[d+1],distance_min,_CMP_LT_OQ));
+         close=_mm256_or_pd(close,_mm256_cmp_pd(distance[d+2],distance_min,_CMP_LT_OQ));
+         close=_mm256_or_pd(close,_mm256_cmp_pd(distance[d+3],distance_min,_CMP_LT_OQ));
+
+         _mm256_storeu_pd((d ? taken : given)+l,_mm256_blendv_pd(energy,energy_min,close));
+      }
+   }
+
+   hbond_scalar(backbone,i,neighbour+l,neighbours_total-l,given+l,taken+l);
+}
+
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to keep a hydrogen bond from the N-H of donor to the O of acceptor if it is among the two strongest */
+/* of each, the first found winning a tie */
+void keep_hbond(struct BACKBONE *backbone, int donor, int acceptor, double energy)
+{
+   /* Variables */
+
+   struct HBOND *bond;
+
+
+   bond=backbone->acceptor[donor];
+
+   if(energy<bond[0].energy)
+   {
+      bond[1]=bond[0];
+      bond[0].residue=acceptor;
+      bond[0].energy=energy;
+   }
+   else if(energy<bond[1].energy)
+   {
+      bond[1].residue=acceptor;
+      bond[1].energy=energy;
+   }
+
+   bond=backbone->donor[acceptor];
+
+   if(energy<bond[0].energy)
+   {
+      bond[1]=bond[0];
+      bond[0].residue=donor;
+      bond[0].energy=energy;
+   }
+   else if(energy<bond[1].energy)
+   {
+      bond[1].residue=donor;
+      bond[1].energy=energy;
+   }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to tell whether the N-H of residue a is hydrogen bonded to the O of residue b */
+int test_bond(struct BACKBONE *backbone, int a, int b)
+{
+   return ((backbone->acceptor[a][0].residue==b) && (backbone->acceptor[a][0].energy<HBOND_ENERGY_MAX)) ||
+          ((backbone->acceptor[a][1].residue==b) && (backbone->acceptor[a][1].energy<HBOND_ENERGY_MAX));
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to tell whether residues a to b follow on with no break in the chain */
+int no_break(struct BACKBONE *backbone, int a, int b)
+{
+   return backbone->number[b]-backbone->number[a]==b-a;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to tell the kind of bridge between residues i and j (i>0, j<residues_total-1) as DSSP does: */
+/* BRIDGE_PARALLEL, BRIDGE_ANTIPARALLEL or BRIDGE_NONE */
+int test_bridge(struct BACKBONE *backbone, int i, int j)
+{
+   if((!no_break(backbone, i-1, i+1)) || (!no_break(backbone, j-1, j+1))) return BRIDGE_NONE;
+
+   if((test_bond(backbone, i+1, j) && test_bond(backbone, j, i-1)) || (test_bond(backbone, j+1, i) && test_bond(backbone, i, j-1))) return BRIDGE_PARALLEL;
+
+   if((test_bond(backbone, i+1, j-1) && test_bond(backbone, j+1, i-1)) || (test_bond(backbone, j, i) && test_bond(backbone, i, j))) return BRIDGE_ANTIPARALLEL;
+
+   return BRIDGE_NONE;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to find the beta bridges and ladders of a protein as DSSP does, marking their residues E (ladders */
+/* of more than one bridge) or B (lone bridges) in structure_type; the other residues are left blank. Only pairs */
+/* of residues that some hydrogen bond could bridge are tested, in the order DSSP tests all pairs */
+void beta_bridges(struct BACKBONE *backbone, char *structure_type)
+{
+   /* Variables */
+
+   struct BRIDGE *bridge;
+   long long *pair;
+   int pairs_total=0;
+   int bridges_total=0;
+   int n,a,b,d,i,j,k,m,r,type;
+   int offsets[8][2]={{-1,0},{1,0},{0,-1},{0,1},{-1,1},{1,-1},{0,0},{0,0}};
+   int swapped[8]={0,1,1,0,0,1,1,0};
+   unsigned int ibi,iei,jbi,jei,ibj,iej,jbj,jej;
+   int bulge;
+
+
+   n=backbone->residues_total;
+
+   for(r=0;r<n;r++) structure_type[r]=' ';
+
+   structure_type[n]='\0';
+
+   /* a bridge of i and j rests on hydrogen bonds among i-1..i+1 and j-1..j+1; from each bond d to a, the */
+   /* pairs it could take part in are (d-1, a), (a+1, d), (a, d-1), (d, a+1), (d-1, a+1), (a+1, d-1), (a, d), (d, a) */
+
+   if((pair=(long long *) arena_alloc(backbone->arena,(16*n+1)*sizeof(long long)))==NULL) return;
+
+   for(d=0;d<n;d++)
+   {
+      for(m=0;m<2;m++)
+      {
+         if((backbone->acceptor[d][m].residue<0) || (backbone->acceptor[d][m].energy>=HBOND_ENERGY_MAX)) continue;
+
+         a=backbone->acceptor[d][m].residue;
+
+         for(k=0;k<8;k++)
+         {
+            i=((swapped[k]) ? a : d)+offsets[k][0];
+            j=((swapped[k]) ? d : a)+offsets[k][1];
+
+            if((i>=1) && (i+4<n) && (j>=i+3) && (j+1<n)) pair[pairs_total++]=(long long)i*n+j;
+         }
+      }
+   }
+
+   qsort(pair,pairs_total,sizeof(long long),compare_pairs);
+
+   if((bridge=(struct BRIDGE *) arena_alloc(backbone->arena,(pairs_total+1)*sizeof(struct BRIDGE)))==NULL) return;
+
+   for(k=0;k<pairs_total;k++)
+   {
+      if((k>0) && (pair[k]==pair[k-1])) continue;
+
+      i=(int)(pair[k]/n);
+      j=(int)(pair[k]%n);
+
+      if((type=test_bridge(backbone, i, j))==BRIDGE_NONE) continue;
+
+      /* a bridge that carries on a ladder is added to it */
+
+      for(b=0;b<bridges_total;b++)
+      {
+         if((type!=bridge[b].type) || (i!=bridge[b].i_back+1)) continue;
+
+         if((type==BRIDGE_PARALLEL) && (bridge[b].j_back+1==j))
+         {
+            bridge[b].i_back=i;
+            bridge[b].j_back=j;
+            bridge[b].length++;
+            break;
+         }
+
+         if((type==BRIDGE_ANTIPARALLEL) && (bridge[b].j_front-1==j))
+         {
+            bridge[b].i_back=i;
+            bridge[b].j_front=j;
+            bridge[b].length++;
+            break;
+         }
+      }
+
+      if(b==bridges_total)
+      {
+         bridge[b].type=type;
+         bridge[b].chain=backbone->chain[i];
+         bridge[b].order=b;
+         bridge[b].i_front=i;
+         bridge[b].i_back=i;
+         bridge[b].j_front=j;
+         bridge[b].j_back=j;
+         bridge[b].length=1;
+         bridges_total++;
+      }
+   }
+
+   /* ladders a short way apart are joined across a bulge, with the unsigned sums of DSSP */
+
+   qsort(bridge,bridges_total,sizeof(struct BRIDGE),compare_bridges);
+
+   for(a=0;a<bridges_total;a++)
+   {
+      for(b=a+1;b<bridges_total;b++)
+      {
+         ibi=bridge[a].i_front;
+         iei=bridge[a].i_back;
+         jbi=bridge[a].j_front;
+         jei=bridge[a].j_back;
+         ibj=bridge[b].i_front;
+         iej=bridge[b].i_back;
+         jbj=bridge[b].j_front;
+         jej=bridge[b].j_back;
+
+         if((bridge[a].type!=bridge[b].type) ||
+            (backbone->chain[(ibi<ibj) ? ibi : ibj]!=backbone->chain[(iei>iej) ? iei : iej]) ||
+            (backbone->chain[(jbi<jbj) ? jbi : jbj]!=backbone->chain[(jei>jej) ? jei : jej]) ||
+            (ibj-iei>=6) || ((iei>=ibj) && (ibi<=iej))) continue;
+
+         if(bridge[a].type==BRIDGE_PARALLEL) bulge=((jbj-jei<6) && (ibj-iei<3)) || (jbj-jei<3);
+         else bulge=((jbi-jej<6) && (ibj-iei<3)) || (jbi-jej<3);
+
+         if(!bulge) continue;
+
+         bridge[a].i_back=bridge[b].i_back;
+
+         if(bridge[a].type==BRIDGE_PARALLEL) bridge[a].j_back=bridge[b].j_back;
+         else bridge[a].j_front=bridge[b].j_front;
+
+         bridge[a].length+=bridge[b].length;
+
+         for(k=b;k+1<bridges_total;k++) bridge[k]=bridge[k+1];
+
+         bridges_total--;
+         b--;
+      }
+   }
+
+   for(b=0;b<bridges_total;b++)
+   {
+      for(r=bridge[b].i_front;r<=bridge[b].i_back;r++)
+      {
+         if(structure_type[r]!='E') structure_type[r]=(bridge[b].length>1) ? 'E' : 'B';
+      }
+
+      for(r=bridge[b].j_front;r<=bridge[b].j_back;r++)
+      {
+         if(structure_type[r]!='E') structure_type[r]=(bridge[b].length>1) ? 'E' : 'B';
+      }
+   }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to order residue pairs */
+int compare_pairs(const void *a, const void *b)
+{
+   if(*(const long long *)a<*(const long long *)b) return -1;
+   if(*(const long long *)a>*(const long long *)b) return 1;
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to order bridges by chain and first residue, as DSSP does before joining ladders */
+int compare_bridges(const void *a, const void *b)
+{
+   const struct BRIDGE *bridge1=(const struct BRIDGE *)a;
+   const struct BRIDGE *bridge2=(const struct BRIDGE *)b;
+
+   if(bridge1->chain!=bridge2->chain) return (unsigned char) bridge1->chain-(unsigned char) bridge2->chain;
+
+   if(bridge1->i_front!=bridge2->i_front) return bridge1->i_front-bridge2->i_front;
+
+   return bridge1->order-bridge2->order;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to mark the helices of a protein in structure_type as DSSP does: an n-turn at i is a bond from the */
+/* N-H of i+n to the O of i, two n-turns in a row start a helix over the next n residues. Alpha helices (H) are */
+/* marked first and over anything, then 3-10 (G) and pi (I) helices only where nothing else is */
+void helix_structure(struct BACKBONE *backbone, char *structure_type)
+{
+   /* Variables */
+
+   char *flag[6];
+   int n,i,j,stride;
+   int empty;
+   char helix_type[6]={' ', ' ', ' ', 'G', 'H', 'I'};
+
+
+   n=backbone->residues_total;
+
+   for(stride=3;stride<=5;stride++)
+   {
+      if((flag[stride]=(char *) arena_alloc(backbone->arena,(n+1)*sizeof(char)))==NULL) return;
+
+      for(i=0;i+stride<n;i++)
+      {
+         if((!no_break(backbone, i, i+stride)) || (!test_bond(backbone, i+stride, i))) continue;
+
+         flag[stride][i+stride]|=TURN_END;
+
+         for(j=i+1;j<i+stride;j++)
+         {
+            if(!flag[stride][j]) flag[stride][j]=TURN_MIDDLE;
+         }
+
+         flag[stride][i]|=TURN_START;
+         flag[stride][i]&=~TURN_MIDDLE;
+      }
+   }
+
+   for(i=1;i+4<n;i++)
+   {
+      if((flag[4][i]&TURN_START) && (flag[4][i-1]&TURN_START))
+      {
+         for(j=i;j<=i+3;j++) structure_type[j]='H';
+      }
+   }
+
+   for(stride=3;stride<=5;stride+=2)
+   {
+      for(i=1;i+stride<n;i++)
+      {
+         if((!(flag[stride][i]&TURN_START)) || (!(flag[stride][i-1]&TURN_START))) continue;
+
+         for(j=i,empty=1;(empty) && (j<i+stride);j++) empty=(structure_type[j]==' ') || (structure_type[j]==helix_type[stride]);
+
+         if(!empty) continue;
+
+         for(j=i;j<i+stride;j++) structure_type[j]=helix_type[stride];
+      }
+   }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to fill a helix record with junk for debugging, its residue slots starting at offset */
+void init_helix(struct HELIX *helix, int offset, char *residues, float *residue_numbers)
+{
+   helix->residues_total=-1;
+   helix->helix_no=-1;
+   helix->atoms_total=-1;
+   helix->max_bending_angle=0;
+   helix->chain='Z';
+   helix->geometry='S';
+   helix->offset=offset;
+
+   residues[offset]='\0';
+   residue_numbers[offset]=-1;
+   residue_numbers[offset+1]=-1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to start the helix record i once helix i-1 is complete, growing the helix and slot arrays as needed; */
+/* NULL if there is no memory for them */
+struct HELIX* next_helix(struct HELIX *helix, int i, int *helices_max, char **residues, float **residue_numbers, int *slots_max, struct ARENA *arena)
+{
+   /* Variables */
+
+   int offset;
+
+
+   if(i==*helices_max)
+   {
+      if((helix=(struct HELIX *) arena_realloc(arena,helix,*helices_max*sizeof(struct HELIX),2*(*helices_max)*sizeof(struct HELIX)))==NULL) return NULL;
+      *helices_max*=2;
+   }
+
+   /* helix i starts after the residues of helix i-1 and their spare slot */
+
+   offset=helix[i-1].offset+helix[i-1].residues_total+1;
+
+   if(offset+2>*slots_max)
+   {
+      *residues=(char *) arena_realloc(arena,*residues,*slots_max*sizeof(char),2*(*slots_max)*sizeof(char));
+      *residue_numbers=(float *) arena_realloc(arena,*residue_numbers,*slots_max*sizeof(float),2*(*slots_max)*sizeof(float));
+      *slots_max*=2;
+
+      if((*residues==NULL) || (*residue_numbers==NULL)) return NULL;
+   }
+
+   init_helix(&helix[i], offset, *residues, *residue_numbers);
+
+   return helix;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to read PDB file and get atom details if they are in the DSSP defined helices */
+/* the atoms go into an atom store that grows as they are read */
+struct ATOMSTORE* read_atom(struct TEXTINPUT *pdb, struct HELIX *helix, int *helices_total, int *helices_atom_total, struct ARENA *arena)
+{
+   /* Variables */
+
+   struct ATOMSTORE *atoms;
+   struct HELIXWALK walk;
+   struct LINEVIEW view;
+   const char *line;
+   const char *record;
+   char resname[4];
+   char chain;
+   float current_residue_number=-1.5;
+   int a,k;
+   int length;
+
+
+   if((atoms=start_walk(&walk, *helices_total, arena))==NULL) return NULL;
+
+   /* the lines are taken as fgets() took them, but decoded where they lie in the input */
+
+   memset(&view, 0, sizeof(struct LINEVIEW));
+
+   view.columns=PDB_COLUMNS;
+   view.zero_column=-1;
+
+   /* Read input file until all helices are completed */
+
+   while(!pdb->end && ((view.line==NULL) || strncmp(view.line,"END",3)))
+   {
+      if((length=next_record(pdb, LINLEN, &record))>=0) view_line(&view, record, length, 1);
+
+      if((line=view.line)==NULL) continue;
+
+      /* If record name is ATOM or HETATM and the atom name is not H ... */
+
+      if((line[13]!='H') && (!strncmp(line,"ATOM  ",6) || !strncmp(line,"HETATM",6)))
+      {
+         chain=line[21];
+
+         if(chain==' ')
+         {
+            chain='0';
+            zero_column(&view, 21);
+         }
+
+         for(k=0;k<3;k++) resname[k]=line[k+17];	
+         resname[3]='\0';
+
+         /* if the chain is right and the residue is not a water molecule */
+
+         if((chain==helix[walk.i].chain) && (strcmp(resname,"HOH")))        
+         {
+            /* current residue number from PDB atom list */
+            /* e.g. residue 1 becomes 1.00 */
+
+            current_residue_number=decode_number(line+22, 5);
+
+            /* add the residue sub-label if it exists, this converts residue 1A into 1.01, residue 1Z into 1.26 etc. */
+
+            current_residue_number+=insertion_number(line[26]);
+
+            /* For start or within helix, where PDB residue number equals helix residue number */
+
+            if(walk_residue(&walk, helix, current_residue_number))
+            {
+               if((a=add_atom(atoms))<0) return NULL;
+
+               /* atom_number */
+
+               atoms->atom_number[a]=decode_integer(line+6, 5);
+	
+               /* atom name */
+
+               for(k=0;k<4;k++) atoms->atom_name[a][k]=line[k+12];
+	
+               atoms->atom_name[a][4]='\0';
+
+               /* residue name, and the element, class, donor and charge that follow from the names */
+        
+               strcpy(atoms->residue_name[a],resname);
+
+               type_atom(atoms, a);
+
+               /* chain */
+
+               atoms->chain[a]=chain;
+                  	
+               /* residue number, and its index in the helix */
+
+               atoms->residue_number[a]=current_residue_number;
+               atoms->residue[a]=walk.j;
+
+               /* co-ordinates, each read from 9 columns as ever (the 8 of the field and the one after) */
+
+               atoms->x[a]=decode_number(line+30, 9);
+               atoms->y[a]=decode_number(line+38, 9);
+               atoms->z[a]=decode_number(line+46, 9);
+
+               walk_atom(&walk, current_residue_number);
+            }
+
+            /* when all helices are completed */
+
+            if(walk_on(&walk, helix, atoms, *helices_total, current_residue_number))
+            {
+               break;
+            }            
+         }
+      }
+   }
+
+  end_walk(&walk, atoms, *helices_total, helices_atom_total);
+
+  return atoms;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to start a walk through the DSSP helices and the atom store that it fills, NULL if there is no memory for it */
+struct ATOMSTORE* start_walk(struct HELIXWALK *walk, int helices_total, struct ARENA *arena)
+{
+   /* Variables */
+
+   struct ATOMSTORE *atoms;
+
+
+   memset(walk, 0, sizeof(struct HELIXWALK));
+
+   walk->last_residue_in_helix=-1.5;
+
+   if((atoms=(struct ATOMSTORE *) arena_alloc(arena,sizeof(struct ATOMSTORE)))==NULL) return NULL;
+
+   atoms->arena=arena;
+
+   if((atoms->helix_start=(int *) arena_alloc(arena,(helices_total+1)*sizeof(int)))==NULL) return NULL;
+
+   return atoms;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to tell whether an atom of the chain of the current helix, from residue current_residue_number, */
+/* belongs to the helix residue the walk is at, moving on to the next residue of the helix first if the atom is from it */
+int walk_residue(struct HELIXWALK *walk, struct HELIX *helix, float current_residue_number)
+{
+   /* For within a helix, where j (helix residue number) must be incremented before assignments to atom variables are made */
+
+   if((current_residue_number==helix[walk->i].residue_numbers[walk->j+1]) && (walk->last_residue_in_helix==helix[walk->i].residue_numbers[walk->j]))
+   {
+      walk->j++;
+   }
+
+   return current_residue_number==helix[walk->i].residue_numbers[walk->j];
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to count an atom added to the store for the helix residue the walk is at */
+void walk_atom(struct HELIXWALK *walk, float current_residue_number)
+{
+   walk->last_residue_in_helix=current_residue_number; /* update last residue number in helix */
+
+   walk->m++;    /* m represents total atoms in a helix */
+
+   walk->n++;    /* n represents total atoms in all helices */
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to move the walk on past an atom of the chain of the current helix. Returns 1 once all helices are completed */
+int walk_on(struct HELIXWALK *walk, struct HELIX *helix, struct ATOMSTORE *atoms, int helices_total, float current_residue_number)
+{
+   /* for a search for the start of another helix */ 
+
+   if((current_residue_number!=helix[walk->i].residue_numbers[walk->j]) && (walk->last_residue_in_helix==helix[walk->i].residue_numbers[walk->j]))
+   {
+      walk->j++;
+   }
+
+   /* when a helix is at an end */
+
+   if(walk->j==helix[walk->i].residues_total)
+   {
+      helix[walk->i].atoms_total=walk->m;
+      walk->i++;
+      walk->j=0;  
+      walk->m=0; 
+      atoms->helix_start[walk->i]=walk->n;
+   }
+
+   return walk->i==helices_total;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to end a walk, whether or not all the helices were reached */
+void end_walk(struct HELIXWALK *walk, struct ATOMSTORE *atoms, int helices_total, int *helices_atom_total)
+{
+   /* Variables */
+
+   int i;
+
+
+   /* helices that were never reached start (empty) after the last atom read */
+
+   for(i=walk->i+1;i<=helices_total;i++) atoms->helix_start[i]=walk->n;
+
+   *helices_atom_total=walk->n;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to tell whether a structure input is mmCIF (PDBx), which starts with a data_ block, rather than PDB */
+int cif_text(struct TEXTINPUT *input)
+{
+   /* Variables */
+
+   struct TEXTINPUT peek;
+   const char *record;
+   int length;
+   int k;
+
+
+   /* the lines are looked at through a copy, so the input is still read from its start */
+
+   peek=*input;
+
+   while((length=next_record(&peek, LINLEN, &record))>=0)
+   {
+      for(k=0;(k<length) && (IS_SPACE(record[k]));k++);
+
+      if((k==length) || (record[k]=='#')) continue;
+
+      return (length-k>=5) && (!strncasecmp(record+k,"data_",5));
+   }
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to take the next token of an mmCIF input: a bare word, a quoted string or a text field between */
+/* lines starting with ';'. Returns its length and sets token and quoted, or -1 when nothing is left. Tokens are */
+/* left where they lie in the input, which never moves while it is read */
+int cif_token(struct CIFREADER *cif, const char **token, int *quoted)
+{
+   /* Variables */
+
+   const char *record;
+   const char *start;
+   char c;
+   int length;
+   int k;
+
+
+   for(;;)
+   {
+      if(cif->next>=cif->length)
+      {
+         if((length=next_record(cif->input, CIF_LINLEN, &record))<0) return -1;
+
+         while((length>0) && ((record[length-1]=='\n') || (record[length-1]=='\r'))) length--;
+
+         cif->line=record;
+         cif->length=length;
+         cif->next=0;
+
+         /* a text field runs from here to the next line that starts with ';' */
+
+         if((length>0) && (record[0]==';'))
+         {
+            start=record+1;
+
+            while(((length=next_record(cif->input, CIF_LINLEN, &record))>=0) && (record[0]!=';'));
+
+            if(length<0)
+            {
+               *token=start;
+               *quoted=1;
+               cif->length=0;
+               return cif->input->text+cif->input->next-start;
+            }
+
+            while((length>0) && ((record[length-1]=='\n') || (record[length-1]=='\r'))) length--;
+
+            cif->line=record;
+            cif->length=length;
+            cif->next=1;
+
+            *token=start;
+            *quoted=1;
+
+            /* the newline before the closing ';' is not part of the field */
+
+            for(k=record-start;(k>0) && ((start[k-1]=='\n') || (start[k-1]=='\r'));k--);
+
+            return k;
+         }
+
+         continue;
+      }
+
+      while((cif->next<cif->length) && (IS_SPACE(cif->line[cif->next]))) cif->next++;
+
+      if(cif->next==cif->length) continue;
+
+      c=cif->line[cif->next];
+
+      /* a comment runs to the end of the line */
+
+      if(c=='#')
+      {
+         cif->next=cif->length;
+         continue;
+      }
+
+      /* a quote only closes a string when a space or the end of the line follows it, so O5' can be written 'O5'' */
+
+      if((c=='\'') || (c=='"'))
+      {
+         for(k=cif->next+1;k<cif->length;k++)
+         {
+            if((cif->line[k]==c) && ((k+1==cif->length) || (IS_SPACE(cif->line[k+1])))) break;
+         }
+
+         *token=cif->line+cif->next+1;
+         *quoted=1;
+
+         length=k-cif->next-1;
+
+         cif->next=(k<cif->length) ? k+1 : k;
+
+         return length;
+      }
+
+      for(k=cif->next;(k<cif->length) && (!IS_SPACE(cif->line[k]));k++);
+
+      *token=cif->line+cif->next;
+      *quoted=0;
+
+      length=k-cif->next;
+
+      cif->next=k;
+
+      return length;
+   }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to tell whether a bare mmCIF token is a data name or a keyword, which ends a loop */
+int cif_keyword(const char *token, int length)
+{
+   if((length>0) && (token[0]=='_')) return 1;
+
+   if((length>=5) && ((!strncasecmp(token,"loop_",5)) || (!strncasecmp(token,"data_",5)) || (!strncasecmp(token,"save_",5)) || (!strncasecmp(token,"stop_",5)))) return 1;
+
+   if((length>=7) && (!strncasecmp(token,"global_",7))) return 1;
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to tell whether a field of an atom_site row is given, '.' and '?' standing for a value that is left out or unknown */
+int cif_value(struct CIFROW *row, int field)
+{
+   if(row->value[field]==NULL) return 0;
+
+   return (row->quoted[field]) || (row->length[field]!=1) || ((row->value[field][0]!='.') && (row->value[field][0]!='?'));
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to decode a number from a field of an atom_site row as from a PDB field, 0 for a value that is not there */
+double cif_number(struct CIFROW *row, int field)
+{
+   if(row->value[field]==NULL) return 0.0;
+
+   return decode_number(row->value[field], (row->length[field]<LINLEN) ? row->length[field] : LINLEN-1);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to find the header of the atom_site loop of an mmCIF input, and the field taken from each of its columns. */
+/* Returns the number of columns, 0 if there is no atom_site loop */
+int cif_atom_site(struct CIFREADER *cif, struct ARENA *arena)
+{
+   /* Variables */
+
+   int columns_max=0;
+   int in_loop=0;
+   int f;
+
+
+   while((cif->token_length=cif_token(cif, &cif->token, &cif->token_quoted))>=0)
+   {
+      if((in_loop) && (!cif->token_quoted) && (cif->token_length>11) && (!strncasecmp(cif->token,"_atom_site.",11)))
+      {
+         if(cif->columns_total==columns_max)
+         {
+            if((cif->column_field=(int *) arena_realloc(arena,cif->column_field,columns_max*sizeof(int),(columns_max+CIF_FIELDS)*sizeof(int)))==NULL) return 0;
+            columns_max+=CIF_FIELDS;
+         }
+
+         cif->column_field[cif->columns_total]=-1;
+
+         for(f=0;f<CIF_FIELDS;f++)
+         {
+            if((cif->token_length-11==(int) strlen(cif_field_name[f])) && (!strncasecmp(cif->token+11,cif_field_name[f],cif->token_length-11))) cif->column_field[cif->columns_total]=f;
+         }
+
+         cif->columns_total++;
+         continue;
+      }
+
+      /* the first value of the loop is kept for cif_row() */
+
+      if(cif->columns_total>0) break;
+
+      in_loop=(!cif->token_quoted) && (cif->token_length==5) && (!strncasecmp(cif->token,"loop_",5));
+   }
+
+   cif->first_model=-1;
+
+   return cif->columns_total;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to take the next ATOM or HETATM row of the atom_site loop, the fields left where they lie in the input. */
+/* Returns 1, or 0 once the loop or the first model is at an end */
+int cif_row(struct CIFREADER *cif, struct CIFROW *row)
+{
+   /* Variables */
+
+   int column=0;
+   int model;
+   int f;
+
+
+   memset(row, 0, sizeof(struct CIFROW));
+
+   while((cif->columns_total>0) && (cif->token_length>=0) && ((cif->token_quoted) || (!cif_keyword(cif->token,cif->token_length))))
+   {
+      if((f=cif->column_field[column])>=0)
+      {
+         row->value[f]=cif->token;
+         row->length[f]=cif->token_length;
+         row->quoted[f]=cif->token_quoted;
+      }
+
+      cif->token_length=cif_token(cif, &cif->token, &cif->token_quoted);
+
+      if(++column<cif->columns_total) continue;
+
+      column=0;
+
+      /* as with a PDB file, only the first model is read */
+
+      if(cif_value(row, CIF_MODEL))
+      {
+         model=decode_integer(row->value[CIF_MODEL],row->length[CIF_MODEL]);
+
+         if(cif->first_model<0) cif->first_model=model;
+         else if(model!=cif->first_model) return 0;
+      }
+
+      if((row->value[CIF_GROUP]==NULL) || ((row->length[CIF_GROUP]==4) && (!strncmp(row->value[CIF_GROUP],"ATOM",4))) || ((row->length[CIF_GROUP]==6) && (!strncmp(row->value[CIF_GROUP],"HETATM",6)))) return 1;
+
+      memset(row, 0, sizeof(struct CIFROW));
+   }
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to read an mmCIF (PDBx) file and get atom details if they are in the DSSP defined helices. The atom_site */
+/* loop is read a row at a time, with its columns found by name from the loop header; as with a PDB file only the first */
+/* model is read, and the rest of the file is not read once all helices are completed */
+struct ATOMSTORE* read_cif_atoms(struct TEXTINPUT *cif, struct HELIX *helix, int *helices_total, int *helices_atom_total, struct ARENA *arena)
+{
+   /* Variables */
+
+   struct ATOMSTORE *atoms;
+   struct HELIXWALK walk;
+   struct CIFREADER reader;
+   struct CIFROW row;
+   char resname[4];
+   char atom_name[5];
+   char chain;
+   float current_residue_number;
+   int a;
+
+
+   if((atoms=start_walk(&walk, *helices_total, arena))==NULL) return NULL;
+
+   memset(&reader, 0, sizeof(struct CIFREADER));
+
+   reader.input=cif;
+
+   if(!cif_atom_site(&reader, arena))
+   {
+      end_walk(&walk, atoms, *helices_total, helices_atom_total);
+      return atoms;
+   }
+
+   while(cif_row(&reader, &row))
+   {
+      /* the atom is taken as it would be from its ATOM or HETATM line */
+
+      cif_atom_name(&row, atom_name);
+
+      cif_residue_name(&row, resname);
+
+      chain=cif_chain(&row);
+
+      /* If the atom name is not H, the chain is right and the residue is not a water molecule */
+
+      if((atom_name[1]!='H') && (chain==helix[walk.i].chain) && (strcmp(resname,"HOH")))
+      {
+         current_residue_number=cif_number(&row, (cif_value(&row, CIF_AUTH_SEQ)) ? CIF_AUTH_SEQ : CIF_LABEL_SEQ);
+
+         current_residue_number+=insertion_number(cif_insertion(&row));
+
+         if(walk_residue(&walk, helix, current_residue_number))
+         {
+            if((a=add_atom(atoms))<0) return NULL;
+
+            atoms->atom_number[a]=(row.value[CIF_ID]!=NULL) ? decode_integer(row.value[CIF_ID], row.length[CIF_ID]) : 0;
+
+            strcpy(atoms->atom_name[a],atom_name);
+            strcpy(atoms->residue_name[a],resname);
+
+            type_atom(atoms, a);
+
+            atoms->chain[a]=chain;
+
+            atoms->residue_number[a]=current_residue_number;
+            atoms->residue[a]=walk.j;
+
+            atoms->x[a]=cif_number(&row, CIF_X);
+            atoms->y[a]=cif_number(&row, CIF_Y);
+            atoms->z[a]=cif_number(&row, CIF_Z);
+
+            walk_atom(&walk, current_residue_number);
+         }
+
+         /* when all helices are completed */
+
+         if(walk_on(&walk, helix, atoms, *helices_total, current_residue_number)) break;
+      }
+   }
+
+   end_walk(&walk, atoms, *helices_total, helices_atom_total);
+
+   return atoms;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to lay out the atom name of an atom_site row in the four columns of a PDB file: from the first column */
+/* if it has four characters or a two letter element, from the second otherwise */
+void cif_atom_name(struct CIFROW *row, char *atom_name)
+{
+   /* Variables */
+
+   int f;
+   int k;
+   int start=1;
+
+
+   f=(cif_value(row, CIF_AUTH_ATOM)) ? CIF_AUTH_ATOM : CIF_LABEL_ATOM;
+
+   strcpy(atom_name,"    ");
+
+   if(!cif_value(row, f)) return;
+
+   if((row->length[f]>=4) || ((cif_value(row, CIF_TYPE)) && (row->length[CIF_TYPE]==2))) start=0;
+
+   for(k=0;(k<row->length[f]) && (start+k<4);k++) atom_name[start+k]=row->value[f][k];
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to lay out the residue name of an atom_site row in the three columns of a PDB file, to the right */
+void cif_residue_name(struct CIFROW *row, char *resname)
+{
+   /* Variables */
+
+   int f;
+   int k;
+   int length;
+
+
+   f=(cif_value(row, CIF_AUTH_COMP)) ? CIF_AUTH_COMP : CIF_LABEL_COMP;
+
+   strcpy(resname,"   ");
+
+   if(!cif_value(row, f)) return;
+
+   length=(row->length[f]<3) ? row->length[f] : 3;
+
+   for(k=0;k<length;k++) resname[3-length+k]=row->value[f][k];
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to get the chain of an atom_site row as a PDB file has it, '0' for none. A chain with a longer */
+/* name than the one column of a DSSP file gives '\0', which is no helix chain */
+char cif_chain(struct CIFROW *row)
+{
+   /* Variables */
+
+   int f;
+
+
+   f=(cif_value(row, CIF_AUTH_ASYM)) ? CIF_AUTH_ASYM : CIF_LABEL_ASYM;
+
+   if((!cif_value(row, f)) || (row->length[f]==0) || (row->value[f][0]==' ')) return '0';
+
+   return (row->length[f]==1) ? row->value[f][0] : '\0';
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to get the insertion code of an atom_site row as a PDB file has it, ' ' for none */
+char cif_insertion(struct CIFROW *row)
+{
+   if((!cif_value(row, CIF_INS_CODE)) || (row->length[CIF_INS_CODE]==0)) return ' ';
+
+   return row->value[CIF_INS_CODE][0];
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to turn an insertion code into the hundredths added to a residue number: residue 1A becomes 1.01, */
+/* residue 1Z 1.26 and so on, a blank or a digit adds nothing */
+float insertion_number(char res_sub_type)
+{
+   /* Variables */
+
+   float res_sub_number=0.0;
+
+
+   if((res_sub_type!=' ') && ((res_sub_type<'0') || (res_sub_type>'9')))
+   {
+      res_sub_number=res_sub_type-64;
+      res_sub_number=res_sub_number/100;
+   }
+
+   return res_sub_number;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to tell whether a structure input is in the binary format written by write_binary() */
+int binary_text(struct TEXTINPUT *input)
+{
+   wait_text(input, BINARY_MAGIC_SIZE);
+
+   return (input->size-input->next>=BINARY_MAGIC_SIZE) && (!memcmp(input->text+input->next,BINARY_MAGIC,BINARY_MAGIC_SIZE));
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to start decoding a binary structure input, which is taken whole. Returns 0, or -1 if its header */
+/* or tables do not fit in it */
+int open_binary(struct BINARYREADER *reader, struct TEXTINPUT *binary)
+{
+   /* Variables */
+
+   const unsigned char *data;
+   unsigned long long header[BINARY_COUNTS+BINARY_STREAMS];
+   size_t size;
+   size_t offset;
+   int k;
+
+
+   memset(reader, 0, sizeof(struct BINARYREADER));
+
+   /* a gzip file is first inflated to its end */
+
+   wait_text(binary, (size_t) -1);
+
+   data=(const unsigned char *) binary->text+binary->next;
+   size=binary->size-binary->next;
+
+   binary->next=binary->size;
+   binary->end=1;
+
+   if(size<BINARY_HEADER_SIZE) return -1;
+
+   for(k=0;k<BINARY_COUNTS+BINARY_STREAMS;k++) header[k]=get_u32(data+BINARY_MAGIC_SIZE+4*k);
+
+   /* the name tables and the columns must lie within the file */
+
+   offset=BINARY_HEADER_SIZE;
+
+   if(header[BINARY_NAMES]>(size-offset)/4) return -1;
+
+   reader->names=(const char *) data+offset;
+   offset+=4*header[BINARY_NAMES];
+
+   if(header[BINARY_RESNAMES]>(size-offset)/3) return -1;
+
+   reader->resnames=(const char *) data+offset;
+   offset+=3*header[BINARY_RESNAMES];
+
+   for(k=0;k<BINARY_STREAMS;k++)
+   {
+      if(header[BINARY_COUNTS+k]>size-offset) return -1;
+
+      reader->next[k]=data+offset;
+      offset+=header[BINARY_COUNTS+k];
+      reader->end[k]=data+offset;
+   }
+
+   reader->atoms_total=header[BINARY_ATOMS];
+   reader->names_total=header[BINARY_NAMES];
+   reader->resnames_total=header[BINARY_RESNAMES];
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to decode the next atom of a binary structure input, from all its columns side by side. Returns 1, */
+/* 0 when there are no more atoms, or -1 if a column is damaged */
+int next_binary(struct BINARYREADER *reader, struct ATOMSITE *site)
+{
+   /* Variables */
+
+   unsigned long long value;
+   long long delta;
+   int k;
+
+
+   if(reader->atoms_read==reader->atoms_total) return 0;
+
+   /* a residue run gives the residue of the atoms in it */
+
+   if(reader->run_atoms==0)
+   {
+      if((get_varint(&reader->next[BINARY_RESIDUE], reader->end[BINARY_RESIDUE], &reader->run_atoms)) || (reader->run_atoms==0)) return -1;
+      if((get_varint(&reader->next[BINARY_RESIDUE], reader->end[BINARY_RESIDUE], &value)) || (value>=reader->resnames_total)) return -1;
+      if(reader->next[BINARY_RESIDUE]==reader->end[BINARY_RESIDUE]) return -1;
+
+      memcpy(reader->resname, reader->resnames+3*value, 3);
+      reader->resname[3]='\0';
+
+      reader->chain=(char) *reader->next[BINARY_RESIDUE]++;
+
+      if(get_signed(&reader->next[BINARY_RESIDUE], reader->end[BINARY_RESIDUE], &delta)) return -1;
+      if(reader->next[BINARY_RESIDUE]==reader->end[BINARY_RESIDUE]) return -1;
+
+      reader->seq+=delta;
+      reader->res_sub_type=(char) *reader->next[BINARY_RESIDUE]++;
+   }
+
+   reader->run_atoms--;
+   reader->atoms_read++;
+
+   if((get_varint(&reader->next[BINARY_NAME], reader->end[BINARY_NAME], &value)) || (value>=reader->names_total)) return -1;
+
+   memcpy(site->atom_name, reader->names+4*value, 4);
+   site->atom_name[4]='\0';
+
+   if(get_signed(&reader->next[BINARY_SERIAL], reader->end[BINARY_SERIAL], &delta)) return -1;
+
+   reader->serial+=delta;
+
+   for(k=0;k<3;k++)
+   {
+      if(get_signed(&reader->next[BINARY_X+k], reader->end[BINARY_X+k], &delta)) return -1;
+
+      reader->coordinate[k]+=delta;
+   }
+
+   site->serial=(int) reader->serial;
+   strcpy(site->resname, reader->resname);
+   site->chain=reader->chain;
+   site->seq=reader->seq;
+   site->res_sub_type=reader->res_sub_type;
+
+   /* the co-ordinates are kept in thousandths, which divide back to just what the text gave */
+
+   site->x=reader->coordinate[0]/1000.0;
+   site->y=reader->coordinate[1]/1000.0;
+   site->z=reader->coordinate[2]/1000.0;
+
+   return 1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to read a binary structure file and get atom details if they are in the DSSP defined helices, */
+/* the atoms decoded straight into the atom store. Returns NULL if the file is damaged */
+struct ATOMSTORE* read_binary_atoms(struct TEXTINPUT *binary, struct HELIX *helix, int *helices_total, int *helices_atom_total, struct ARENA *arena)
+{
+   /* Variables */
+
+   struct ATOMSTORE *atoms;
+   struct HELIXWALK walk;
+   struct BINARYREADER reader;
+   struct ATOMSITE site;
+   float current_residue_number;
+   int a;
+   int status;
+
+
+   if((atoms=start_walk(&walk, *helices_total, arena))==NULL) return NULL;
+
+   if(open_binary(&reader, binary)) return NULL;
+
+   while((status=next_binary(&reader, &site))>0)
+   {
+      /* If the atom name is not H, the chain is right and the residue is not a water molecule */
+
+      if((site.atom_name[1]!='H') && (site.chain==helix[walk.i].chain) && (strcmp(site.resname,"HOH")))
+      {
+         current_residue_number=site.seq;
+
+         current_residue_number+=insertion_number(site.res_sub_type);
+
+         if(walk_residue(&walk, helix, current_residue_number))
+         {
+            if((a=add_atom(atoms))<0) return NULL;
+
+            atoms->atom_number[a]=site.serial;
+
+            strcpy(atoms->atom_name[a],site.atom_name);
+            strcpy(atoms->residue_name[a],site.resname);
+
+            type_atom(atoms, a);
+
+            atoms->chain[a]=site.chain;
+
+            atoms->residue_number[a]=current_residue_number;
+            atoms->residue[a]=walk.j;
+
+            atoms->x[a]=site.x;
+            atoms->y[a]=site.y;
+            atoms->z[a]=site.z;
+
+            walk_atom(&walk, current_residue_number);
+         }
+
+         /* when all helices are completed */
+
+         if(walk_on(&walk, helix, atoms, *helices_total, current_residue_number)) break;
+      }
+   }
+
+   if(status<0) return NULL;
+
+   end_walk(&walk, atoms, *helices_total, helices_atom_total);
+
+   return atoms;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to write the atoms of a structure input in the binary format, as the readers would take them: the first */
+/* model up to the end, with no hydrogens or waters. The atom and residue names go into tables and are written as their */
+/* numbers, the residues as runs of atoms, and the atom serials, residue numbers and co-ordinates (in thousandths) as */
+/* differences from the one before; all numbers are variable length. Returns XHELIX_OK, or the error met */
+int write_binary(struct XHELIX *context, char *pdb_id, struct TEXTINPUT *structure, FILE *fp)
+{
+   /* Variables */
+
+   struct BINARYWRITER writer;
+   unsigned char header[BINARY_HEADER_SIZE];
+   int status;
+   int k;
+
+
+   memset(&writer, 0, sizeof(struct BINARYWRITER));
+
+   writer.arena=context->arena;
+
+   for(k=0;k<BINARY_STREAMS;k++) writer.stream[k].arena=context->arena;
+
+   status=structure_sites(structure, binary_site, &writer, context->arena);
+
+   if(text_failed(structure))
+   {
+      snprintf(context->message,MESSAGE_LENGTH,"Error decompressing the PDB file of %s",pdb_id);
+      return XHELIX_ERROR_INPUT;
+   }
+
+   if(status==-2)
+   {
+      snprintf(context->message,MESSAGE_LENGTH,"Error in the binary structure file of %s",pdb_id);
+      return XHELIX_ERROR_INPUT;
+   }
+
+   if(status==0) end_run(&writer);
+
+   if(context->arena->failed)
+   {
+      snprintf(context->message,MESSAGE_LENGTH,"** Error allocating %lu bytes of memory!",(unsigned long) context->arena->failed);
+      return XHELIX_ERROR_STRUCTURE;
+   }
+
+   if(status)
+   {
+      snprintf(context->message,MESSAGE_LENGTH,"Co-ordinates or residue numbers of %s cannot be written exactly in binary",pdb_id);
+      return XHELIX_ERROR_STRUCTURE;
+   }
+
+   memcpy(header, BINARY_MAGIC, BINARY_MAGIC_SIZE);
+
+   put_u32(header+BINARY_MAGIC_SIZE+4*BINARY_ATOMS, writer.atoms_total);
+   put_u32(header+BINARY_MAGIC_SIZE+4*BINARY_NAMES, writer.names_total);
+   put_u32(header+BINARY_MAGIC_SIZE+4*BINARY_RESNAMES, writer.resnames_total);
+
+   for(k=0;k<BINARY_STREAMS;k++) put_u32(header+BINARY_MAGIC_SIZE+4*(BINARY_COUNTS+k), writer.stream[k].size);
+
+   fwrite(header, 1, BINARY_HEADER_SIZE, fp);
+   fwrite(writer.name, 4, writer.names_total, fp);
+   fwrite(writer.resname, 3, writer.resnames_total, fp);
+
+   for(k=0;k<BINARY_STREAMS;k++) fwrite(writer.stream[k].data, 1, writer.stream[k].size, fp);
+
+   if(ferror(fp))
+   {
+      snprintf(context->message,MESSAGE_LENGTH,"Error writing the binary structure file of %s",pdb_id);
+      return XHELIX_ERROR_OUTPUT;
+   }
+
+   return XHELIX_OK;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to hand every atom of a PDB, mmCIF or binary structure input to site(), as the readers would take them: */
+/* the first model up to the end, with no hydrogens or waters. Returns 0, -1 if site() did, or -2 for a damaged binary input */
+int structure_sites(struct TEXTINPUT *structure, int (*site)(void*, struct ATOMSITE*), void *data, struct ARENA *arena)
+{
+   /* Variables */
+
+   struct BINARYREADER reader;
+   struct ATOMSITE atom;
+   int status;
+
+
+   if(binary_text(structure))
+   {
+      if(open_binary(&reader, structure)) return -2;
+
+      while((status=next_binary(&reader, &atom))>0)
+      {
+         if((atom.atom_name[1]=='H') || (!strcmp(atom.resname,"HOH"))) continue;
+
+         if(site(data, &atom)) return -1;
+      }
+
+      return (status<0) ? -2 : 0;
+   }
+
+   if(cif_text(structure)) return cif_sites(structure, site, data, arena);
+
+   return pdb_sites(structure, site, data);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to hand the atoms of a PDB input to site(), line by line as read_atom() takes them. Returns 0, or -1 if site() did */
+int pdb_sites(struct TEXTINPUT *pdb, int (*site)(void*, struct ATOMSITE*), void *data)
+{
+   /* Variables */
+
+   struct LINEVIEW view;
+   struct ATOMSITE atom;
+   const char *line;
+   const char *record;
+   int k;
+   int length;
+
+
+   memset(&view, 0, sizeof(struct LINEVIEW));
+
+   view.columns=PDB_COLUMNS;
+   view.zero_column=-1;
+
+   while(!pdb->end && ((view.line==NULL) || strncmp(view.line,"END",3)))
+   {
+      if((length=next_record(pdb, LINLEN, &record))>=0) view_line(&view, record, length, 1);
+
+      if((line=view.line)==NULL) continue;
+
+      if((line[13]!='H') && (!strncmp(line,"ATOM  ",6) || !strncmp(line,"HETATM",6)))
+      {
+         atom.chain=line[21];
+
+         if(atom.chain==' ')
+         {
+            atom.chain='0';
+            zero_column(&view, 21);
+         }
+
+         for(k=0;k<3;k++) atom.resname[k]=line[k+17];
+         atom.resname[3]='\0';
+
+         if(!strcmp(atom.resname,"HOH")) continue;
+
+         for(k=0;k<4;k++) atom.atom_name[k]=line[k+12];
+         atom.atom_name[4]='\0';
+
+         atom.serial=decode_integer(line+6, 5);
+         atom.seq=decode_number(line+22, 5);
+         atom.res_sub_type=line[26];
+         atom.x=decode_number(line+30, 9);
+         atom.y=decode_number(line+38, 9);
+         atom.z=decode_number(line+46, 9);
+
+         if(site(data, &atom)) return -1;
+      }
+   }
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to hand the atoms of an mmCIF input to site(), row by row as read_cif_atoms() takes them. Returns 0, or -1 if site() did */
+int cif_sites(struct TEXTINPUT *cif, int (*site)(void*, struct ATOMSITE*), void *data, struct ARENA *arena)
+{
+   /* Variables */
+
+   struct CIFREADER reader;
+   struct CIFROW row;
+   struct ATOMSITE atom;
+
+
+   memset(&reader, 0, sizeof(struct CIFREADER));
+
+   reader.input=cif;
+
+   if(!cif_atom_site(&reader, arena)) return 0;
+
+   while(cif_row(&reader, &row))
+   {
+      cif_atom_name(&row, atom.atom_name);
+
+      cif_residue_name(&row, atom.resname);
+
+      if((atom.atom_name[1]=='H') || (!strcmp(atom.resname,"HOH"))) continue;
+
+      atom.serial=(row.value[CIF_ID]!=NULL) ? decode_integer(row.value[CIF_ID], row.length[CIF_ID]) : 0;
+      atom.chain=cif_chain(&row);
+      atom.seq=cif_number(&row, (cif_value(&row, CIF_AUTH_SEQ)) ? CIF_AUTH_SEQ : CIF_LABEL_SEQ);
+      atom.res_sub_type=cif_insertion(&row);
+      atom.x=cif_number(&row, CIF_X);
+      atom.y=cif_number(&row, CIF_Y);
+      atom.z=cif_number(&row, CIF_Z);
+
+      if(site(data, &atom)) return -1;
+   }
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to add an atom to the columns of the binary format being written. Returns 0, or -1 if its residue number */
+/* is not whole or a co-ordinate is not a whole number of thousandths, which the format could not give back exactly, */
+/* or if there is no memory for the columns */
+int binary_site(void *data, struct ATOMSITE *atom)
+{
+   /* Variables */
+
+   struct BINARYWRITER *writer;
+   double coordinate[3];
+   long long thousandths;
+   int resname_index;
+   int name_index;
+   int k;
+
+
+   writer=(struct BINARYWRITER *) data;
+
+   if((atom->seq!=floor(atom->seq)) || (fabs(atom->seq)>BINARY_LARGEST)) return -1;
+
+   if((resname_index=binary_name(writer->arena, &writer->resname, 3, &writer->resnames_total, &writer->resnames_max, atom->resname))<0) return -1;
+
+   /* a new residue starts a new run */
+
+   if((writer->run_atoms==0) || (resname_index!=writer->run_resname) || (atom->chain!=writer->run_chain) || ((long long) atom->seq!=writer->run_seq) || (atom->res_sub_type!=writer->run_sub_type))
+   {
+      end_run(writer);
+
+      writer->run_resname=resname_index;
+      writer->run_chain=atom->chain;
+      writer->run_sub_type=atom->res_sub_type;
+      writer->run_seq=(long long) atom->seq;
+   }
+
+   writer->run_atoms++;
+
+   if((name_index=binary_name(writer->arena, &writer->name, 4, &writer->names_total, &writer->names_max, atom->atom_name))<0) return -1;
+
+   put_varint(&writer->stream[BINARY_NAME], name_index);
+
+   put_signed(&writer->stream[BINARY_SERIAL], (long long) atom->serial-writer->serial);
+   writer->serial=atom->serial;
+
+   coordinate[0]=atom->x;
+   coordinate[1]=atom->y;
+   coordinate[2]=atom->z;
+
+   for(k=0;k<3;k++)
+   {
+      if(fabs(coordinate[k])>BINARY_LARGEST) return -1;
+
+      thousandths=llround(coordinate[k]*1000.0);
+
+      if(thousandths/1000.0!=coordinate[k]) return -1;
+
+      put_signed(&writer->stream[BINARY_X+k], thousandths-writer->coordinate[k]);
+      writer->coordinate[k]=thousandths;
+   }
+
+   writer->atoms_total++;
+
+   return (writer->arena->failed) ? -1 : 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to write the residue run being built, if any, to the residue column */
+void end_run(struct BINARYWRITER *writer)
+{
+   if(writer->run_atoms==0) return;
+
+   put_varint(&writer->stream[BINARY_RESIDUE], writer->run_atoms);
+   put_varint(&writer->stream[BINARY_RESIDUE], writer->run_resname);
+   put_byte(&writer->stream[BINARY_RESIDUE], (unsigned char) writer->run_chain);
+   put_signed(&writer->stream[BINARY_RESIDUE], writer->run_seq-writer->seq);
+   put_byte(&writer->stream[BINARY_RESIDUE], (unsigned char) writer->run_sub_type);
+
+   writer->seq=writer->run_seq;
+   writer->run_atoms=0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to find a name of width characters in a name table, adding it if it is new, and return its number; */
+/* -1 if there is no memory for it */
+int binary_name(struct ARENA *arena, char **table, int width, int *names_total, int *names_max, const char *name)
+{
+   /* Variables */
+
+   int i;
+
+
+   /* the tables are small and the atoms of a residue come in the same order, so the last names are looked at first */
+
+   for(i=*names_total-1;i>=0;i--)
+   {
+      if(!memcmp(*table+width*i, name, width)) return i;
+   }
+
+   if(*names_total==*names_max)
+   {
+      if((*table=(char *) arena_realloc(arena,*table,*names_max*width,(*names_max+BINARY_NAMES_START)*width))==NULL) return -1;
+      *names_max+=BINARY_NAMES_START;
+   }
+
+   memcpy(*table+width*(*names_total), name, width);
+
+   return (*names_total)++;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to add a byte to a column, growing it as needed; nothing is added once there is no memory for it */
+void put_byte(struct BYTES *bytes, unsigned char byte)
+{
+   if(bytes->arena->failed) return;
+
+   if(bytes->size==bytes->max)
+   {
+      bytes->data=(unsigned char *) arena_realloc(bytes->arena,bytes->data,bytes->max,(bytes->max) ? 2*bytes->max : BYTES_START);
+      bytes->max=(bytes->max) ? 2*bytes->max : BYTES_START;
+
+      if(bytes->data==NULL) return;
+   }
+
+   bytes->data[bytes->size++]=byte;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to add a number to a column seven bits to a byte, the top bit set on all bytes but the last */
+void put_varint(struct BYTES *bytes, unsigned long long value)
+{
+   while(value>=0x80)
+   {
+      put_byte(bytes, (unsigned char) (value|0x80));
+      value>>=7;
+   }
+
+   put_byte(bytes, (unsigned char) value);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to add a signed number to a column, small numbers of either sign taking few bytes (0, -1, 1, -2... as 0, 1, 2, 3...) */
+void put_signed(struct BYTES *bytes, long long value)
+{
+   put_varint(bytes, (value<0) ? 2*(~(unsigned long long) value)+1 : 2*(unsigned long long) value);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to take a number from a column. Returns 0, or -1 if the column ends inside it */
+int get_varint(const unsigned char **next, const unsigned char *end, unsigned long long *value)
+{
+   /* Variables */
+
+   int shift=0;
+
+
+   *value=0;
+
+   while((*next<end) && (shift<64))
+   {
+      *value|=(unsigned long long) (**next&0x7f)<<shift;
+
+      if(!(*(*next)++&0x80)) return 0;
+
+      shift+=7;
+   }
+
+   return -1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to take a signed number from a column, as put by put_signed(). Returns 0, or -1 if the column ends inside it */
+int get_signed(const unsigned char **next, const unsigned char *end, long long *value)
+{
+   /* Variables */
+
+   unsigned long long bits;
+
+
+   if(get_varint(next, end, &bits)) return -1;
+
+   *value=(bits&1) ? (long long) ~(bits>>1) : (long long) (bits>>1);
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to write a number to four bytes, lowest first */
+void put_u32(unsigned char *bytes, unsigned long long value)
+{
+   /* Variables */
+
+   int k;
+
+
+   for(k=0;k<4;k++) bytes[k]=(unsigned char) (value>>(8*k));
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to read a number from four bytes, lowest first */
+unsigned long long get_u32(const unsigned char *bytes)
+{
+   return (unsigned long long) bytes[0]|((unsigned long long) bytes[1]<<8)|((unsigned long long) bytes[2]<<16)|((unsigned long long) bytes[3]<<24);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to write a double to eight bytes, lowest first */
+void put_double(unsigned char *bytes, double value)
+{
+   /* Variables */
+
+   unsigned long long bits;
+
+
+   memcpy(&bits, &value, 8);
+
+   put_u32(bytes, bits&0xffffffffULL);
+   put_u32(bytes+4, bits>>32);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to read a double from eight bytes, lowest first */
+double get_double(const unsigned char *bytes)
+{
+   /* Variables */
+
+   unsigned long long bits;
+   double value;
+
+
+   bits=get_u32(bytes)|(get_u32(bytes+4)<<32);
+
+   memcpy(&value, &bits, 8);
+
+   return value;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to give the bytes taken by a column of a result store, padded to RESULTS_ALIGN */
+size_t column_bytes(int width, unsigned long long rows)
+{
+   return (width*rows+RESULTS_ALIGN-1)/RESULTS_ALIGN*RESULTS_ALIGN;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to find where column c starts in a row group of a result store held in memory */
+const unsigned char* group_column(const unsigned char *group, const struct RESULTCOLUMN *column, int c)
+{
+   /* Variables */
+
+   const unsigned char *next;
+   unsigned long long rows;
+   int k;
+
+
+   rows=get_u32(group+4);
+
+   next=group+RESULTS_GROUP_HEADER;
+
+   for(k=0;k<c;k++) next+=column_bytes(column[k].width, rows);
+
+   return next;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to add an atom to the end of the atom store, growing it as needed, and return its number (-1 if there */
+/* is no memory for it); the new atom is filled with junk for debugging */
+int add_atom(struct ATOMSTORE *atoms)
+{
+   /* Variables */
+
+   int a;
+   int old_max;
+
+
+   if(atoms->atoms_total==atoms->atoms_max)
+   {
+      old_max=atoms->atoms_max;
+
+      atoms->atoms_max=(old_max) ? 2*old_max : ATOMS_START;
+
+      atoms->x=(float *) arena_realloc(atoms->arena,atoms->x,old_max*sizeof(float),atoms->atoms_max*sizeof(float));
+      atoms->y=(float *) arena_realloc(atoms->arena,atoms->y,old_max*sizeof(float),atoms->atoms_max*sizeof(float));
+      atoms->z=(float *) arena_realloc(atoms->arena,atoms->z,old_max*sizeof(float),atoms->atoms_max*sizeof(float));
+      atoms->element=(unsigned char *) arena_realloc(atoms->arena,atoms->element,old_max*sizeof(unsigned char),atoms->atoms_max*sizeof(unsigned char));
+      atoms->atom_class=(unsigned char *) arena_realloc(atoms->arena,atoms->atom_class,old_max*sizeof(unsigned char),atoms->atoms_max*sizeof(unsigned char));
+      atoms->hdonor=(unsigned char *) arena_realloc(atoms->arena,atoms->hdonor,old_max*sizeof(unsigned char),atoms->atoms_max*sizeof(unsigned char));
+      atoms->charge=(unsigned char *) arena_realloc(atoms->arena,atoms->charge,old_max*sizeof(unsigned char),atoms->atoms_max*sizeof(unsigned char));
+      atoms->residue=(int *) arena_realloc(atoms->arena,atoms->residue,old_max*sizeof(int),atoms->atoms_max*sizeof(int));
+      atoms->residue_number=(float *) arena_realloc(atoms->arena,atoms->residue_number,old_max*sizeof(float),atoms->atoms_max*sizeof(float));
+      atoms->atom_number=(int *) arena_realloc(atoms->arena,atoms->atom_number,old_max*sizeof(int),atoms->atoms_max*sizeof(int));
+      atoms->atom_name=(char (*)[5]) arena_realloc(atoms->arena,atoms->atom_name,old_max*sizeof(char[5]),atoms->atoms_max*sizeof(char[5]));
+      atoms->residue_name=(char (*)[4]) arena_realloc(atoms->arena,atoms->residue_name,old_max*sizeof(char[4]),atoms->atoms_max*sizeof(char[4]));
+      atoms->chain=(char *) arena_realloc(atoms->arena,atoms->chain,old_max*sizeof(char),atoms->atoms_max*sizeof(char));
+
+      if(atoms->arena->failed) return -1;
+   }
+
+   a=atoms->atoms_total++;
+
+   atoms->x[a]=-9999;
+   atoms->y[a]=-9999;
+   atoms->z[a]=-9999;
+   atoms->element[a]=ELEMENT_OTHER;
+   atoms->atom_class[a]=0;
+   atoms->hdonor[a]=0;
+   atoms->charge[a]=0;
+   atoms->residue[a]=-1;
+   atoms->residue_number[a]=-1;
+   atoms->atom_number[a]=-1;
+   strcpy(atoms->atom_name[a],"XXXX");
+   strcpy(atoms->residue_name[a],"XXX");
+   atoms->chain[a]='Z';
+
+   return a;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to set the element code (for the covalent and vdW radii) and class bits (for H-bonds) of an atom from its name, */
+/* and its hydrogen bond donor and electrostatic info from the translation table */
+void type_atom(struct ATOMSTORE *atoms, int atom)
+{
+   /* Variables */
+
+   char *atom_name;
+   unsigned long long key;
+   int lo, hi, mid;
+
+
+   atom_name=atoms->atom_name[atom];
+
+   atoms->element[atom]=ELEMENT_OTHER;
+   atoms->atom_class[atom]=0;
+
+   /* the later tests take precedence, so an atom named like both N and O takes N radii */
+
+   if(atom_name[1]=='C') atoms->element[atom]=ELEMENT_C;
+   if((atom_name[1]=='O') || (atom_name[0]=='O')) atoms->element[atom]=ELEMENT_O;
+   if((atom_name[1]=='N') || (atom_name[0]=='N')) atoms->element[atom]=ELEMENT_N;
+   if(atom_name[1]=='S') atoms->element[atom]=ELEMENT_S;
+
+   if((atom_name[1]=='O') || (atom_name[0]=='O')) atoms->atom_class[atom]|=CLASS_O;
+   if((atom_name[1]=='N') || (atom_name[0]=='N')) atoms->atom_class[atom]|=CLASS_N;
+
+   /* atoms missing from the table are neither donors nor charged */
+
+   key=atom_key(atoms->residue_name[atom],atom_name);
+
+   lo=0;
+   hi=TRANSLATIONS_TOTAL;
+
+   while(lo<hi)
+   {
+      mid=(lo+hi)/2;
+
+      if(translation[mid].key<key) lo=mid+1;
+      else hi=mid;
+   }
+
+   atoms->hdonor[atom]=0;
+   atoms->charge[atom]=0;
+
+   if((lo<TRANSLATIONS_TOTAL) && (translation[lo].key==key))
+   {
+      atoms->hdonor[atom]=translation[lo].hdonor;
+      atoms->charge[atom]=translation[lo].charge;
+   }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Little function to get CA co-ordinates from one structure to another */
+int get_ca_coords(struct HELIX *helix, struct ATOMSTORE *atoms, int *helices_total, struct ENTRYSTATE *entry)
+{  
+   /* Variables */
+
+   int i,j,k;
+   float current_residue;
+   float previous_residue;
+
+
+   for (i=0;i<*helices_total;i++)
+   {
+      k=0;              /* set back to zero for new helix */
+
+      previous_residue=-1.5;   /* reset for new helix */
+
+      for(j=atoms->helix_start[i];j<atoms->helix_start[i]+helix[i].atoms_total;j++)
+      {
+         current_residue=atoms->residue_number[j];
+
+         if((!strcmp(atoms->atom_name[j]," CA ")) && (current_residue!=previous_residue))
+         {
+            helix[i].ca_coord[k][0]=atoms->x[j];
+            helix[i].ca_coord[k][1]=atoms->y[j];
+            helix[i].ca_coord[k][2]=atoms->z[j];
+
+            k++;        /* k is number of CA atoms */
+
+            previous_residue=current_residue;
+         }
+
+         if(k==helix[i].residues_total+1)
+         {
+            return entry_error(entry, XHELIX_ERROR_STRUCTURE, "*** Maximum number of helix CA co-ordinates transferred ***");
+         }
+      }
+   }
+
+   return XHELIX_OK;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to get the unit local axes (upto 97 in a 100 residue helix) of a single helix */
+/* and then to get the local helix origins (upto 98 in a 100 residue helix */
+int get_local_axis(int helix_number, struct HELIX *helix, struct ENTRYSTATE *entry)
+{  
+   /* Variables */
+
+   int i,j;
+   double vec12[3];
+   double vec23[3];
+   double vec34[3];
+   double dv13[3];
+   double dv24[3];
+   double cross_product[3];
+   double dot_product;
+   double mag_cross_product;
+   double dmag;
+   double emag;
+   double costheta;
+   double costheta1;
+   double radmag;
+   double rad[3];
+   FILE *fpo_axis;
+
+   i=helix_number;
+
+   fpo_axis=entry->fpo_axis;
+
+   write_output(fpo_axis,"Helix Number %d\n\n",i);
+
+// dmf 6.27.17 need to start assembling the PyMol script file here...
+    
+   if(helix[i].residues_total>=4)
+   {
+      for(j=0;j<helix[i].residues_total-3;j++)
+      {
+         /* get 4 consecutive CA atoms */
+         /* j = CA atom number */
+         /* [0] = X-axis, [1] = Y-axis, [2] = Z-axis */
+         /* vectors joining CA atoms */
+
+         if(helix[i].ca_coord[j][0]==-9999 || helix[i].ca_coord[j][1]==-9999 || helix[i].ca_coord[j][2]==-9999 || helix[i].ca_coord[j+1][0]==-9999 || helix[i].ca_coord[j+1][1]==-9999 || helix[i].ca_coord[j+1][2]==-9999 || helix[i].ca_coord[j+2][0]==-9999 || helix[i].ca_coord[j+2][1]==-9999 || helix[i].ca_coord[j+2][2]==-9999 || helix[i].ca_coord[j+3][0]==-9999 || helix[i].ca_coord[j+3][1]==-9999 || helix[i].ca_coord[j+3][2]==-9999)
+         {
+            return entry_error(entry, XHELIX_ERROR_STRUCTURE, "** error - c-alpha atom limit breached in vector analysis");
+         }
+
+         vec12[0]=helix[i].ca_coord[j+1][0] - helix[i].ca_coord[j][0];
+         vec12[1]=helix[i].ca_coord[j+1][1] - helix[i].ca_coord[j][1];
+         vec12[2]=helix[i].ca_coord[j+1][2] - helix[i].ca_coord[j][2];
+
+         vec23[0]=helix[i].ca_coord[j+2][0] - helix[i].ca_coord[j+1][0];
+         vec23[1]=helix[i].ca_coord[j+2][1] - helix[i].ca_coord[j+1][1];
+         vec23[2]=helix[i].ca_coord[j+2][2] - helix[i].ca_coord[j+1][2];
+
+         vec34[0]=helix[i].ca_coord[j+3][0] - helix[i].ca_coord[j+2][0];
+         vec34[1]=helix[i].ca_coord[j+3][1] - helix[i].ca_coord[j+2][1];
+         vec34[2]=helix[i].ca_coord[j+3][2] - helix[i].ca_coord[j+2][2];
+
+         /* difference of vectors joining CA atoms */
+         /* these vectors are perpendicular to the helix axis */
+
+         dv13[0]=vec12[0] - vec23[0];
+         dv13[1]=vec12[1] - vec23[1];
+         dv13[2]=vec12[2] - vec23[2];
+
+         dv24[0]=vec23[0] - vec34[0];
+         dv24[1]=vec23[1] - vec34[1];
+         dv24[2]=vec23[2] - vec34[2];
+
+         /* x, y, z components of the cross-product vector (the axis) */
+
+         cross_product[0]=(dv13[1] * dv24[2]) - (dv13[2] * dv24[1]);
+         cross_product[1]=(dv13[2] * dv24[0]) - (dv13[0] * dv24[2]);
+         cross_product[2]=(dv13[0] * dv24[1]) - (dv13[1] * dv24[0]);
+
+         /* get unit vectors of the axis */
+
+         mag_cross_product=sqrt(SQR(cross_product[0])+SQR(cross_product[1])+SQR(cross_product[2]));
+
+         cross_product[0]=cross_product[0]/mag_cross_product;
+         cross_product[1]=cross_product[1]/mag_cross_product;
+         cross_product[2]=cross_product[2]/mag_cross_product;
+         
+         helix[i].unit_local_axis[j][0]=cross_product[0];
+         helix[i].unit_local_axis[j][1]=cross_product[1];
+         helix[i].unit_local_axis[j][2]=cross_product[2];
+
+         write_output(fpo_axis,"unit local axis %d: X %f, Y %f, Z %f\n",j,helix[i].unit_local_axis[j][0],helix[i].unit_local_axis[j][1],helix[i].unit_local_axis[j][2]);
+     
+         dmag=sqrt(SQR(dv13[0]) + SQR(dv13[1]) + SQR(dv13[2]));
+         emag=sqrt(SQR(dv24[0]) + SQR(dv24[1]) + SQR(dv24[2]));
+         dot_product=(dv13[0]*dv24[0]) + (dv13[1]*dv24[1]) + (dv13[2]*dv24[2]);
+         costheta=dot_product/(dmag*emag);
+
+         /* radius of local helix cylinder */
+
+         costheta1=1.0-costheta;
+         radmag=sqrt(dmag*emag)/(costheta1*2.0);
+
+         /* local helix origins */
+         /* convert dv13 and dv24 to unit vectors */
+
+         dv13[0]=dv13[0]/dmag;
+         dv13[1]=dv13[1]/dmag;
+         dv13[2]=dv13[2]/dmag;
+
+         /* convert vectors to length of cylinder radius */
+
+         rad[0]=radmag*dv13[0];
+         rad[1]=radmag*dv13[1];
+         rad[2]=radmag*dv13[2];
+
+         /* get two helix origins for each local helix axis */
+         /* this is the first.... */
+
+         helix[i].origin[j][0]=helix[i].ca_coord[j+1][0]-rad[0];
+         helix[i].origin[j][1]=helix[i].ca_coord[j+1][1]-rad[1];
+         helix[i].origin[j][2]=helix[i].ca_coord[j+1][2]-rad[2];
+
+         dv24[0]=dv24[0]/emag;
+         dv24[1]=dv24[1]/emag;
+         dv24[2]=dv24[2]/emag;
+
+         rad[0]=radmag*dv24[0];
+         rad[1]=radmag*dv24[1];
+         rad[2]=radmag*dv24[2];
+
+         /* and the second....  */
+         /* this is actually recorded over by the first origin of the next local axis, except at the very last axis! */
+
+         helix[i].origin[j+1][0]=helix[i].ca_coord[j+2][0]-rad[0];
+         helix[i].origin[j+1][1]=helix[i].ca_coord[j+2][1]-rad[1];
+         helix[i].origin[j+1][2]=helix[i].ca_coord[j+2][2]-rad[2];
+
+         write_output(fpo_axis,"helix origin %d: X %f, Y %f, Z %f\n",j,helix[i].origin[j][0],helix[i].origin[j][1],helix[i].origin[j][2]);
+         write_output(fpo_axis,"helix origin %d: X %f, Y %f, Z %f\n\n",j+1,helix[i].origin[j+1][0],helix[i].origin[j+1][1],helix[i].origin[j+1][2]);
+          
+
+      }
+   }
+   else
+   {
+      write_output(fpo_axis,"Helix %d is less than 4 residues and has no axis\n\n",i);
+   }
+
+   return XHELIX_OK;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to keep running sums of the unit local axes of a single helix, so that the axes of any part of */
+/* the helix are summed at once for the pairs it is in */
+void sum_axes(int helix_number, struct HELIX *helix)
+{
+   /* Variables */
+
+   int i,g,k;
+   double *axis;
+
+
+   i=helix_number;
+
+   if(helix[i].residues_total<4) return;
+
+   for(k=0;k<3;k++) helix[i].axis_sum[0][k]=0.0;
+   helix[i].unset_axes[0]=0;
+
+   for(g=0;g<helix[i].residues_total-3;g++)
+   {
+      axis=helix[i].unit_local_axis[g];
+
+      for(k=0;k<3;k++) helix[i].axis_sum[g+1][k]=helix[i].axis_sum[g][k]+axis[k];
+
+      helix[i].unset_axes[g+1]=helix[i].unset_axes[g]+((axis[0]==-1) || (axis[1]==-1) || (axis[2]==-1));
+   }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to sum the unit local axes first to last of a single helix from its running sums, none if last is before first */
+void axis_run(struct HELIX *helix, int first, int last, double total[3])
+{
+   /* Variables */
+
+   int k;
+
+
+   for(k=0;k<3;k++) total[k]=(last<first) ? 0.0 : helix->axis_sum[last+1][k]-helix->axis_sum[first][k];
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to get the bending angle between two local axes of a single helix (angles between axes j--j+3, j+3--j+6, etc.) and then get the maximum bending angle in the helix */
+int get_bending_angle(int helix_number, struct HELIX *helix, struct ENTRYSTATE *entry)
+{
+   /* Variables */
+
+   int i,j,k=0,l;
+   FILE *fpo_axis;
+   double angle;
+   double max_angle=0;
+   double pi;
+
+   // dmf 6.27.17 will add a axis.py file that will contain a workaround
+   // to display the axis elements for each helix in PyMol. Will also want
+   // to add a vector for the point of close approach.
+   FILE *fpo_pyaxis;
+   int vec_flag;
+   char pt_label[20], previous_pt_label[20];
+   char dLabel[20]; 
+
+   i=helix_number;
+
+   pi=180.0/acos(-1.0);
+
+   fpo_axis=entry->fpo_axis;
+   fpo_pyaxis=entry->fpo_pyaxis;
+
+   if(helix[i].residues_total>=7)
+   {
+       // set a flag processing new helix
+       vec_flag=0;
+       
+      for (j=0; j<helix[i].residues_total-6; j+=3)   /* j is axis number and must be incremented by three */
+      // dmf 6.28.17 exploit this j+=3 loop to handle outputing axis points for
+      //     display in pymol
+      {
+         if((helix[i].unit_local_axis[j][0]!=-1) && (helix[i].unit_local_axis[j][1]!=-1) && (helix[i].unit_local_axis[j][2]!=-1) && (helix[i].unit_local_axis[j+3][0]!=-1) && (helix[i].unit_local_axis[j+3][1]!=-1) && (helix[i].unit_local_axis[j+3][2]!=-1))
+         {
+            angle=helix[i].unit_local_axis[j][0] * helix[i].unit_local_axis[j+3][0] + helix[i].unit_local_axis[j][1] * helix[i].unit_local_axis[j+3][1] + helix[i].unit_local_axis[j][2] * helix[i].unit_local_axis[j+3][2];
+
+            helix[i].bending_angle[k]=acos(angle)*pi;
+
+            write_output(fpo_axis,"Bending angle between axis %d and axis %d: %f degrees\n",j,j+3,helix[i].bending_angle[k]);
+
+            k++;   /* k is bend_number and must be incremented by one */
+             
+             // dmf 6.27.17 need to start assembling the PyMol script file here... (want these points as vectors)
+             // - identify by helix_number + segment_number (so can create helix axis objects for each individual helix)
+             // - possibly only record every third axis point (in fact, should do this, otherwise will have a ton of points)
+             // - structure will be:
+             //			pseudoatom pt1, pos=[x1, y1, z1]
+             //			pseudoatom pt2, pos=[x2, y2, z2]
+             //			distance /pt1, /pt2
+             //			set dash_gap, 0
+             // - use "pt1" as identifier (e.g. helix[#]pt[#]) - "i" identifies the helix, "j" identifies the segment
+             // - want helix[i].origin[j][0], [1], [2] values
+             // - last two lines can be added before file is closed
+
+             // the CGO script joins each axis point to the one before, as the distances below do
+             if(j>=3) write_output(entry->fpo_cgo,"CYLINDER, %.3f, %.3f, %.3f, %.3f, %.3f, %.3f, *s,\n",helix[i].origin[j-3][0],helix[i].origin[j-3][1],helix[i].origin[j-3][2],helix[i].origin[j][0],helix[i].origin[j][1],helix[i].origin[j][2]);
+
+             // the labels are only made when axis.py is written
+             if(fpo_pyaxis==NULL) continue;
+
+             // set the label for the axis point
+             sprintf(pt_label,"h%dp%d",i,j);
+             
+             // write the coordinates of the axis point
+             write_output(fpo_pyaxis, "pseudoatom %s, pos=[ %f, %f, %f]\n", pt_label, helix[i].origin[j][0], helix[i].origin[j][1], helix[i].origin[j][2]);
+             
+             // write the distance statement if there's a previous point
+             if (vec_flag) {
+                 // may want the distance objects to have specific names (add later)
+				 sprintf(dLabel,"%s_Axis",pt_label); 
+                 write_output(fpo_pyaxis, "distance %s, /%s, /%s\n", dLabel, previous_pt_label, pt_label);
+                 strcpy(previous_pt_label,pt_label);
+             } else {
+                 strcpy(previous_pt_label,pt_label);
+                 // next point, will write a distance statement
+                 vec_flag = 1;
+             }
+         }
+         else
+         {
+            write_output(fpo_axis,"*** Invalid axis has been chosen ***\n");
+            return entry_error(entry, XHELIX_ERROR_STRUCTURE, "*** Invalid axis has been chosen ***");
+         }
+      }
+      write_output(fpo_axis,"\n");
+
+      /* get maximum bending angle in helix */
+
+      for (l=0; l<k; l++)
+      {
+         if(helix[i].bending_angle[l]>max_angle)
+         {
+            max_angle=helix[i].bending_angle[l];
+         }
+      }
+      helix[i].max_bending_angle=max_angle;
+
+      /* Assign geometry to helix - (K)inked or not */  
+
+      if(max_angle>=20.0) helix[i].geometry='K';
+
+      write_output(fpo_axis,"Maximum bending angle: %f degrees\n\n",helix[i].max_bending_angle);
+   }
+
+   else
+   {
+      write_output(fpo_axis,"Helix %d is less than 7 residues and does not have a bending angle\n\n",i);
+   }
+
+   return XHELIX_OK;
+}    
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to fit plane, circle, and line to the local helix origins */
+int fit(int helix_number, struct HELIX *helix, struct ARENA *arena, struct ENTRYSTATE *entry)
+{
+   /* Variables */
+
+   int i,j,k,l;
+   double *rx, *ry, *rz;
+   double *rmp, *rmc, *rml;
+   double **matp;
+   double **matc;
+   double **matl;       /* matp[3][3],matc[3][3],matl[2][2] */
+   double rotmt[3][3];
+   double **pmat;
+   double **cmat;
+   double **lmat;       /* pmat[3][3],cmat[3][3],lmat[2][2] */
+   double v[3], ap[3], ac[3], al[2];
+   double vmag;
+   double x2, y2, z2, xy, xz, yz, x, y, z, x2y, xy2, y3, x3;
+   double bp1,bp2,bp3,bc1,bc2,bc3,bl1,bl2;
+   double sump, sumc, suml;
+   double rmsdp, radcsq;
+   double deno, rdeno, rnum, r;
+   double pp,pl,pm,pn;
+   double costheta, costheta1, theta, sintheta;
+   double a1,a2,a3,b1,b2,b3;
+   double rem;
+   double radc, rmsdc, rmsdl, r2, ratio;
+   int origins_total;
+   int status;
+   FILE *fpo_geom;
+
+
+   i=helix_number;
+
+   origins_total=helix[i].residues_total-2;
+
+   fpo_geom=entry->fpo_geom;
+
+   write_output(fpo_geom,"Helix Number %d\n\n",i);
+
+   /* unless geom.txt is written the fits only serve to tell curved helices from linear ones, */
+   /* which kinked helices are not tested for */
+
+   if((fpo_geom==NULL) && ((helix[i].max_bending_angle>=20.0) || (helix[i].geometry=='K'))) return XHELIX_OK;
+
+   if(helix[i].residues_total>=9)
+   {
+      /* allocate the rotated origins and the residuals, one per origin */
+
+      rx = (double *) arena_alloc(arena,origins_total*sizeof(double));
+      ry = (double *) arena_alloc(arena,origins_total*sizeof(double));
+      rz = (double *) arena_alloc(arena,origins_total*sizeof(double));
+      rmp = (double *) arena_alloc(arena,origins_total*sizeof(double));
+      rmc = (double *) arena_alloc(arena,origins_total*sizeof(double));
+      rml = (double *) arena_alloc(arena,origins_total*sizeof(double));
+
+      /* allocate the 3x3 and 2x2 matrices */
+
+      matp = make_matrix(3, arena);
+
+      matc = make_matrix(3, arena);
+
+      if((status=arena_error(entry, &arena, 1))) return status;
+
+      for(j=0;j<3;j++)
+      {
+         for(k=0;k<3;k++)
+         {
+            matp[j][k]=0.0;
+            matc[j][k]=0.0;
+         }  
+      }
+
+      if((matl = make_matrix(2, arena))==NULL) return arena_error(entry, &arena, 1);
+
+      for(j=0;j<2;j++)
+      {
+         for(k=0;k<2;k++)
+         {
+            matl[j][k]=0.0;
+         }  
+      }
+
+      /* fitting least squares plane to local helix origins */
+
+      x2=0.0;
+      y2=0.0;
+      z2=0.0;
+      xy=0.0;
+      xz=0.0;
+      yz=0.0;
+      x=0.0;
+      y=0.0;
+      z=0.0;
+
+      for(j=0;j<origins_total;j++)
+      {
+         if(helix[i].origin[j][0]==-1 || helix[i].origin[j][1]==-1 || helix[i].origin[j][2]==-1)
+         {
+            return entry_error(entry, XHELIX_ERROR_STRUCTURE, "** error - invalid local helix origin used in analysis");
+         }
+
+         x2 = helix[i].origin[j][0] * helix[i].origin[j][0] + x2;
+         y2 = helix[i].origin[j][1] * helix[i].origin[j][1] + y2;
+         z2 = helix[i].origin[j][2] * helix[i].origin[j][2] + z2;
+         xy = helix[i].origin[j][0] * helix[i].origin[j][1] + xy;
+         xz = helix[i].origin[j][0] * helix[i].origin[j][2] + xz;
+         yz = helix[i].origin[j][1] * helix[i].origin[j][2] + yz;
+         x = helix[i].origin[j][0] + x;
+         y = helix[i].origin[j][1] + y;
+         z = helix[i].origin[j][2] + z;
+      }
+
+      matp[0][0] = x2 + matp[0][0];
+      matp[0][1] = xy + matp[0][1];
+      matp[0][2] = xz + matp[0][2];
+      matp[1][0] = xy + matp[1][0];
+      matp[1][1] = y2 + matp[1][1];
+      matp[1][2] = yz + matp[1][2];
+      matp[2][0] = xz + matp[2][0];
+      matp[2][1] = yz + matp[2][1];
+      matp[2][2] = z2 + matp[2][2];
+
+      if((pmat=matinv3(matp, arena))==NULL) return arena_error(entry, &arena, 1);
+
+      bp1=x;
+      bp2=y;
+      bp3=z;
+
+      for(j=0;j<3;j++)
+      {
+         ap[j]=pmat[j][0]*bp1+pmat[j][1]*bp2+pmat[j][2]*bp3;
+      }
+
+      sump=0.0;
+
+      for(j=0;j<origins_total;j++)
+      {
+         rmp[j]=ap[0]*helix[i].origin[j][0] + ap[1]*helix[i].origin[j][1] + ap[2]*helix[i].origin[j][2] -1;
+         sump=sump+rmp[j]*rmp[j];
+      }
+
+      if(sump<0.0) write_output(fpo_geom,"Fit to the plane is not good\n\n");
+
+      else
+      {
+         rmsdp=sqrt(sump/origins_total);
+         write_output(fpo_geom,"RMS deviation from best plane: %f\n",rmsdp);
+      }
+
+      /* converting to the normal form of the plane */
+      /* deno is denominator, pp is distance of plane from XY plane */
+
+      deno=sqrt(SQR(ap[0])+SQR(ap[1])+SQR(ap[2]));
+      pp=1.0/deno;
+      pl=ap[0]*pp;
+      pm=ap[1]*pp;
+      pn=ap[2]*pp;
+
+      write_output(fpo_geom,"L, M, and N of the best plane: %f, %f, %f\n",pl,pm,pn);
+
+      /* reorientate the points so that the best fit plane coincides with the X-Y plane */
+      /* l,m,n of the normal to X-Y plane are (0,0,1) */
+      /* angle between normal to best fit plane & the X-Y plane */
+      /* vector normal to the l,m,n of the best fit and X-Y plane... */
+
+      for(j=0;j<3;j++)
+      {
+         v[j]=0.0;
+      }
+
+      v[0]=pm+v[0];
+      v[1]=-pl+v[1];
+      v[2]=0.0+v[2];
+
+      vmag=sqrt(SQR(v[0])+SQR(v[1])+SQR(v[2]));
+      v[0]=v[0]/vmag;
+      v[1]=v[1]/vmag;
+      v[2]=v[2]/vmag;
+
+      /* the rotation matrix required to make l,m,n as 0,0,1 */
+
+      costheta=pn;
+      costheta1=1.0-pn;
+      theta=acos(pn);
+      sintheta=sin(theta);
+      a1=v[0]*sintheta;
+      a2=v[1]*sintheta;
+      a3=v[2]*sintheta;
+      b1=v[1]*v[2]*costheta1;
+      b2=v[2]*v[0]*costheta1;
+      b3=v[0]*v[1]*costheta1;
+
+      for(j=0;j<3;j++)
+      {
+         for(k=0;k<3;k++)
+         {
+            rotmt[j][k]=0.0;
+         }  
+      }
+
+      rotmt[0][0]=costheta+SQR(v[0])*costheta1+rotmt[0][0];
+      rotmt[1][1]=costheta+SQR(v[1])*costheta1+rotmt[1][1];
+      rotmt[2][2]=costheta+SQR(v[2])*costheta1+rotmt[2][2];
+      rotmt[0][1]=b3-a3+rotmt[0][1];
+      rotmt[1][0]=b3+a3+rotmt[1][0];
+      rotmt[2][0]=b2-a2+rotmt[2][0];
+      rotmt[0][2]=b2+a2+rotmt[0][2];
+      rotmt[1][2]=b1-a1+rotmt[1][2];
+      rotmt[2][1]=b1+a1+rotmt[2][1];
+
+      /* rotating the points so that they lie in the X-Y plane */
+
+      for(j=0;j<origins_total;j++)
+      {
+         rx[j]=rotmt[0][0]*helix[i].origin[j][0]+rotmt[0][1]*helix[i].origin[j][1]+rotmt[0][2]*helix[i].origin[j][2]+rx[j];
+         ry[j]=rotmt[1][0]*helix[i].origin[j][0]+rotmt[1][1]*helix[i].origin[j][1]+rotmt[1][2]*helix[i].origin[j][2]+ry[j];
+         rz[j]=rotmt[2][0]*helix[i].origin[j][0]+rotmt[2][1]*helix[i].origin[j][1]+rotmt[2][2]*helix[i].origin[j][2]+rz[j];
+      }
+
+      /* translating the points so that they lie in the X-Y plane of the form ax+by=0 */
+
+      for(j=0;j<origins_total;j++)
+      {
+         rx[j]=rx[j];
+         ry[j]=ry[j];
+         rz[j]=rz[j]-pp;
+      }
 
       /* fitting circle to these reorientated points */
       /* equation used is (x+a)^2+(y+b)^2=r^2 */
@@ -1562,489 +6844,1486 @@ void fit(int helix_number, struct HELIX *helix)
       /* circle finds out radius of curvature and coordinates of centre */
       /* from a set of given points using LEAST SQUARE FIT method. */
 
-      x2 = 0.0;
-      y2 = 0.0;
-      x3 = 0.0;
-      y3 = 0.0;
-      xy2 = 0.0;
-      x2y = 0.0;
-      xy = 0.0;
-      x = 0.0;
-      y = 0.0;
+      x2 = 0.0;
+      y2 = 0.0;
+      x3 = 0.0;
+      y3 = 0.0;
+      xy2 = 0.0;
+      x2y = 0.0;
+      xy = 0.0;
+      x = 0.0;
+      y = 0.0;
+
+      for(j=0;j<origins_total;j++)
+      {
+         x3 = rx[j] * rx[j] * rx[j] + x3;
+         y3 = ry[j] * ry[j] * ry[j] + y3;
+         x2y = rx[j] * rx[j] * ry[j] + x2y;
+         xy2 = rx[j] * ry[j] * ry[j] + xy2;
+         x2 = rx[j] * rx[j] + x2;
+         y2 = ry[j] * ry[j] + y2;
+         xy = rx[j] * ry[j] + xy;
+         x = rx[j] + x;
+         y = ry[j] + y;
+      }
+
+      matc[0][0]=x2+matc[0][0];
+      matc[0][1]=xy+matc[0][1];
+      matc[0][2]=-x+matc[0][2];
+      matc[1][0]=xy+matc[1][0];
+      matc[1][1]=y2+matc[1][1];
+      matc[1][2]=-y+matc[1][2];
+      matc[2][0]=x+matc[2][0];
+      matc[2][1]=y+matc[2][1];
+      matc[2][2]=-origins_total+matc[2][2];
+
+      if((cmat=matinv3(matc, arena))==NULL) return arena_error(entry, &arena, 1);
+
+      bc1=-x3-xy2;
+      bc2=-x2y-y3;
+      bc3=-x2-y2;
+
+      for(j=0;j<3;j++)
+      {
+         ac[j]=0.0;
+      }
+
+      for(j=0;j<3;j++)
+      {
+         ac[j]=cmat[j][0]*bc1+cmat[j][1]*bc2+cmat[j][2]*bc3+ac[j];
+      }
+
+      ac[0]=ac[0]/2.0;
+      ac[1]=ac[1]/2.0;
+      ac[2]=ac[2];
+
+      radcsq=SQR(ac[0])+SQR(ac[1])+ac[2];
+
+      if(radcsq>0.0)
+      {
+         radc=sqrt(radcsq);
+         write_output(fpo_geom,"Radius of the best circle: %f\n",radc);
+         write_output(fpo_geom,"Centre of the best circle: %f, %f\n",-ac[1],-ac[2]);
+      }
+      else
+      {
+         radc=0.0;
+         write_output(fpo_geom,"Fit of the circle is not good\n\n");
+      }
+
+      sumc=0.0;
+
+      /* dev=sqrt((x+a)^2+(y+b)^2)-r */
+      /* rms dev=sqrt(dev^2/n) */
+
+      for(j=0;j<origins_total;j++)
+      {
+         rem=SQR(rx[j]+ac[0])+SQR(ry[j]+ac[1]);
+         rmc[j]=sqrt(rem)-radc;
+         sumc=sumc+SQR(rmc[j]);
+      }
+
+      if(sumc<0.0)
+      {
+         write_output(fpo_geom,"Fit of the circle is not good\n\n");
+      }
+      else
+      {
+         rmsdc=sqrt(sumc/origins_total);
+         write_output(fpo_geom,"RMS deviation from the best circle: %f\n",rmsdc);
+      }
+
+      /* Fitting line to the reorientated points - equation of line y=mx+c */
+
+      matl[0][0]=x2+matl[0][0];
+      matl[0][1]=x+matl[0][1];
+      matl[1][0]=x+matl[1][0];
+      matl[1][1]=origins_total+matl[1][1];
+
+      if((lmat=matinv2(matl, arena))==NULL) return arena_error(entry, &arena, 1);
+
+      bl1=xy;
+      bl2=y;
+
+      al[0]=0.0;
+      al[1]=0.0;
+
+      for(j=0;j<2;j++)
+      {
+         al[j]=lmat[j][0]*bl1+lmat[j][1]*bl2+al[j];
+      }
+
+      write_output(fpo_geom,"Slope of the best line: %f\n",al[0]);
+      write_output(fpo_geom,"Intercept of the best line: %f\n",al[1]);
+
+      suml=0.0;
+
+      for(j=0;j<origins_total;j++)
+      {
+         rml[j]=ry[j]-al[0]*rx[j]-al[1];
+         suml=suml+SQR(rml[j]);
+      }
+
+      if(suml<0.0) write_output(fpo_geom,"Fit to the line is not good\n\n");
+
+      else
+      {
+         rmsdl=sqrt(suml/origins_total);
+         write_output(fpo_geom,"RMS deviation from best line: %f\n",rmsdl);
+      }
+
+      /* Linear correlation coefficient */
+      /* r=(n*(xy)-x*y)/sqrt((n*x2-x*x)*(n*y2-y*y)) */
+
+      rnum=origins_total*xy-x*y;
+      rdeno=(origins_total*x2-x*x)*(origins_total*y2-y*y);
+      r=rnum/sqrt(rdeno);
+      r2=r*r;
+      write_output(fpo_geom,"Square of linear correlation coefficient: %f\n",r2);
+
+      /* Assign geometry to helix - (U)nknown, (C)urved or (L)inear */
+
+      if((helix[i].max_bending_angle<20.0) && (helix[i].geometry!='K'))
+      {
+         ratio=rmsdl/rmsdc;
+
+         write_output(fpo_geom,"Ratio rmsdl/rmsdc: %f",ratio);
+
+         if((rmsdc>1.0) && (rmsdl>1.0))
+         {
+            helix[i].geometry='U';
+         }
+
+         else if(ratio>1.0) helix[i].geometry='C';
+
+         else if((ratio<=0.7) && (r2>=0.8)) helix[i].geometry='L';
+
+         else if((ratio>0.7) && (ratio<=1.0) && (r2<=0.5)) helix[i].geometry='C';
+
+         else if((ratio>0.7) && (ratio<=1.0) && (r2>=0.8)) helix[i].geometry='L';
+
+         else if((ratio>0.7) && (ratio<=1.0) && (r2>0.5) && (r2<0.8)) helix[i].geometry='U';
+
+         else helix[i].geometry='U';
+      }
+
+      write_output(fpo_geom,"\n\n");
+   }
+
+   else
+   {
+      write_output(fpo_geom,"Helix %d is less than 9 residues and cannot undergo accurate line/curve fitting\n\n",i);
+   }
+
+   return XHELIX_OK;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to calculate the inverse of a 3 x 3 matrix */
+double** matinv3(double **h, struct ARENA *arena) 
+{
+   /* Variables */
+
+   double deth, deth1, deth2, deth3;
+   int j,k;
+   double c11,c12,c13,c21,c22,c23,c31,c32,c33;
+   double **s; 
+
+
+   if((s = make_matrix(3, arena))==NULL) return NULL;
+
+   for(j=0; j<3; j++)
+   {
+      for(k=0; k<3; k++)
+      {
+         s[j][k]=0.0;
+      }
+   }
+
+   c11=h[1][1]*h[2][2]-h[2][1]*h[1][2];
+   c12=h[1][0]*h[2][2]-h[2][0]*h[1][2];
+   c13=h[1][0]*h[2][1]-h[2][0]*h[1][1];
+   c21=h[0][1]*h[2][2]-h[0][2]*h[2][1];
+   c22=h[0][0]*h[2][2]-h[0][2]*h[2][0];
+   c23=h[0][0]*h[2][1]-h[2][0]*h[0][1];
+   c31=h[0][1]*h[1][2]-h[0][2]*h[1][1];
+   c32=h[0][0]*h[1][2]-h[0][2]*h[1][0];
+   c33=h[0][0]*h[1][1]-h[0][1]*h[1][0];
+
+   deth1=h[0][0]*c11;
+   deth2=-h[0][1]*c12;
+   deth3=h[0][2]*c13;
+   deth=deth1+deth2+deth3;
+
+   if(deth!=0.0)
+   {
+      s[0][0]=c11/deth+s[0][0];
+      s[0][1]=-c21/deth+s[0][1];
+      s[0][2]=c31/deth+s[0][2];
+      s[1][0]=-c12/deth+s[1][0];
+      s[1][1]=c22/deth+s[1][1];
+      s[1][2]=-c32/deth+s[1][2];
+      s[2][0]=c13/deth+s[2][0];
+      s[2][1]=-c23/deth+s[2][1];
+      s[2][2]=c33/deth+s[2][2];
+   }
+   else
+   {
+   printf("\n\n** ERROR ** determinant of (3x3) matrix is zero, no inverse possible!\n\n");
+   }
+
+   return s;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to calculate the inverse of a 2 x 2 matrix */
+double** matinv2(double **p, struct ARENA *arena) 
+{
+   /* Variables */
+
+   double detp, detp1, detp2;
+   int j,k;
+   double c11,c12,c21,c22;
+   double **q; 
+
+
+   if((q = make_matrix(2, arena))==NULL) return NULL;
+
+   for(j=0; j<2; j++)
+   {
+      for(k=0; k<2; k++)
+      {
+         q[j][k]=0.0;
+      }
+   }
+
+   c11=p[1][1];
+   c12=p[1][0];
+   c21=p[0][1];
+   c22=p[0][0];
+
+   detp1=p[0][0]*c11;
+   detp2=-p[0][1]*c12;
+   detp=detp1+detp2;
+
+   if(detp!=0.0)
+   {
+      q[0][0]=c11/detp+q[0][0];
+      q[0][1]=-c21/detp+q[0][1];
+      q[1][0]=-c12/detp+q[1][0];
+      q[1][1]=c22/detp+q[1][1];
+   }
+   else
+   {
+   printf("\n\n** ERROR ** determinant of (2x2) matrix is zero, no inverse possible!\n\n");
+   }
+
+   return q;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to allocate an n x n matrix, filled with zeros; NULL if there is no memory for it */
+double** make_matrix(int n, struct ARENA *arena)
+{
+   /* Variables */
+
+   int i;
+   double **m;
+
+
+   if((m = (double **) arena_alloc(arena,n*sizeof(double *)))==NULL) return NULL;
+
+   for(i=0; i<n; i++)
+   {
+      if((m[i] = (double *) arena_alloc(arena,n*sizeof(double)))==NULL) return NULL;
+   }
+
+   return m;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to generate an empty store for the neighbouring helix pairs of a protein, NULL if there is no memory for it */
+struct PAIRSTORE* neighbours(struct ARENA *arena)
+{
+   /* Variables */
+
+   struct PAIRSTORE *pair_store;
+
+
+   if((pair_store=(struct PAIRSTORE *) arena_alloc(arena,sizeof(struct PAIRSTORE)))==NULL) return NULL;
+
+   pair_store->arena=arena;
+   pair_store->pairs_max=64;
+
+   if((pair_store->pair=(struct HELIXPAIR *) arena_alloc(arena,pair_store->pairs_max*sizeof(struct HELIXPAIR)))==NULL) return NULL;
+
+   return pair_store;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to add a helix pair to the store, filled with zeros and negative values, NULL if there is no memory for it */
+/* pairs must be added by helix two and then helix one, as the neighbour scan visits them */
+struct HELIXPAIR* add_pair(struct PAIRSTORE *pair_store, int helix1, int helix2)
+{
+   /* Variables */
+
+   struct HELIXPAIR *helix_pair;
+
+
+   if(pair_store->pairs_total==pair_store->pairs_max)
+   {
+      if((pair_store->pair=(struct HELIXPAIR *) arena_realloc(pair_store->arena,pair_store->pair,pair_store->pairs_max*sizeof(struct HELIXPAIR),2*pair_store->pairs_max*sizeof(struct HELIXPAIR)))==NULL) return NULL;
+      pair_store->pairs_max*=2;
+   }
+
+   helix_pair=&pair_store->pair[pair_store->pairs_total++];
+
+   helix_pair->helix_one=helix1;
+   helix_pair->helix_two=helix2;
+   helix_pair->neighbours=0;
+   helix_pair->packed=0;
+   helix_pair->h1_residues=-1;
+   helix_pair->h2_residues=-1;
+   helix_pair->h1_start=-1;
+   helix_pair->h2_start=-1;
+   helix_pair->h1_end=-1;
+   helix_pair->h2_end=-1;
+   helix_pair->vdw=0;
+   helix_pair->hbond=0;
+   helix_pair->electrostatic=0;
+   helix_pair->covalent=0;
+   helix_pair->angle1=-1.0;
+   helix_pair->angle2=-1.0;
+   helix_pair->distance=-1.0;
+
+   return helix_pair;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to look up a helix pair in the store, returns NULL if the helices are not neighbours */
+struct HELIXPAIR* find_pair(struct PAIRSTORE *pair_store, int helix1, int helix2)
+{
+   /* Variables */
+
+   int lo, hi, mid;
+   struct HELIXPAIR *helix_pair;
+
+
+   lo=0;
+   hi=pair_store->pairs_total;
+
+   while(lo<hi)
+   {
+      mid=(lo+hi)/2;
+      helix_pair=&pair_store->pair[mid];
+
+      if((helix_pair->helix_two<helix2) || ((helix_pair->helix_two==helix2) && (helix_pair->helix_one<helix1))) lo=mid+1;
+      else hi=mid;
+   }
+
+   if((lo<pair_store->pairs_total) && (pair_store->pair[lo].helix_one==helix1) && (pair_store->pair[lo].helix_two==helix2))
+   {
+      return &pair_store->pair[lo];
+   }
+
+   return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to build the bounding capsule of each helix (the segment from its first to last C-alpha, */
+/* widened by the distance of the furthest C-alpha from that segment) and a bounding-volume hierarchy */
+/* over the capsules. It returns the helix pairs (helix one < helix two, ordered by helix two and then */
+/* helix one) whose capsules come within NEIGHBOUR_DISTANCE of each other; only these can be neighbours */
+int* helix_candidates(struct HELIX *helix, int *helices_total, int *candidates_total, struct ARENA *arena)
+{
+   /* Variables */
+
+   struct CAPSULE *capsule;
+   struct HELIXNODE *node;
+   int *order;
+   int *stack;
+   int *candidate;
+   int nodes_total=0;
+   int stack_total;
+   int candidates_max;
+   int g,h,i,j,k,n;
+   double t,len2,dist2,r2;
+   double ab[3],ap[3];
+   double reach;
+   double lo[3],hi[3];
+
+
+   *candidates_total=0;
+
+   capsule=(struct CAPSULE *) arena_alloc(arena,(*helices_total+1)*sizeof(struct CAPSULE));
+   node=(struct HELIXNODE *) arena_alloc(arena,(2*(*helices_total)+1)*sizeof(struct HELIXNODE));
+   order=(int *) arena_alloc(arena,(*helices_total+1)*sizeof(int));
+   stack=(int *) arena_alloc(arena,(2*(*helices_total)+1)*sizeof(int));
+
+   candidates_max=*helices_total+1;
+   candidate=(int *) arena_alloc(arena,2*candidates_max*sizeof(int));
+
+   if(arena->failed) return NULL;
+
+   /* capsule of each helix - every C-alpha slot is included, so that the capsule is never smaller than the helix */
+
+   for(i=0;i<*helices_total;i++)
+   {
+      n=helix[i].residues_total;
+
+      for(k=0;k<3;k++)
+      {
+         capsule[i].p0[k]=helix[i].ca_coord[0][k];
+         capsule[i].p1[k]=helix[i].ca_coord[n-1][k];
+         ab[k]=capsule[i].p1[k]-capsule[i].p0[k];
+      }
+      len2=SQR(ab[0])+SQR(ab[1])+SQR(ab[2]);
+
+      r2=0.0;
+
+      for(g=0;g<n;g++)
+      {
+         for(k=0;k<3;k++)
+         {
+            ap[k]=helix[i].ca_coord[g][k]-helix[i].ca_coord[0][k];
+         }
+
+         /* project the C-alpha onto the segment and take the distance to that point */
+
+         t=0.0;
+         if(len2>0.0) t=(ap[0]*ab[0]+ap[1]*ab[1]+ap[2]*ab[2])/len2;
+         if(t<0.0) t=0.0;
+         if(t>1.0) t=1.0;
+
+         dist2=SQR(ap[0]-t*ab[0])+SQR(ap[1]-t*ab[1])+SQR(ap[2]-t*ab[2]);
+
+         if(dist2>r2) r2=dist2;
+      }
+
+      capsule[i].radius=sqrt(r2)+NEIGHBOUR_MARGIN;
+
+      for(k=0;k<3;k++)
+      {
+         capsule[i].lo[k]=helix[i].ca_coord[0][k];
+         capsule[i].hi[k]=helix[i].ca_coord[0][k];
+
+         if(helix[i].ca_coord[n-1][k]<capsule[i].lo[k]) capsule[i].lo[k]=helix[i].ca_coord[n-1][k];
+         if(helix[i].ca_coord[n-1][k]>capsule[i].hi[k]) capsule[i].hi[k]=helix[i].ca_coord[n-1][k];
+
+         capsule[i].lo[k]-=capsule[i].radius;
+         capsule[i].hi[k]+=capsule[i].radius;
+      }
+
+      order[i]=i;
+   }
+
+   /* build the hierarchy top down - each node is split at the median of its widest dimension */
+
+   if(*helices_total>0)
+   {
+      node[0].first=0;
+      node[0].count=*helices_total;
+      nodes_total=1;
+   }
+
+   for(n=0;n<nodes_total;n++)
+   {
+      for(k=0;k<3;k++)
+      {
+         node[n].lo[k]=capsule[order[node[n].first]].lo[k];
+         node[n].hi[k]=capsule[order[node[n].first]].hi[k];
+      }
+
+      for(g=node[n].first;g<node[n].first+node[n].count;g++)
+      {
+         for(k=0;k<3;k++)
+         {
+            if(capsule[order[g]].lo[k]<node[n].lo[k]) node[n].lo[k]=capsule[order[g]].lo[k];
+            if(capsule[order[g]].hi[k]>node[n].hi[k]) node[n].hi[k]=capsule[order[g]].hi[k];
+         }
+      }
+
+      node[n].left=-1;
+      node[n].right=-1;
+
+      if(node[n].count<=HELIXNODE_SIZE) continue;
+
+      k=0;
+      if(node[n].hi[1]-node[n].lo[1]>node[n].hi[k]-node[n].lo[k]) k=1;
+      if(node[n].hi[2]-node[n].lo[2]>node[n].hi[k]-node[n].lo[k]) k=2;
+
+      /* insertion sort of the node's helices on the centre of their boxes */
+
+      for(g=node[n].first+1;g<node[n].first+node[n].count;g++)
+      {
+         i=order[g];
+
+         for(h=g-1;(h>=node[n].first) && (capsule[order[h]].lo[k]+capsule[order[h]].hi[k]>capsule[i].lo[k]+capsule[i].hi[k]);h--)
+         {
+            order[h+1]=order[h];
+         }
+         order[h+1]=i;
+      }
+
+      node[n].left=nodes_total;
+      node[n].right=nodes_total+1;
+
+      node[nodes_total].first=node[n].first;
+      node[nodes_total].count=node[n].count/2;
+      node[nodes_total+1].first=node[n].first+node[n].count/2;
+      node[nodes_total+1].count=node[n].count-node[n].count/2;
+
+      nodes_total+=2;
+   }
+
+   /* query the hierarchy with each capsule, widened by the neighbour distance */
+
+   reach=NEIGHBOUR_DISTANCE+NEIGHBOUR_MARGIN;
+
+   for(i=0;i<*helices_total;i++)
+   {
+      for(k=0;k<3;k++)
+      {
+         lo[k]=capsule[i].lo[k]-reach;
+         hi[k]=capsule[i].hi[k]+reach;
+      }
+
+      stack_total=0;
+      if(nodes_total>0) stack[stack_total++]=0;
+
+      while(stack_total>0)
+      {
+         n=stack[--stack_total];
+
+         if((node[n].lo[0]>hi[0]) || (node[n].hi[0]<lo[0]) || (node[n].lo[1]>hi[1]) || (node[n].hi[1]<lo[1]) || (node[n].lo[2]>hi[2]) || (node[n].hi[2]<lo[2])) continue;
+
+         if(node[n].left>=0)
+         {
+            stack[stack_total++]=node[n].left;
+            stack[stack_total++]=node[n].right;
+            continue;
+         }
+
+         for(g=node[n].first;g<node[n].first+node[n].count;g++)
+         {
+            j=order[g];
+
+            if(j<=i) continue;
+
+            if(capsule_distance(&capsule[i], &capsule[j])>reach) continue;
+
+            if(*candidates_total==candidates_max)
+            {
+               if((candidate=(int *) arena_realloc(arena,candidate,2*candidates_max*sizeof(int),4*candidates_max*sizeof(int)))==NULL) return NULL;
+               candidates_max*=2;
+            }
+
+            candidate[2*(*candidates_total)]=i;
+            candidate[2*(*candidates_total)+1]=j;
+            (*candidates_total)++;
+         }
+      }
+   }
+
+   /* same order as the full (helix two, helix one <= helix two) scan that this replaces */
+
+   qsort(candidate, *candidates_total, 2*sizeof(int), compare_candidates);
+
+   return candidate;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to get the closest distance between the surfaces of two capsules (negative if they overlap) */
+/* the closest points of the two axis segments follow dist3D_Segment_to_Segment() as used in skew.h, */
+/* but in double precision and with a relative test for parallel axes, as the capsules must never be */
+/* reported further apart than they are */
+double capsule_distance(struct CAPSULE *A, struct CAPSULE *B)
+{
+   /* Variables */
+
+   double u[3], v[3], w[3], dP[3];
+   double a, b, c, d, e, D;
+   double sc, sN, sD, tc, tN, tD;
+   int k;
+
+
+   for(k=0;k<3;k++)
+   {
+      u[k]=A->p1[k]-A->p0[k];
+      v[k]=B->p1[k]-B->p0[k];
+      w[k]=A->p0[k]-B->p0[k];
+   }
+
+   a=u[0]*u[0]+u[1]*u[1]+u[2]*u[2];
+   b=u[0]*v[0]+u[1]*v[1]+u[2]*v[2];
+   c=v[0]*v[0]+v[1]*v[1]+v[2]*v[2];
+   d=u[0]*w[0]+u[1]*w[1]+u[2]*w[2];
+   e=v[0]*w[0]+v[1]*w[1]+v[2]*w[2];
+   D=a*c-b*b;
+   sD=D;
+   tD=D;
+
+   if(D<=1.0e-6*a*c)          /* parallel, or one of the segments is a single point */
+   {
+      sN=0.0;
+      sD=1.0;
+      tN=e;
+      tD=c;
+   }
+   else
+   {
+      sN=b*e-c*d;
+      tN=a*e-b*d;
+
+      if(sN<0.0)
+      {
+         sN=0.0;
+         tN=e;
+         tD=c;
+      }
+      else if(sN>sD)
+      {
+         sN=sD;
+         tN=e+b;
+         tD=c;
+      }
+   }
+
+   if(tN<0.0)
+   {
+      tN=0.0;
+
+      if(-d<0.0) sN=0.0;
+      else if(-d>a) sN=sD;
+      else
+      {
+         sN=-d;
+         sD=a;
+      }
+   }
+   else if(tN>tD)
+   {
+      tN=tD;
+
+      if((-d+b)<0.0) sN=0.0;
+      else if((-d+b)>a) sN=sD;
+      else
+      {
+         sN=-d+b;
+         sD=a;
+      }
+   }
+
+   sc=(sD>0.0) ? sN/sD : 0.0;
+   tc=(tD>0.0) ? tN/tD : 0.0;
+
+   for(k=0;k<3;k++)
+   {
+      dP[k]=w[k]+sc*u[k]-tc*v[k];
+   }
+
+   return sqrt(dP[0]*dP[0]+dP[1]*dP[1]+dP[2]*dP[2])-A->radius-B->radius;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Comparison of two candidate helix pairs for qsort(), by helix two and then by helix one */
+int compare_candidates(const void *a, const void *b)
+{
+   const int *p=(const int *) a;
+   const int *q=(const int *) b;
+
+   if(p[1]!=q[1]) return (p[1]<q[1]) ? -1 : 1;
+   if(p[0]!=q[0]) return (p[0]<q[0]) ? -1 : 1;
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to determine whether two helices may be packed (i.e. are neighbours), returns 1 if they are */
+/* C-alpha distances are worked out as they are needed, and the scan stops at the first pair within 10 Angstroms */
+int residue_distance(int helix1, int helix2, struct HELIX *helix)
+{
+   /* Variables */
+
+   int g,h,i,j,m,n;
+   int neighbour=0;
+   float distance;
+
+
+   i=helix1;
+   j=helix2;
+
+   if(i!=j)
+   {
+      /* different helices are neighbours if they have C-alpha atoms within 10 Angstroms of each other */
+      /* and the distance between their midpoint C-alphas is less than 25 Angstroms */
+
+      m=helix[i].residues_total/2;    /* middle C-alpha of helix 1 */
+      n=helix[j].residues_total/2;    /* middle C-alpha of helix 2 */
+
+      distance=sqrt(pow(helix[i].ca_coord[m][0]-helix[j].ca_coord[n][0],2.0)+pow(helix[i].ca_coord[m][1]-helix[j].ca_coord[n][1],2.0)+pow(helix[i].ca_coord[m][2]-helix[j].ca_coord[n][2],2.0));
+
+      if(distance<=25.0) 
+      {
+         for(g=0; (g<helix[i].residues_total) && (!neighbour); g++)
+         {
+            for(h=0; (h<helix[j].residues_total) && (!neighbour); h++)
+            {
+               distance=sqrt(pow(helix[i].ca_coord[g][0]-helix[j].ca_coord[h][0],2.0)+pow(helix[i].ca_coord[g][1]-helix[j].ca_coord[h][1],2.0)+pow(helix[i].ca_coord[g][2]-helix[j].ca_coord[h][2],2.0));
+
+               if(distance<=10.0) 
+               {
+                  neighbour=1;     
+               }
+            }
+         }
+      }
+//    printf("\n\nH%d,H%d,midpoint distance=%f Ang\n",i,j,distance);
+   }
+
+   return neighbour;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to sort all the helix atoms of a protein into a uniform grid of cells at least CONTACT_CUTOFF wide, */
+/* so that atoms within CONTACT_CUTOFF of each other are always in the same or in adjacent cells */
+struct CELLGRID* make_cell_grid(struct HELIX *helix, struct ATOMSTORE *atoms, int *helices_total, struct ARENA *arena)
+{
+   /* Variables */
+
+   struct CELLGRID *grid;
+   double max[3];
+   float coord[3];
+   int cells_total;
+   int a,g,i,k,n=0;
+   int atoms_max=0;
+
+
+   if((grid=(struct CELLGRID *) arena_alloc(arena,sizeof(struct CELLGRID)))==NULL) return NULL;
+
+   if((grid->helix_start=(int *) arena_alloc(arena,(*helices_total+1)*sizeof(int)))==NULL) return NULL;
+
+   /* atoms are numbered as in the atom store; find the extent of the protein */
+
+   for(k=0;k<3;k++)
+   {
+      grid->min[k]=0.0;
+      max[k]=0.0;
+   }
+
+   for(i=0;i<*helices_total;i++)
+   {
+      grid->helix_start[i]=atoms->helix_start[i];
+
+      for(g=0;g<helix[i].atoms_total;g++)
+      {
+         a=atoms->helix_start[i]+g;
+
+         coord[0]=atoms->x[a];
+         coord[1]=atoms->y[a];
+         coord[2]=atoms->z[a];
+
+         for(k=0;k<3;k++)
+         {
+            if((n==0) || (coord[k]<grid->min[k])) grid->min[k]=coord[k];
+            if((n==0) || (coord[k]>max[k])) max[k]=coord[k];
+         }
+         n++;
+      }
+
+      if(helix[i].atoms_total>atoms_max) atoms_max=helix[i].atoms_total;
+   }
+
+   grid->helix_start[*helices_total]=atoms->helix_start[*helices_total];
+
+   grid->cell=GRID_CELL;
+
+   cells_total=size_grid(grid, max);
+
+   if((grid->atom_cell=(int *) arena_alloc(arena,(atoms->atoms_total+1)*sizeof(int)))==NULL) return NULL;
+   grid->atoms_max=atoms_max;
+
+   /* the helix atoms follow one another in the atom store, from the first atom of the first helix */
+
+   for(a=0;a<n;a++) grid->atom_cell[a]=grid_cell(grid, atoms->x[a], atoms->y[a], atoms->z[a]);
+
+   if(fill_grid(grid, cells_total, n, arena)) return NULL;
+
+   return grid;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to size the cells of a grid from its lowest corner and smallest cell to the highest point max, */
+/* returning the number of cells */
+int size_grid(struct CELLGRID *grid, double *max)
+{
+   /* Variables */
+
+   double cells_total;
+   int k;
+
+
+   /* coarsen the cells of very large proteins so that the grid stays a reasonable size */
+
+   do
+   {
+      cells_total=1.0;
+
+      for(k=0;k<3;k++)
+      {
+         grid->cells[k]=(int)((max[k]-grid->min[k])/grid->cell)+1;
+         cells_total*=grid->cells[k];
+      }
+
+      if(cells_total>MAXGRIDCELLS) grid->cell*=1.25;
+   }
+   while(cells_total>MAXGRIDCELLS);
+
+   return (int)cells_total;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to give the cell of a grid that a point lies in */
+int grid_cell(struct CELLGRID *grid, double x, double y, double z)
+{
+   /* Variables */
+
+   int c;
+
+
+   c=(int)((z-grid->min[2])/grid->cell);
+   c=c*grid->cells[1]+(int)((y-grid->min[1])/grid->cell);
+   c=c*grid->cells[0]+(int)((x-grid->min[0])/grid->cell);
+
+   return c;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to sort points 0 to points_total-1 into the cells of a grid, once atom_cell holds their cells. Returns 0, */
+/* or -1 if there is no memory for the cells */
+int fill_grid(struct CELLGRID *grid, int cells_total, int points_total, struct ARENA *arena)
+{
+   /* Variables */
+
+   int a,c;
+
+
+   grid->cell_start=(int *) arena_alloc(arena,(cells_total+1)*sizeof(int));
+   grid->atom_list=(int *) arena_alloc(arena,(points_total+1)*sizeof(int));
+
+   if((grid->cell_start==NULL) || (grid->atom_list==NULL)) return -1;
+
+   /* count the points in each cell, then turn the counts into the first entry of each cell */
+
+   for(a=0;a<points_total;a++) grid->cell_start[grid->atom_cell[a]+1]++;
+
+   for(c=0;c<cells_total;c++)
+   {
+      grid->cell_start[c+1]+=grid->cell_start[c];
+   }
+
+   /* drop the points into their cells in ascending order, which leaves each cell_start */
+   /* pointing at the end of its cell, so shift them back by one cell afterwards */
+
+   for(a=0;a<points_total;a++) grid->atom_list[grid->cell_start[grid->atom_cell[a]]++]=a;
+
+   for(c=cells_total;c>0;c--)
+   {
+      grid->cell_start[c]=grid->cell_start[c-1];
+   }
+   grid->cell_start[0]=0;
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to list the points numbered first to last-1 that lie in the cells around a given point, */
+/* cell by cell; the list is left in list and its length is returned */
+int grid_near(struct CELLGRID *grid, int point, int first, int last, int *list)
+{
+   /* Variables */
+
+   int cx, cy, cz, x, y, z;
+   int c, lo, hi, mid;
+   int n=0;
+
 
-      for(j=0;j<origins_total;j++)
+   c=grid->atom_cell[point];
+
+   cx=c%grid->cells[0];
+   cy=(c/grid->cells[0])%grid->cells[1];
+   cz=c/(grid->cells[0]*grid->cells[1]);
+
+   for(z=cz-1;z<=cz+1;z++)
+   {
+      if((z<0) || (z>=grid->cells[2])) continue;
+
+      for(y=cy-1;y<=cy+1;y++)
       {
-         x3 = rx[j] * rx[j] * rx[j] + x3;
-         y3 = ry[j] * ry[j] * ry[j] + y3;
-         x2y = rx[j] * rx[j] * ry[j] + x2y;
-         xy2 = rx[j] * ry[j] * ry[j] + xy2;
-         x2 = rx[j] * rx[j] + x2;
-         y2 = ry[j] * ry[j] + y2;
-         xy = rx[j] * ry[j] + xy;
-         x = rx[j] + x;
-         y = ry[j] + y;
-      }
+         if((y<0) || (y>=grid->cells[1])) continue;
 
-      matc[0][0]=x2+matc[0][0];
-      matc[0][1]=xy+matc[0][1];
-      matc[0][2]=-x+matc[0][2];
-      matc[1][0]=xy+matc[1][0];
-      matc[1][1]=y2+matc[1][1];
-      matc[1][2]=-y+matc[1][2];
-      matc[2][0]=x+matc[2][0];
-      matc[2][1]=y+matc[2][1];
-      matc[2][2]=-origins_total+matc[2][2];
+         for(x=cx-1;x<=cx+1;x++)
+         {
+            if((x<0) || (x>=grid->cells[0])) continue;
 
-      cmat=matinv3(matc);
+            c=(z*grid->cells[1]+y)*grid->cells[0]+x;
 
-      bc1=-x3-xy2;
-      bc2=-x2y-y3;
-      bc3=-x2-y2;
+            /* points within a cell are in ascending order, so find the first one in range */
 
-      for(j=0;j<3;j++)
-      {
-         ac[j]=0.0;
-      }
+            lo=grid->cell_start[c];
+            hi=grid->cell_start[c+1];
 
-      for(j=0;j<3;j++)
-      {
-         ac[j]=cmat[j][0]*bc1+cmat[j][1]*bc2+cmat[j][2]*bc3+ac[j];
+            while(lo<hi)
+            {
+               mid=(lo+hi)/2;
+
+               if(grid->atom_list[mid]<first) lo=mid+1;
+               else hi=mid;
+            }
+
+            for(;(lo<grid->cell_start[c+1]) && (grid->atom_list[lo]<last);lo++)
+            {
+               list[n++]=grid->atom_list[lo];
+            }
+         }
       }
+   }
 
-      ac[0]=ac[0]/2.0;
-      ac[1]=ac[1]/2.0;
-      ac[2]=ac[2];
+   return n;
+}
 
-      radcsq=SQR(ac[0])+SQR(ac[1])+ac[2];
+/* ------------------------------------------------------------------------- */
 
-      if(radcsq>0.0)
-      {
-         radc=sqrt(radcsq);
-         fprintf(fpo_geom,"Radius of the best circle: %f\n",radc);
-         fprintf(fpo_geom,"Centre of the best circle: %f, %f\n",-ac[1],-ac[2]);
-      }
-      else
-      {
-         radc=0.0;
-         fprintf(fpo_geom,"Fit of the circle is not good\n\n");
-      }
+/* Function to make the scratch lists for one thread scanning the grid, long enough for any helix; NULL if there */
+/* is no memory for them */
+struct SCANSCRATCH* make_scan_scratch(struct CELLGRID *grid, struct ARENA *arena)
+{
+   /* Variables */
 
-      sumc=0.0;
+   struct SCANSCRATCH *scratch;
 
-      /* dev=sqrt((x+a)^2+(y+b)^2)-r */
-      /* rms dev=sqrt(dev^2/n) */
 
-      for(j=0;j<origins_total;j++)
-      {
-         rem=SQR(rx[j]+ac[0])+SQR(ry[j]+ac[1]);
-         rmc[j]=sqrt(rem)-radc;
-         sumc=sumc+SQR(rmc[j]);
-      }
+   if((scratch=(struct SCANSCRATCH *) arena_alloc(arena,sizeof(struct SCANSCRATCH)))==NULL) return NULL;
 
-      if(sumc<0.0)
-      {
-         fprintf(fpo_geom,"Fit of the circle is not good\n\n");
-      }
-      else
-      {
-         rmsdc=sqrt(sumc/origins_total);
-         fprintf(fpo_geom,"RMS deviation from the best circle: %f\n",rmsdc);
-      }
+   scratch->candidates=(int *) arena_alloc(arena,(grid->atoms_max+1)*sizeof(int));
+   scratch->near=(int *) arena_alloc(arena,(grid->atoms_max+1)*sizeof(int));
+   scratch->near_d2=(double *) arena_alloc(arena,(grid->atoms_max+1)*sizeof(double));
 
-      /* Fitting line to the reorientated points - equation of line y=mx+c */
+   if(arena->failed) return NULL;
 
-      matl[0][0]=x2+matl[0][0];
-      matl[0][1]=x+matl[0][1];
-      matl[1][0]=x+matl[1][0];
-      matl[1][1]=origins_total+matl[1][1];
+   return scratch;
+}
 
-      lmat=matinv2(matl);
+/* ------------------------------------------------------------------------- */
 
-      bl1=xy;
-      bl2=y;
+/* Function to list the atoms of one helix (in atom order) that lie in the cells around a given atom */
+/* atom is a global atom number, the list is left in scratch->candidates and its length is returned */
+int near_atoms(struct CELLGRID *grid, struct SCANSCRATCH *scratch, int atom, int helix_number)
+{
+   /* Variables */
 
-      al[0]=0.0;
-      al[1]=0.0;
+   int first;
+   int c,g,h,n;
 
-      for(j=0;j<2;j++)
-      {
-         al[j]=lmat[j][0]*bl1+lmat[j][1]*bl2+al[j];
-      }
 
-      fprintf(fpo_geom,"Slope of the best line: %f\n",al[0]);
-      fprintf(fpo_geom,"Intercept of the best line: %f\n",al[1]);
+   first=grid->helix_start[helix_number];
 
-      suml=0.0;
+   n=grid_near(grid, atom, first, grid->helix_start[helix_number+1], scratch->candidates);
 
-      for(j=0;j<origins_total;j++)
-      {
-         rml[j]=ry[j]-al[0]*rx[j]-al[1];
-         suml=suml+SQR(rml[j]);
-      }
+   /* number the atoms within the helix, and put the atoms from the different cells back into atom order */
 
-      if(suml<0.0) fprintf(fpo_geom,"Fit to the line is not good\n\n");
+   for(g=0;g<n;g++) scratch->candidates[g]-=first;
 
-      else
+   for(g=1;g<n;g++)
+   {
+      h=scratch->candidates[g];
+
+      for(c=g-1;(c>=0) && (scratch->candidates[c]>h);c--)
       {
-         rmsdl=sqrt(suml/origins_total);
-         fprintf(fpo_geom,"RMS deviation from best line: %f\n",rmsdl);
+         scratch->candidates[c+1]=scratch->candidates[c];
       }
+      scratch->candidates[c+1]=h;
+   }
 
-      /* Linear correlation coefficient */
-      /* r=(n*(xy)-x*y)/sqrt((n*x2-x*x)*(n*y2-y*y)) */
-
-      rnum=origins_total*xy-x*y;
-      rdeno=(origins_total*x2-x*x)*(origins_total*y2-y*y);
-      r=rnum/sqrt(rdeno);
-      r2=r*r;
-      fprintf(fpo_geom,"Square of linear correlation coefficient: %f\n",r2);
+   return n;
+}
 
-      /* Assign geometry to helix - (U)nknown, (C)urved or (L)inear */
+/* ------------------------------------------------------------------------- */
 
-      if((helix[i].max_bending_angle<20.0) && (helix[i].geometry!='K'))
-      {
-         ratio=rmsdl/rmsdc;
+/* Function to generate an empty list of contacting atom pairs, NULL if there is no memory for it */
+struct CONTACTLIST* make_contact_list(struct ARENA *arena)
+{
+   /* Variables */
 
-         fprintf(fpo_geom,"Ratio rmsdl/rmsdc: %f",ratio);
+   struct CONTACTLIST *contacts;
 
-         if((rmsdc>1.0) && (rmsdl>1.0))
-         {
-            helix[i].geometry='U';
-         }
 
-         else if(ratio>1.0) helix[i].geometry='C';
+   if((contacts=(struct CONTACTLIST *) arena_alloc(arena,sizeof(struct CONTACTLIST)))==NULL) return NULL;
 
-         else if((ratio<=0.7) && (r2>=0.8)) helix[i].geometry='L';
+   contacts->arena=arena;
+   contacts->contacts_max=256;
 
-         else if((ratio>0.7) && (ratio<=1.0) && (r2<=0.5)) helix[i].geometry='C';
+   if((contacts->contact=(struct CONTACT *) arena_alloc(arena,contacts->contacts_max*sizeof(struct CONTACT)))==NULL) return NULL;
 
-         else if((ratio>0.7) && (ratio<=1.0) && (r2>=0.8)) helix[i].geometry='L';
+   return contacts;
+}
 
-         else if((ratio>0.7) && (ratio<=1.0) && (r2>0.5) && (r2<0.8)) helix[i].geometry='U';
+/* ------------------------------------------------------------------------- */
 
-         else helix[i].geometry='U';
-      }
+/* Function to append a contacting atom pair to a contact list; the pair is left out if there is no memory for it, */
+/* which the arena of the list then reports */
+void add_contact(struct CONTACTLIST *contacts, int atom1, int atom2, float distance, char type)
+{
+   /* Variables */
 
-      fprintf(fpo_geom,"\n\n");
+   struct CONTACT *contact;
 
-      destroy_matrix3(matp);
-      destroy_matrix3(matc);
-      destroy_matrix2(matl);
-      destroy_matrix3(pmat);
-      destroy_matrix3(cmat);
-      destroy_matrix2(lmat);
-   }
 
-   else
+   if(contacts->contacts_total==contacts->contacts_max)
    {
-      fprintf(fpo_geom,"Helix %d is less than 9 residues and cannot undergo accurate line/curve fitting\n\n",i);
+      if((contact=(struct CONTACT *) arena_realloc(contacts->arena,contacts->contact,contacts->contacts_max*sizeof(struct CONTACT),2*contacts->contacts_max*sizeof(struct CONTACT)))==NULL) return;
+
+      contacts->contact=contact;
+      contacts->contacts_max*=2;
    }
 
-   fclose(fpo_geom);
+   contact=&contacts->contact[contacts->contacts_total++];
+
+   contact->atom1=atom1;
+   contact->atom2=atom2;
+   contact->distance=distance;
+   contact->type=type;
 }
 
 /* ------------------------------------------------------------------------- */
 
-/* Function to calculate the inverse of a 3 x 3 matrix */
-double** matinv3(double **h) 
+/* Function to find the largest squared distance that passes the test distance <= limit, where distance */
+/* is the square root of the squared distance rounded to a float, as in the contact tests */
+double squared_cutoff(float limit)
 {
    /* Variables */
 
-   double deth, deth1, deth2, deth3;
-   int i,j,k;
-   double c11,c12,c13,c21,c22,c23,c31,c32,c33;
-   double **s; 
+   double d2;
+   double midpoint;
 
 
-   s = (double **) calloc(3,sizeof(double *));
-   
-   for(i=0; i<3; i++)
-   {
-      s[i] = (double *) calloc(3,sizeof(double));
-   }
+   /* start from the square of the midpoint between limit and the next float, then step to the edge */
 
-   for(j=0; j<3; j++)
+   midpoint=(double)limit+((double)nextafterf(limit,HUGE_VALF)-(double)limit)/2.0;
+   d2=midpoint*midpoint;
+
+   while((float)sqrt(d2)>limit) d2=nextafter(d2,0.0);
+   while((float)sqrt(nextafter(d2,HUGE_VAL))<=limit) d2=nextafter(d2,HUGE_VAL);
+
+   return d2;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to give the H-bond distance of two atoms from their class bits and donor states */
+/* (0 no donor, 1 donor, 2 any other non-zero donor value) */
+float hbond_length(int class1, int donor1, int class2, int donor2)
+{
+   /* Variables */
+
+   float hbond_distance=0.0;
+
+
+   if((class1 & CLASS_O) && (class2 & CLASS_O))
    {
-      for(k=0; k<3; k++)
+      if((donor1==1) || (donor2==1))
       {
-         s[j][k]=0.0;
+         hbond_distance=2.70;
       }
+      else hbond_distance=0.0;
    }
 
-   c11=h[1][1]*h[2][2]-h[2][1]*h[1][2];
-   c12=h[1][0]*h[2][2]-h[2][0]*h[1][2];
-   c13=h[1][0]*h[2][1]-h[2][0]*h[1][1];
-   c21=h[0][1]*h[2][2]-h[0][2]*h[2][1];
-   c22=h[0][0]*h[2][2]-h[0][2]*h[2][0];
-   c23=h[0][0]*h[2][1]-h[2][0]*h[0][1];
-   c31=h[0][1]*h[1][2]-h[0][2]*h[1][1];
-   c32=h[0][0]*h[1][2]-h[0][2]*h[1][0];
-   c33=h[0][0]*h[1][1]-h[0][1]*h[1][0];
+   if((class1 & CLASS_O) && (class2 & CLASS_N))
+   {
+      if(donor2) hbond_distance=3.04; /* N is donor */
 
-   deth1=h[0][0]*c11;
-   deth2=-h[0][1]*c12;
-   deth3=h[0][2]*c13;
-   deth=deth1+deth2+deth3;
+      else if((donor1==1) && (donor2==0)) /* O is donor and N is not */ 
+      {
+         hbond_distance=2.88;
+      }
+      else hbond_distance=0.0;
+   }
 
-   if(deth!=0.0)
+   if((class1 & CLASS_N) && (class2 & CLASS_O))
    {
-      s[0][0]=c11/deth+s[0][0];
-      s[0][1]=-c21/deth+s[0][1];
-      s[0][2]=c31/deth+s[0][2];
-      s[1][0]=-c12/deth+s[1][0];
-      s[1][1]=c22/deth+s[1][1];
-      s[1][2]=-c32/deth+s[1][2];
-      s[2][0]=c13/deth+s[2][0];
-      s[2][1]=-c23/deth+s[2][1];
-      s[2][2]=c33/deth+s[2][2];
+      if(donor1) hbond_distance=3.04; /* N is donor */
+
+      else if((donor1==0) && (donor2==1)) /* O is donor and N is not */ 
+      {
+         hbond_distance=2.88;
+      }
+      else hbond_distance=0.0;
    }
-   else
+
+   if((class1 & CLASS_N) && (class2 & CLASS_N))
    {
-   printf("\n\n** ERROR ** determinant of (3x3) matrix is zero, no inverse possible!\n\n");
+      if((donor1==1) || (donor2==1))
+      {
+         hbond_distance=3.10;
+      }
+      else hbond_distance=0.0;
    }
 
-   return s;
+   return hbond_distance;
 }
 
 /* ------------------------------------------------------------------------- */
 
-/* Function to calculate the inverse of a 2 x 2 matrix */
-double** matinv2(double **p) 
+/* Function to fill the global table of squared contact distances, once at startup */
+void make_cutoffs(void)
 {
    /* Variables */
 
-   double detp, detp1, detp2;
-   int i,j,k;
-   double c11,c12,c21,c22;
-   double **q; 
+   int e1,e2,k1,k2;
+   float vdw_rad_sum;
+   float vdw_rad_sum2;
+   float cov_rad_sum;
+   float limit;
+   double hbond_limit;
 
 
-   q = (double **) calloc(2,sizeof(double *));
-   
-   for(i=0; i<2; i++)
+   for(e1=0;e1<5;e1++)
    {
-      q[i] = (double *) calloc(2,sizeof(double));
+      for(e2=0;e2<5;e2++)
+      {
+         /* same arithmetic as the original per-pair tests, rounded to float where they were */
+
+         vdw_rad_sum = (vdw_radius[e1] + vdw_radius[e2]) + TOLERANCE;
+         vdw_rad_sum2 = (vdw_radius[e1] + vdw_radius[e2]) * TOLERANCE2;
+         cov_rad_sum = (cov_radius[e1] + cov_radius[e2]) * TOLERANCE2;
+
+         cutoffs.packing[e1][e2]=squared_cutoff(vdw_rad_sum);
+         cutoffs.vdw[e1][e2]=squared_cutoff(vdw_rad_sum2);
+         cutoffs.covalent[e1][e2]=squared_cutoff(cov_rad_sum);
+      }
    }
 
-   for(j=0; j<2; j++)
+   /* H-bond limits are double, a float distance passes if it is at most the largest float below the limit */
+
+   for(k1=0;k1<HBOND_KEYS;k1++)
    {
-      for(k=0; k<2; k++)
+      for(k2=0;k2<HBOND_KEYS;k2++)
       {
-         q[j][k]=0.0;
+         hbond_limit=hbond_length(k1/3,k1%3,k2/3,k2%3) * TOLERANCE2;
+
+         limit=(float)hbond_limit;
+         if(limit>hbond_limit) limit=nextafterf(limit,0.0);
+
+         cutoffs.hbond[k1][k2]=squared_cutoff(limit);
       }
    }
 
-   c11=p[1][1];
-   c12=p[1][0];
-   c21=p[0][1];
-   c22=p[0][0];
+   cutoffs.electrostatic=squared_cutoff(CONTACT_CUTOFF);
 
-   detp1=p[0][0]*c11;
-   detp2=-p[0][1]*c12;
-   detp=detp1+detp2;
+   cutoffs.reach=cutoffs.electrostatic;
 
-   if(detp!=0.0)
+   for(e1=0;e1<5;e1++)
    {
-      q[0][0]=c11/detp+q[0][0];
-      q[0][1]=-c21/detp+q[0][1];
-      q[1][0]=-c12/detp+q[1][0];
-      q[1][1]=c22/detp+q[1][1];
+      for(e2=0;e2<5;e2++)
+      {
+         if(cutoffs.packing[e1][e2]>cutoffs.reach) cutoffs.reach=cutoffs.packing[e1][e2];
+         if(cutoffs.vdw[e1][e2]>cutoffs.reach) cutoffs.reach=cutoffs.vdw[e1][e2];
+         if(cutoffs.covalent[e1][e2]>cutoffs.reach) cutoffs.reach=cutoffs.covalent[e1][e2];
+      }
    }
-   else
+
+   for(k1=0;k1<HBOND_KEYS;k1++)
    {
-   printf("\n\n** ERROR ** determinant of (2x2) matrix is zero, no inverse possible!\n\n");
+      for(k2=0;k2<HBOND_KEYS;k2++)
+      {
+         if(cutoffs.hbond[k1][k2]>cutoffs.reach) cutoffs.reach=cutoffs.hbond[k1][k2];
+      }
+   }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to pick the widest distance kernel the processor supports (built with -DSCALAR_KERNEL, */
+/* the scalar one is always used) */
+void choose_distance_kernel(void)
+{
+   distance_kernel=distance_scalar;
+
+#ifdef X86_KERNELS
+   __builtin_cpu_init();
+
+   if(__builtin_cpu_supports("avx512f")) distance_kernel=distance_avx512;
+   else if(__builtin_cpu_supports("avx2")) distance_kernel=distance_avx2;
+#endif
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to list the candidates within reach of an atom, one at a time */
+int distance_scalar(float ax, float ay, float az, const float *x, const float *y, const float *z, const int *candidate, int candidates_total, double reach, int *near, double *near_d2)
+{
+   /* Variables */
+
+   int h,l,n=0;
+   float dx,dy,dz;
+   double d2;
+
+
+   for(l=0; l<candidates_total; l++)
+   {
+      h=candidate[l];
+
+      dx=ax-x[h];
+      dy=ay-y[h];
+      dz=az-z[h];
+
+      d2=(double)dx*dx+(double)dy*dy+(double)dz*dz;
+
+      if(d2<=reach)
+      {
+         near[n]=h;
+         near_d2[n++]=d2;
+      }
    }
 
-   return q;
+   return n;
 }
 
+#ifdef X86_KERNELS
+
 /* ------------------------------------------------------------------------- */
 
-/* Free up the memory taken by the 3x3 inverse matrix (s) */
-void destroy_matrix3(double **s)
+/* Function to list the candidates within reach of an atom, gathering eight at a time. The */
+/* coordinate differences are taken in float and squared in double, exactly as in distance_scalar() */
+__attribute__((target("avx2")))
+int distance_avx2(float ax, float ay, float az, const float *x, const float *y, const float *z, const int *candidate, int candidates_total, double reach, int *near, double *near_d2)
 {
    /* Variables */
 
-   int i;
+   int k,l,n=0;
+   int mask;
+   __m256 vax,vay,vaz;
+   __m256 dx,dy,dz;
+   __m256d vreach;
+   __m256d d2[2];
+   __m256i index;
+   double d2_lane[8];
 
 
-   for (i=0; i<3; i++)
+   vax=_mm256_set1_ps(ax);
+   vay=_mm256_set1_ps(ay);
+   vaz=_mm256_set1_ps(az);
+   vreach=_mm256_set1_pd(reach);
+
+   for(l=0; l+8<=candidates_total; l+=8)
    {
-       free(s[i]);
-   }
-   free(s);
-}
+      index=_mm256_loadu_si256((const __m256i *)(candidate+l));
 
-/* ------------------------------------------------------------------------- */
+      dx=_mm256_sub_ps(vax,_mm256_i32gather_ps(x,index,4));
+      dy=_mm256_sub_ps(vay,_mm256_i32gather_ps(y,index,4));
+      dz=_mm256_sub_ps(vaz,_mm256_i32gather_ps(z,index,4));
 
-/* Free up the memory taken by the 2x2 inverse matrix (q) */
-void destroy_matrix2(double **q)
-{
-   /* Variables */
+      for(k=0;k<2;k++)
+      {
+         __m256d ddx=_mm256_cvtps_pd(k ? _mm256_extractf128_ps(dx,1) : _mm256_castps256_ps128(dx));
+         __m256d ddy=_mm256_cvtps_pd(k ? _mm256_extractf128_ps(dy,1) : _mm256_castps256_ps128(dy));
+         __m256d ddz=_mm256_cvtps_pd(k ? _mm256_extractf128_ps(dz,1) : _mm256_castps256_ps128(dz));
 
-   int i;
+         d2[k]=_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(ddx,ddx),_mm256_mul_pd(ddy,ddy)),_mm256_mul_pd(ddz,ddz));
+      }
 
+      mask=_mm256_movemask_pd(_mm256_cmp_pd(d2[0],vreach,_CMP_LE_OQ));
+      mask|=_mm256_movemask_pd(_mm256_cmp_pd(d2[1],vreach,_CMP_LE_OQ))<<4;
 
-   for (i=0; i<2; i++)
-   {
-       free(q[i]);
+      if(mask==0) continue;
+
+      _mm256_storeu_pd(d2_lane,d2[0]);
+      _mm256_storeu_pd(d2_lane+4,d2[1]);
+
+      /* keep the survivors in candidate order */
+
+      for(;mask;mask&=mask-1)
+      {
+         k=__builtin_ctz(mask);
+
+         near[n]=candidate[l+k];
+         near_d2[n++]=d2_lane[k];
+      }
    }
-   free(q);
+
+   return n+distance_scalar(ax,ay,az,x,y,z,candidate+l,candidates_total-l,reach,near+n,near_d2+n);
 }
 
 /* ------------------------------------------------------------------------- */
 
-/* Function to generate a 2-D structure array of all helices against all helices in the file */
-struct HELIXPAIR** neighbours(int *helices_total)
+/* Function to list the candidates within reach of an atom, gathering sixteen at a time and */
+/* compressing the survivors straight into the near lists */
+__attribute__((target("avx512f")))
+int distance_avx512(float ax, float ay, float az, const float *x, const float *y, const float *z, const int *candidate, int candidates_total, double reach, int *near, double *near_d2)
 {
    /* Variables */
 
-   int g,h,i,j,k;
-   struct HELIXPAIR **helix_pair;
+   int l,n=0;
+   __mmask8 low,high;
+   __m512 vax,vay,vaz;
+   __m512 dx,dy,dz;
+   __m512d vreach;
+   __m512d d2[2];
+   __m512d ddx,ddy,ddz;
+   __m512i index;
 
 
-   /* Allocate the memory for the 2d array of HELIXPAIR dynamically
-    *
-    * ----no. of helices--->
-    *        |
-    *        |
-    *  no. of helices 
-    *        \/
-    */
+   vax=_mm512_set1_ps(ax);
+   vay=_mm512_set1_ps(ay);
+   vaz=_mm512_set1_ps(az);
+   vreach=_mm512_set1_pd(reach);
 
-   helix_pair = (struct HELIXPAIR **) calloc(*helices_total,sizeof(struct HELIXPAIR*));
-   
-   for(k=0; k<*helices_total; k++)
+   for(l=0; l+16<=candidates_total; l+=16)
    {
-      helix_pair[k] = (struct HELIXPAIR *) calloc(*helices_total,sizeof(struct HELIXPAIR));
-   }
-   
-   /* fill entire 2-D array with helix numbers, zeros and negative values */
+      index=_mm512_loadu_si512((const void *)(candidate+l));
 
-   for(g=0; g<*helices_total; g++)
-   {
-      for(h=0; h<*helices_total; h++)
-      {            
-         helix_pair[g][h].helix_one=g;
-         helix_pair[g][h].helix_two=h;
-         helix_pair[g][h].neighbours=0;
-         helix_pair[g][h].packed=0;
-         helix_pair[g][h].h1_residues=-1;
-         helix_pair[g][h].h2_residues=-1;
-         helix_pair[g][h].h1_start=-1;
-         helix_pair[g][h].h2_start=-1;
-         helix_pair[g][h].h1_end=-1;
-         helix_pair[g][h].h2_end=-1;
-         helix_pair[g][h].vdw=0;
-         helix_pair[g][h].hbond=0;
-         helix_pair[g][h].electrostatic=0;
-         helix_pair[g][h].covalent=0;
-         helix_pair[g][h].angle1=-1.0;
-         helix_pair[g][h].angle2=-1.0;
-         helix_pair[g][h].distance=-1.0;
-      }   
+      dx=_mm512_sub_ps(vax,_mm512_i32gather_ps(index,x,4));
+      dy=_mm512_sub_ps(vay,_mm512_i32gather_ps(index,y,4));
+      dz=_mm512_sub_ps(vaz,_mm512_i32gather_ps(index,z,4));
+
+      ddx=_mm512_cvtps_pd(_mm512_castps512_ps256(dx));
+      ddy=_mm512_cvtps_pd(_mm512_castps512_ps256(dy));
+      ddz=_mm512_cvtps_pd(_mm512_castps512_ps256(dz));
+
+      d2[0]=_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(ddx,ddx),_mm512_mul_pd(ddy,ddy)),_mm512_mul_pd(ddz,ddz));
+
+      ddx=_mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(dx),1)));
+      ddy=_mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(dy),1)));
+      ddz=_mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(dz),1)));
+
+      d2[1]=_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(ddx,ddx),_mm512_mul_pd(ddy,ddy)),_mm512_mul_pd(ddz,ddz));
+
+      low=_mm512_cmp_pd_mask(d2[0],vreach,_CMP_LE_OQ);
+      high=_mm512_cmp_pd_mask(d2[1],vreach,_CMP_LE_OQ);
+
+      if((low|high)==0) continue;
+
+      _mm512_mask_compressstoreu_epi32(near+n,(__mmask16)(low|(high<<8)),index);
+      _mm512_mask_compressstoreu_pd(near_d2+n,low,d2[0]);
+      n+=__builtin_popcount(low);
+      _mm512_mask_compressstoreu_pd(near_d2+n,high,d2[1]);
+      n+=__builtin_popcount(high);
    }
 
-return helix_pair;
+   return n+distance_scalar(ax,ay,az,x,y,z,candidate+l,candidates_total-l,reach,near+n,near_d2+n);
 }
 
+#endif
+
 /* ------------------------------------------------------------------------- */
 
-/* Function to determine which helices may be packed (i.e. are neighbours) and assign that information to the HELIXPAIR structure array */
-struct DISTANCE** residue_distance(int helix1, int helix2, struct HELIX *helix, struct HELIXPAIR **helix_pair)
+/* Function to evaluate the atom pairs of two neighbouring helices as they are met: each pair is classified */
+/* as a covalent, electrostatic, H-bond or vdW contact and counted into the helix pair, and the pairs whose */
+/* atoms are close enough to put their residues in contact are appended (in atom order) to contacts, */
+/* unless contacts is NULL. Only atom pairs in neighbouring cells of the grid are tested, as no contact */
+/* reaches beyond CONTACT_CUTOFF. The distance kernel drops the pairs out of reach of every test, the */
+/* rest are classified against the squared limits in cutoffs. Only the helix one atoms from first_atom */
+/* up to (not including) last_atom are scanned */
+void contact_scan(int helix1, int helix2, int first_atom, int last_atom, struct ATOMSTORE *atoms, struct CELLGRID *grid, struct SCANSCRATCH *scratch, struct HELIXPAIR *helix_pair, struct CONTACTLIST *contacts)
 {
    /* Variables */
 
-   int g,h,i,j,k,m,n;
-   struct DISTANCE **residue_residue;
-   char temp_atom_name[5]="XXXX";
-   char atom_name[5]=" CA ";
+   int a,b,g,h,i,j,l;
+   int near_total;
+   int first;
+   int e1,e2;
+   int key1,key2;
+   double d2;
+   char type;
 
-
-   i=helix1;
+   i=helix1;        
    j=helix2;
 
-   /* Allocate the memory for the 2d array of DISTANCE dynamically
-    *
-    * ---- residues for helix 2 ---->
-    *        |
-    *        
-    *   residues for helix 1 
-    *        \/
-    */
+   if(i==j) return;
 
-   residue_residue = (struct DISTANCE **) calloc(helix[i].residues_total,sizeof(struct DISTANCE*));
-   
-   for(k=0; k<helix[i].residues_total; k++)
-   {
-      residue_residue[k] = (struct DISTANCE *) calloc(helix[j].residues_total,sizeof(struct DISTANCE));
-   }
-   
-   /* fill all atom names and residue/helix numbers with junk */
+   first=atoms->helix_start[j];
 
-   for(g=0; g<helix[i].residues_total; g++)
+   for(g=first_atom; g<last_atom; g++)
    {
-      for(h=0; h<helix[j].residues_total; h++)
-      {            
-         strcpy(residue_residue[g][h].atom_name1,temp_atom_name);
-         strcpy(residue_residue[g][h].atom_name2,temp_atom_name);
-         residue_residue[g][h].residue_number1=-1;
-         residue_residue[g][h].residue_number2=-1;
-         residue_residue[g][h].helix_number1=-1;
-         residue_residue[g][h].helix_number2=-1;
-      }   
-   }
+      a=atoms->helix_start[i]+g;
 
-   if(i!=j)
-   {
-      for(g=0; g<helix[i].residues_total; g++)
+      near_total=near_atoms(grid, scratch, a, j);
+      near_total=distance_kernel(atoms->x[a], atoms->y[a], atoms->z[a], atoms->x+first, atoms->y+first, atoms->z+first, scratch->candidates, near_total, cutoffs.reach, scratch->near, scratch->near_d2);
+
+      e1=atoms->element[a];
+      key1=3*atoms->atom_class[a]+((atoms->hdonor[a]==0) ? 0 : ((atoms->hdonor[a]==1) ? 1 : 2));
+
+      for(l=0; l<near_total; l++)
       {
-         for(h=0; h<helix[j].residues_total; h++)
+         h=scratch->near[l];
+         d2=scratch->near_d2[l];
+
+         b=first+h;
+
+         e2=atoms->element[b];
+         key2=3*atoms->atom_class[b]+((atoms->hdonor[b]==0) ? 0 : ((atoms->hdonor[b]==1) ? 1 : 2));
+
+         type='-';
+
+         if(d2 <= cutoffs.covalent[e1][e2])
          {
-            residue_residue[g][h].distance=sqrt(pow(helix[i].ca_coord[g][0]-helix[j].ca_coord[h][0],2.0)+pow(helix[i].ca_coord[g][1]-helix[j].ca_coord[h][1],2.0)+pow(helix[i].ca_coord[g][2]-helix[j].ca_coord[h][2],2.0));
-            strcpy(residue_residue[g][h].atom_name1,atom_name);
-            strcpy(residue_residue[g][h].atom_name2,atom_name);
-            residue_residue[g][h].residue_number1=helix[i].residue_numbers[g];
-            residue_residue[g][h].residue_number2=helix[j].residue_numbers[h];
-            residue_residue[g][h].helix_number1=i;
-            residue_residue[g][h].helix_number2=j;
+            helix_pair->covalent++;
+            type='C';
          }
-      }
 
-      /* different helices are neighbours if they have C-alpha atoms within 10 Angstroms of each other */
-      /* and the distance between their midpoint C-alphas is less than 25 Angstroms */
+         else if((d2 <= cutoffs.electrostatic) && (atoms->charge[a]+atoms->charge[b]==3))
+         {
+            helix_pair->electrostatic++;
+            type='E';
+         }
 
-      m=helix[i].residues_total/2;    /* middle C-alpha of helix 1 */
-      n=helix[j].residues_total/2;    /* middle C-alpha of helix 2 */
+         /* Deemed to be H-bonded if within 106% of the appropriate H-bond distance */
 
-      if(residue_residue[m][n].distance<=25.0) 
-      {
-         for(g=0; g<helix[i].residues_total; g++)
+         else if(d2 <= cutoffs.hbond[key1][key2])
          {
-            for(h=0; h<helix[j].residues_total; h++)
-            {
-               if(residue_residue[g][h].distance<=10.0) 
-               {
-                  helix_pair[i][j].neighbours=1;     
-               }
-            }
+            helix_pair->hbond++;
+            type='H';
+         }
+
+         else if(d2 <= cutoffs.vdw[e1][e2])
+         {
+            helix_pair->vdw++;
+            type='V';
+         }
+
+         /* residues in contact if atoms are within 0.6 A of the sum of their van der Waals' radii */
+
+         if((d2 <= cutoffs.packing[e1][e2]) && (contacts!=NULL))
+         {
+            add_contact(contacts, g, h, (float)sqrt(d2), type);
          }
       }
-//    printf("\n\nH%d,H%d,midpoint distance=%f Ang\n",i,j,residue_residue[m][n].distance);
    }
-
-   return residue_residue;
 }
 
 /* ------------------------------------------------------------------------- */
 
-/* Function that determines if neighbouring helices are packed and the nature of the interhelical contacts */
-struct DISTANCE** atom_distance(int helix1, int helix2, struct HELIX *helix, struct ATOM **helix_atom, struct HELIXPAIR **helix_pair)
+/* Function that determines if neighbouring helices are packed and the nature of the interhelical contacts, */
+/* from the bond counts and the contact list merged from the tiles of the pair */
+int atom_distance(int helix1, int helix2, struct HELIX *helix, struct ATOMSTORE *atoms, struct CONTACTLIST *contacts, struct HELIXPAIR *helix_pair, struct ENTRYSTATE *entry)
 {
    /* Variables */
 
-   int g,h,i,j,k,m=0,n=0,p=0,q=0,e=0,f=0;
-   struct DISTANCE **atom_atom;
+   int c,g,h,i,j,k,m=0,n=0;
    float current_residue1=-1.5;
    float current_residue2=-1.5;
    float last_residue1=-1.5;
@@ -2052,410 +8331,314 @@ struct DISTANCE** atom_distance(int helix1, int helix2, struct HELIX *helix, str
    float previous_residue[5];
    float first_residue1=-1.5;
    float first_residue2=-1.5;
-   float atom1_vdw_rad;
-   float atom1_cov_rad;
-   float atom2_vdw_rad;
-   float atom2_cov_rad;
-   float vdw_rad_sum;
-   float vdw_rad_sum2;
-   float cov_rad_sum;
-   float hbond_distance;
    int switch_end;
    FILE *fpo_contact;
    
    i=helix1;        
    j=helix2;
 
-// dmf 6.27.17 
-// ah! a bug - this is tested by helix number, but if helix '0' 
-// comes through later in the cycle, it opens to write (see if(i==0), below) 
-// rather than append. will be easy to fix if use a flag, instead.
- 
-// if(i==0)
-// dmf 6.27.17 use a global flag
-   if (new_open) 
-   {
-// dmf 7.25.17 - want to modify output_contact to include identifying string. 
-      if((fpo_contact=fopen(output_contact, "w"))==NULL)
-      {
-         printf("\n\n** Error writing to file '%s'!",output_contact);
-         exit(1);
-      }
-      new_open = 0; 
-   }
-   else   
-   {
-// dmf 7.25.17 - want to modify output_contact to include identifying string. 
-      if((fpo_contact=fopen(output_contact, "a+"))==NULL)
-      {
-         printf("\n\n** Error appending to file '%s'!",output_contact);
-         exit(1);
-      }
-   }
-
-   /* Allocate the memory for the 2d array of DISTANCE dynamically
-    *
-    * ---- atoms for helix 2 ---->
-    *        |
-    *        
-    *   atoms for helix 1 
-    *        \/
-    */
-
-   atom_atom = (struct DISTANCE **) calloc(helix[i].atoms_total,sizeof(struct DISTANCE*));
-   
-   for(k=0; k<helix[i].atoms_total; k++)
-   {
-      atom_atom[k] = (struct DISTANCE *) calloc(helix[j].atoms_total,sizeof(struct DISTANCE));
-   }
-
-   /* fill all atom names and residue/helix numbers with junk */
-
-   for(g=0; g<helix[i].atoms_total; g++)
-   {
-      for(h=0; h<helix[j].atoms_total; h++)
-      {            
-         strcpy(atom_atom[g][h].atom_name1,"XXXX");
-         strcpy(atom_atom[g][h].atom_name2,"XXXX");
-         atom_atom[g][h].residue_number1=-1;
-         atom_atom[g][h].residue_number2=-1;
-         atom_atom[g][h].helix_number1=-1;
-         atom_atom[g][h].helix_number2=-1;
-      }   
-   }
+   fpo_contact=entry->fpo_contact;
 
    for(g=0; g<5; g++)
    {
       previous_residue[g]=-1.5;
    }
 
-   fprintf(fpo_contact,"Interhelical Contact Residues\n\n");
+   write_output(fpo_contact,"Interhelical Contact Residues\n\n");
 
-   for(g=0; g<helix[i].atoms_total; g++)
-   {
-      for(h=0; h<helix[j].atoms_total; h++)
-      {
-         atom_atom[g][h].distance=sqrt(pow(helix_atom[i][g].atom_coord[0]-helix_atom[j][h].atom_coord[0],2.0)+pow(helix_atom[i][g].atom_coord[1]-helix_atom[j][h].atom_coord[1],2.0)+pow(helix_atom[i][g].atom_coord[2]-helix_atom[j][h].atom_coord[2],2.0));
+   /* walk through the contacting atom pairs in atom order to find the contacting residues */
 
-         strcpy(atom_atom[g][h].atom_name1,helix_atom[i][g].atom_name);
+   for(c=0; c<contacts->contacts_total; c++)
+   {
+      g=contacts->contact[c].atom1;
+      h=contacts->contact[c].atom2;
 
-         strcpy(atom_atom[g][h].atom_name2,helix_atom[j][h].atom_name);
+      current_residue1=atoms->residue_number[atoms->helix_start[i]+g];
+      current_residue2=atoms->residue_number[atoms->helix_start[j]+h];
 
-         /* set covalent and vdW radii */
+      if(current_residue1!=last_residue1)
+      {
+         m++;        /* m is no. of residues of helix 1 involved in contact area */
 
-         atom1_vdw_rad=0.0;
-         atom1_cov_rad=0.0;
-         atom2_vdw_rad=0.0;
-         atom2_cov_rad=0.0;
+         if(last_residue1==-1.5) first_residue1=current_residue1;   /* sequence number of first residue of helix 1 in contact area */
 
-         if(atom_atom[g][h].atom_name1[1]=='C')
-         {
-            atom1_vdw_rad=1.70;
-            atom1_cov_rad=0.77;
-         }
-         if((atom_atom[g][h].atom_name1[1]=='O') || (atom_atom[g][h].atom_name1[0]=='O'))
-         {
-            atom1_vdw_rad=1.52;
-            atom1_cov_rad=0.73;
-         }
-         if((atom_atom[g][h].atom_name1[1]=='N') || (atom_atom[g][h].atom_name1[0]=='N'))
-         {
-            atom1_vdw_rad=1.55;
-            atom1_cov_rad=0.75;
-         }
-         if(atom_atom[g][h].atom_name1[1]=='S')
-         {
-            atom1_vdw_rad=1.80;
-            atom1_cov_rad=1.02;
-         }
-         if(atom_atom[g][h].atom_name2[1]=='C')
-         {
-            atom2_vdw_rad=1.70;
-            atom2_cov_rad=0.77;
-         }
-         if((atom_atom[g][h].atom_name2[1]=='O') || (atom_atom[g][h].atom_name2[0]=='O'))
-         {
-            atom2_vdw_rad=1.52;
-            atom2_cov_rad=0.73;
-         }
-         if((atom_atom[g][h].atom_name2[1]=='N') || (atom_atom[g][h].atom_name2[0]=='N'))
-         {
-            atom2_vdw_rad=1.55;
-            atom2_cov_rad=0.75;
-         }
-         if(atom_atom[g][h].atom_name2[1]=='S')
-         {
-            atom2_vdw_rad=1.80;
-            atom2_cov_rad=1.02;
-         }
+         last_residue1=current_residue1;                          /* sequence number of last residue of helix 1 in contact area */
 
-         /* set hbond distances */
+#ifdef DEBUG
+  	write_output(fpo_contact,"\t\tTesting g %d and h %d\n", g, h);
+#endif
 
-         hbond_distance=0.0;
+         write_output(fpo_contact,"Helix %d residue: %.2f\n",i,last_residue1);
+      }
 
-         if((atom_atom[g][h].atom_name1[1]=='O' || atom_atom[g][h].atom_name1[0]=='O') && (atom_atom[g][h].atom_name2[1]=='O' || atom_atom[g][h].atom_name2[0]=='O'))
-         {
-            if((helix_atom[i][g].hdonor==1) || (helix_atom[j][h].hdonor==1))
-            {
-               hbond_distance=2.70;
-            }
-            else hbond_distance=0.0;
-         }
+      if((current_residue2!=previous_residue[0]) && (current_residue2!=previous_residue[1]) && (current_residue2!=previous_residue[2]) && (current_residue2!=previous_residue[3]) && (current_residue2!=previous_residue[4]))
+      {
+         n++;        /* n is no. of residues of helix 2 involved in contact area */
 
-         if((atom_atom[g][h].atom_name1[1]=='O' || atom_atom[g][h].atom_name1[0]=='O') && (atom_atom[g][h].atom_name2[1]=='N' || atom_atom[g][h].atom_name2[0]=='N'))
+         if(previous_residue[0]==-1.5)           /* happens on first occasion only */
          {
-            if(helix_atom[j][h].hdonor) hbond_distance=3.04; /* N is donor */
+            first_residue2=current_residue2;   /* sequence number of first residue of helix 2 in contact area */
 
-            else if((helix_atom[i][g].hdonor==1) && (helix_atom[j][h].hdonor==0)) /* O is donor and N is not */ 
-            {
-               hbond_distance=2.88;
-            }
-            else hbond_distance=0.0;
+            last_residue2=current_residue2;    /* sequence number of last residue of helix 2 in contact area */
          }
 
-         if((atom_atom[g][h].atom_name1[1]=='N' || atom_atom[g][h].atom_name1[0]=='N') && (atom_atom[g][h].atom_name2[1]=='O' || atom_atom[g][h].atom_name2[0]=='O'))
-         {
-            if(helix_atom[i][g].hdonor) hbond_distance=3.04; /* N is donor */
+         if(current_residue2<first_residue2) first_residue2=current_residue2;  /* make first_residue2 the lowest residue number */
 
-            else if((helix_atom[i][g].hdonor==0) && (helix_atom[j][h].hdonor==1)) /* O is donor and N is not */ 
-            {
-               hbond_distance=2.88;
-            }
-            else hbond_distance=0.0;
-         }
+         if(current_residue2>last_residue2) last_residue2=current_residue2;    /* make last_residue2 the highest residue number */
 
-         if((atom_atom[g][h].atom_name1[1]=='N' || atom_atom[g][h].atom_name1[0]=='N') && (atom_atom[g][h].atom_name2[1]=='N' || atom_atom[g][h].atom_name2[0]=='N'))
+         for(k=4; k>0; k--)         /* update backcatalogue of past 5 residues of helix 2 to prevent recording same residue twice */
          {
-            if((helix_atom[i][g].hdonor==1) || (helix_atom[j][h].hdonor==1))
-            {
-               hbond_distance=3.10;
-            }
-            else hbond_distance=0.0;
+            previous_residue[k]=previous_residue[k-1];
          }
 
-         /* vdw_rad_sum used to determine residue-residue packing as according to Chothia */
-
-         vdw_rad_sum = (atom1_vdw_rad + atom2_vdw_rad) + TOLERANCE;
+         previous_residue[0]=current_residue2;
 
-         /* vdw_rad_sum2 used to detect van der Waal bonds between atoms i.e. they are within 106% of the sum of their vdW radii */
+#ifdef DEBUG
+  	write_output(fpo_contact,"\t\tTesting g %d and h %d\n", g, h);
+#endif
          
-         vdw_rad_sum2 = (atom1_vdw_rad + atom2_vdw_rad) * TOLERANCE2;
+         write_output(fpo_contact,"Helix %d residue: %.2f\n",j,previous_residue[0]);
+      }
+   }
 
-         /* cov_rad_sum used to detect covalently bonded atoms i.e. they are within 106% of the sum of their covalent radii */
+   /* two helices are packed if each has at least three residues forming contacts to the other */
 
-         cov_rad_sum = (atom1_cov_rad + atom2_cov_rad) * TOLERANCE2;
+   if((m>=MIN_CONTACT_RESIDUES) && (n>=MIN_CONTACT_RESIDUES)) 
+   {
+      helix_pair->packed=1;
+   }
 
-         atom_atom[g][h].residue_number1=helix_atom[i][g].residue_number;
-         atom_atom[g][h].residue_number2=helix_atom[j][h].residue_number;
+   write_output(fpo_contact,"Helix %d first residue: %.2f\t",i,first_residue1);
+   write_output(fpo_contact,"Helix %d last residue: %.2f\n",i,last_residue1);
+   write_output(fpo_contact,"Helix %d first residue: %.2f\t",j,first_residue2);
+   write_output(fpo_contact,"Helix %d last residue: %.2f\n\n",j,last_residue2);
 
-         atom_atom[g][h].helix_number1=i;
-         atom_atom[g][h].helix_number2=j;
+   /* record the number of contacting residues that are involved in the packed pair */
 
-         current_residue1=atom_atom[g][h].residue_number1;
-         current_residue2=atom_atom[g][h].residue_number2;
+   helix_pair->h1_residues=m;
+   helix_pair->h2_residues=n;
 
-         /* residues in contact if atoms are within 0.6 A of the sum of their van der Waals' radii */
+   /* find the start and end points of the contact zone for each helix */
 
-         if((atom_atom[g][h].distance <= vdw_rad_sum) && (current_residue1!=last_residue1) && (i!=j))
-         {
-            m++;        /* m is no. of residues of helix 1 involved in contact area */
+   for(g=0; g<helix[i].residues_total; g++)
+   {
+      if(helix[i].residue_numbers[g]==first_residue1) helix_pair->h1_start=g;      
+      if(helix[i].residue_numbers[g]==last_residue1) helix_pair->h1_end=g;      
+   }
 
-            if(last_residue1==-1.5) first_residue1=current_residue1;   /* sequence number of first residue of helix 1 in contact area */
+   for(g=0; g<helix[j].residues_total; g++)
+   {
+      if(helix[j].residue_numbers[g]==first_residue2) helix_pair->h2_start=g;      
+      if(helix[j].residue_numbers[g]==last_residue2) helix_pair->h2_end=g;      
+   }
 
-            last_residue1=current_residue1;                          /* sequence number of last residue of helix 1 in contact area */
+   /* if the end of the contact zone is before the start (which should never happen) */
+   /* but does if the helix is numbered from high to low (i.e. the wrong way round)  */
+   /* then switch the end point number with the start point number and vice versa    */
 
-#ifdef DEBUG
-  	fprintf(fpo_contact,"\t\tTesting g %d and h %d\n", g, h);
-#endif
+   if(helix_pair->h1_end<helix_pair->h1_start)
+   {
+      switch_end=helix_pair->h1_end;
 
-            fprintf(fpo_contact,"Helix %d residue: %.2f\n",i,last_residue1);
-         }
+      helix_pair->h1_end=helix_pair->h1_start;
 
-         if((atom_atom[g][h].distance <= vdw_rad_sum) && (current_residue2!=previous_residue[0]) && (current_residue2!=previous_residue[1]) && (current_residue2!=previous_residue[2]) && (current_residue2!=previous_residue[3]) && (current_residue2!=previous_residue[4]) && (i!=j))
-         {
-            n++;        /* n is no. of residues of helix 2 involved in contact area */
+      helix_pair->h1_start=switch_end;
+   }
 
-            if(previous_residue[0]==-1.5)           /* happens on first occasion only */
-            {
-               first_residue2=current_residue2;   /* sequence number of first residue of helix 2 in contact area */
+   if(helix_pair->h2_end<helix_pair->h2_start)
+   {
+      switch_end=helix_pair->h2_end;
 
-               last_residue2=current_residue2;    /* sequence number of last residue of helix 2 in contact area */
-            }
+      helix_pair->h2_end=helix_pair->h2_start;
 
-            if(current_residue2<first_residue2) first_residue2=current_residue2;  /* make first_residue2 the lowest residue number */
+      helix_pair->h2_start=switch_end;
+   }
 
-            if(current_residue2>last_residue2) last_residue2=current_residue2;    /* make last_residue2 the highest residue number */
+   return XHELIX_OK;
+}
 
-            for(k=4; k>0; k--)         /* update backcatalogue of past 5 residues of helix 2 to prevent recording same residue twice */
-            {
-               previous_residue[k]=previous_residue[k-1];
-            }
+/* ------------------------------------------------------------------------- */
 
-            previous_residue[0]=current_residue2;
+/* Function to set up the parallel neighbour tests and contact scans of the helix pairs of a protein, */
+/* with an arena per thread for its contact lists, the first being the arena of the protein; NULL if */
+/* there is no memory for them */
+struct PAIRSCAN* make_pair_scan(struct HELIX *helix, struct ATOMSTORE *atoms, struct CELLGRID *grid, struct PAIRSTORE *pair_store, int *candidate, int candidates_total, int threads_total, struct ARENA **arena)
+{
+   /* Variables */
 
-#ifdef DEBUG
-  	fprintf(fpo_contact,"\t\tTesting g %d and h %d\n", g, h);
-#endif
-            
-            fprintf(fpo_contact,"Helix %d residue: %.2f\n",j,previous_residue[0]);
-         }
+   struct PAIRSCAN *scan;
+   int t;
 
-         if((atom_atom[g][h].distance <= cov_rad_sum) && (i!=j))
-         {
-            q++;        /* q is no. of covalent contacts between two helices */ 
-         }
 
-         else if((atom_atom[g][h].distance <= 5.0) && (helix_atom[i][g].charge+helix_atom[j][h].charge==3) && (i!=j))
-         {
-            e++;        /* e is no. of electrostatic interhelical contacts */
-         }
+   if((scan=(struct PAIRSCAN *) arena_alloc(arena[0],sizeof(struct PAIRSCAN)))==NULL) return NULL;
 
-         /* Deemed to be H-bonded if within 106% of the appropriate H-bond distance */
+   scan->helix=helix;
+   scan->atoms=atoms;
+   scan->grid=grid;
+   scan->pair_store=pair_store;
+   scan->candidate=candidate;
+   scan->threads_total=threads_total;
 
-         else if((atom_atom[g][h].distance <= hbond_distance * TOLERANCE2) && (i!=j))
-         {
-            f++;        /* f is no. of H-bonds between the two helices */
-         }
+   scan->neighbour=(char *) arena_alloc(arena[0],(candidates_total+1)*sizeof(char));
 
-         else if((atom_atom[g][h].distance <= vdw_rad_sum2) && (i!=j))
-         {
-            p++;        /* p is no. of vdW contacts between two helices */
-         }
-      }
-   }
+   scan->arena=arena;
+   scan->scratch=(struct SCANSCRATCH **) arena_alloc(arena[0],threads_total*sizeof(struct SCANSCRATCH *));
 
-   /* two helices are packed if each has at least three residues forming contacts to the other */
+   if((scan->neighbour==NULL) || (scan->scratch==NULL)) return NULL;
 
-   if((m>=MIN_CONTACT_RESIDUES) && (n>=MIN_CONTACT_RESIDUES)) 
+   /* with no atoms (the C-alpha mode) there is no grid, and only the neighbour tests are run */
+
+   for(t=0;(grid!=NULL) && (t<threads_total);t++)
    {
-      helix_pair[i][j].packed=1;
+      if((scan->scratch[t]=make_scan_scratch(grid, scan->arena[t]))==NULL) return NULL;
    }
 
-   fprintf(fpo_contact,"Helix %d first residue: %.2f\t",i,first_residue1);
-   fprintf(fpo_contact,"Helix %d last residue: %.2f\n",i,last_residue1);
-   fprintf(fpo_contact,"Helix %d first residue: %.2f\t",j,first_residue2);
-   fprintf(fpo_contact,"Helix %d last residue: %.2f\n\n",j,last_residue2);
+   return scan;
+}
 
-   /* record the number of contacting residues that are involved in the packed pair */
 
-   helix_pair[i][j].h1_residues=m;
-   helix_pair[i][j].h2_residues=n;
+/* ------------------------------------------------------------------------- */
 
-   /* find the start and end points of the contact zone for each helix */
+/* Function run as one task of a pool: the neighbour test of one candidate helix pair */
+void neighbour_task(void *context, int task, int thread)
+{
+   /* Variables */
 
-   for(g=0; g<helix[i].residues_total; g++)
-   {
-      if(helix[i].residue_numbers[g]==first_residue1) helix_pair[i][j].h1_start=g;      
-      if(helix[i].residue_numbers[g]==last_residue1) helix_pair[i][j].h1_end=g;      
-   }
+   struct PAIRSCAN *scan;
 
-   for(g=0; g<helix[j].residues_total; g++)
-   {
-      if(helix[j].residue_numbers[g]==first_residue2) helix_pair[i][j].h2_start=g;      
-      if(helix[j].residue_numbers[g]==last_residue2) helix_pair[i][j].h2_end=g;      
-   }
 
-   /* if the end of the contact zone is before the start (which should never happen) */
-   /* but does if the helix is numbered from high to low (i.e. the wrong way round)  */
-   /* then switch the end point number with the start point number and vice versa    */
+   /* the test needs no scratch of its own, so the thread does not matter */
 
-   if(helix_pair[i][j].h1_end<helix_pair[i][j].h1_start)
-   {
-      switch_end=helix_pair[i][j].h1_end;
+   (void) thread;
 
-      helix_pair[i][j].h1_end=helix_pair[i][j].h1_start;
+   scan=(struct PAIRSCAN *) context;
 
-      helix_pair[i][j].h1_start=switch_end;
-   }
+   scan->neighbour[task]=residue_distance(scan->candidate[2*task], scan->candidate[2*task+1], scan->helix);
+}
 
-   if(helix_pair[i][j].h2_end<helix_pair[i][j].h2_start)
-   {
-      switch_end=helix_pair[i][j].h2_end;
+/* ------------------------------------------------------------------------- */
 
-      helix_pair[i][j].h2_end=helix_pair[i][j].h2_start;
+/* Function to cut the helix one atoms of each neighbouring pair into tiles of TILE_ATOMS, in pair order; */
+/* there are no tiles if there is no memory for them */
+void make_tiles(struct PAIRSCAN *scan)
+{
+   /* Variables */
+
+   struct HELIXPAIR *helix_pair;
+   struct TILE *tile;
+   int g,k,n=0;
+   int atoms_total;
 
-      helix_pair[i][j].h2_start=switch_end;
+
+   for(k=0;k<scan->pair_store->pairs_total;k++)
+   {
+      atoms_total=scan->helix[scan->pair_store->pair[k].helix_one].atoms_total;
+
+      n+=(atoms_total+TILE_ATOMS-1)/TILE_ATOMS;
    }
 
-   /* record interhelical bond types for that pair */
+   if((scan->tile=(struct TILE *) arena_alloc(scan->arena[0],(n+1)*sizeof(struct TILE)))==NULL) return;
+   scan->tiles_total=n;
+
+   n=0;
 
-   helix_pair[i][j].vdw=p;
-   helix_pair[i][j].covalent=q;
-   helix_pair[i][j].electrostatic=e;
-   helix_pair[i][j].hbond=f;
+   for(k=0;k<scan->pair_store->pairs_total;k++)
+   {
+      helix_pair=&scan->pair_store->pair[k];
+
+      atoms_total=scan->helix[helix_pair->helix_one].atoms_total;
 
-   fclose(fpo_contact);
+      for(g=0;g<atoms_total;g+=TILE_ATOMS)
+      {
+         tile=&scan->tile[n++];
 
-   return atom_atom;
+         tile->pair=k;
+         tile->first_atom=g;
+         tile->last_atom=(g+TILE_ATOMS<atoms_total) ? g+TILE_ATOMS : atoms_total;
+      }
+   }
 }
 
 /* ------------------------------------------------------------------------- */
 
-/* Free up the memory taken by residue_residue structure */
-void destroy_residue_residue(struct DISTANCE **residue_residue, struct HELIX *helix, int helix_number)
+/* Function run as one task of a pool: the contact scan of one tile, into a contact list of the thread's arena */
+void tile_task(void *context, int task, int thread)
 {
-   /* Deallocate the memory for the 2d array dynamically
-    *
-    * ----residues for helix 2--->
-    *        |
-    *  residues for helix 1
-    *        \/
-    */
+   /* Variables */
 
-   int i;
-   int j;
+   struct PAIRSCAN *scan;
+   struct TILE *tile;
+   struct HELIXPAIR *helix_pair;
 
 
-   j=helix_number;
+   scan=(struct PAIRSCAN *) context;
 
-   for (i=0; i<helix[j].residues_total; i++)
-   {
-      free(residue_residue[i]);
-   }
-   free(residue_residue);
+   tile=&scan->tile[task];
+   helix_pair=&scan->pair_store->pair[tile->pair];
+
+   tile->contacts=make_contact_list(scan->arena[thread]);
+
+   contact_scan(helix_pair->helix_one, helix_pair->helix_two, tile->first_atom, tile->last_atom, scan->atoms, scan->grid, scan->scratch[thread], &tile->counts, tile->contacts);
 }
 
 /* ------------------------------------------------------------------------- */
 
-/* Free up the memory taken by atom_atom structure */
-void destroy_atom_atom(struct DISTANCE **atom_atom, struct HELIX *helix, int helix_number)
+/* Function to add up the bond counts of the tiles of a helix pair, starting from tile, and join their */
+/* contact lists in order into contacts; returns the first tile of the next pair */
+int merge_tiles(struct PAIRSCAN *scan, int tile, struct HELIXPAIR *helix_pair, struct CONTACTLIST *contacts)
 {
-   /* Deallocate the memory for the 2d array dynamically
-    *
-    * ---atoms for helix 2 --->
-    *        |
-    *  atoms for helix 1
-    *        \/
-    */
+   /* Variables */
+
+   struct TILE *t;
+   struct CONTACT *contact;
+   int c,k;
 
-   int i;
-   int j;
 
+   k=helix_pair-scan->pair_store->pair;
 
-   j=helix_number;
+   helix_pair->vdw=0;
+   helix_pair->covalent=0;
+   helix_pair->electrostatic=0;
+   helix_pair->hbond=0;
 
-   for (i=0; i<helix[j].atoms_total; i++)
+   contacts->contacts_total=0;
+
+   for(;(tile<scan->tiles_total) && (scan->tile[tile].pair==k);tile++)
    {
-      free(atom_atom[i]);
+      t=&scan->tile[tile];
+
+      helix_pair->vdw+=t->counts.vdw;
+      helix_pair->covalent+=t->counts.covalent;
+      helix_pair->electrostatic+=t->counts.electrostatic;
+      helix_pair->hbond+=t->counts.hbond;
+
+      for(c=0;c<t->contacts->contacts_total;c++)
+      {
+         contact=&t->contacts->contact[c];
+
+         add_contact(contacts, contact->atom1, contact->atom2, contact->distance, contact->type);
+      }
    }
-   free(atom_atom);
+
+   return tile;
 }
 
 /* ------------------------------------------------------------------------- */
 
 /* Function to fill up two point structures and two vector structures with information from two packed helices */
-void two_helix_all_vectors(int helix_A, int helix_B, struct HELIX *helix, struct HELIXPAIR **helix_pair)
+int two_helix_all_vectors(int helix_A, int helix_B, struct HELIX *helix, struct HELIXPAIR *helix_pair, struct ENTRYSTATE *entry)
 {
    /* Variables */
 
-   int g,h,i,j;
-   static POINT A;     /* start point of helix A vector                */
-   static POINT B;     /* start point of helix B vector                */
-   static VECTOR dA;   /* vector of helix A                            */
-   static VECTOR dB;   /* vector of helix B                            */
-   static POINT pA;    /* point of closest approach on line of helix A */
-   static POINT pB;    /* point of closest approach on line of helix B */
+   int h,i,j;
+   POINT A;            /* start point of helix A vector                */
+   POINT B;            /* start point of helix B vector                */
+   VECTOR dA;          /* vector of helix A                            */
+   VECTOR dB;          /* vector of helix B                            */
+   POINT pA;           /* point of closest approach on line of helix A */
+   POINT pB;           /* point of closest approach on line of helix B */
    int rval;           /* 0 if parallel; 1 if lines intersect; 2 if lines are skew (as expected) */  
+   double total[3];
    double totalx,totaly,totalz;
    double averagex,averagey,averagez;
    double contact_vector[3];          /* vector of the closest approach from Helix B to Helix A */
@@ -2478,8 +8661,7 @@ void two_helix_all_vectors(int helix_A, int helix_B, struct HELIX *helix, struct
 
    if((helix[i].residues_total<4) || (helix[j].residues_total<4))
    {
-      printf("\n\n** Error ** Packed helix is less than 4 residues!\n\n");
-      exit(1);
+      return entry_error(entry, XHELIX_ERROR_STRUCTURE, "** Error ** Packed helix is less than 4 residues!");
    }
    else
    {
@@ -2499,16 +8681,11 @@ void two_helix_all_vectors(int helix_A, int helix_B, struct HELIX *helix, struct
 
       /* average all the helix A axis vectors */
 
-      totalx=0.0;
-      totaly=0.0;
-      totalz=0.0;
+      axis_run(&helix[i], 0, helix[i].residues_total-4, total);
 
-      for(g=0;g<helix[i].residues_total-3; g++)
-      {
-         totalx=helix[i].unit_local_axis[g][0]+totalx;
-         totaly=helix[i].unit_local_axis[g][1]+totaly;
-         totalz=helix[i].unit_local_axis[g][2]+totalz;
-      }
+      totalx=total[0];
+      totaly=total[1];
+      totalz=total[2];
 
       averagex=totalx/(helix[i].residues_total-3);
       averagey=totaly/(helix[i].residues_total-3);
@@ -2522,16 +8699,11 @@ void two_helix_all_vectors(int helix_A, int helix_B, struct HELIX *helix, struct
 
       /* average all the helix B axis vectors */
 
-      totalx=0.0;
-      totaly=0.0;
-      totalz=0.0;
+      axis_run(&helix[j], 0, helix[j].residues_total-4, total);
 
-      for(g=0;g<helix[j].residues_total-3; g++)
-      {
-         totalx=helix[j].unit_local_axis[g][0]+totalx;
-         totaly=helix[j].unit_local_axis[g][1]+totaly;
-         totalz=helix[j].unit_local_axis[g][2]+totalz;
-      }
+      totalx=total[0];
+      totaly=total[1];
+      totalz=total[2];
 
       averagex=totalx/(helix[j].residues_total-3);
       averagey=totaly/(helix[j].residues_total-3);
@@ -2549,7 +8721,7 @@ void two_helix_all_vectors(int helix_A, int helix_B, struct HELIX *helix, struct
 
       /* smallest distance between the two helix axes i.e. length of line of closest approach */
       // dmf 6.28.17 Determine this in the 'contact region' routine, below.
-      // helix_pair[i][j].distance=sqrt(pow(pB.px-pA.px,2.0)+pow(pB.py-pA.py,2.0)+pow(pB.pz-pA.pz,2.0));
+      // helix_pair->distance=sqrt(pow(pB.px-pA.px,2.0)+pow(pB.py-pA.py,2.0)+pow(pB.pz-pA.pz,2.0));
        
       /* the vector of the closest approach from helix axis B to helix axis A */
 
@@ -2589,29 +8761,32 @@ void two_helix_all_vectors(int helix_A, int helix_B, struct HELIX *helix, struct
       if(volume<0) angle=-angle;
        
       // dmf 6.29.17 This is really all that this routine is trying to determine:
-      helix_pair[i][j].angle1=angle;
+      helix_pair->angle1=angle;
    }
+
+   return XHELIX_OK;
 }
 
 /* ------------------------------------------------------------------------- */
 
 /* Function to fill up two point structures and two vector structures with information from two packed helices */
-void two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX *helix, struct HELIXPAIR **helix_pair)
+int two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX *helix, struct HELIXPAIR *helix_pair, struct ENTRYSTATE *entry)
 {
    /* Variables */
 
-   int g,h,i,j,k,m,n;
-   static POINT A;     /* start point of helix A vector                */
-   static POINT B;     /* start point of helix B vector                */
-   static VECTOR dA;   /* vector of helix A                            */
-   static VECTOR dB;   /* vector of helix B                            */
-   static POINT pA;    /* point of closest approach on line of helix A */
-   static POINT pB;    /* point of closest approach on line of helix B */
+   int h,i,j,k;
+   POINT A;            /* start point of helix A vector                */
+   POINT B;            /* start point of helix B vector                */
+   VECTOR dA;          /* vector of helix A                            */
+   VECTOR dB;          /* vector of helix B                            */
+   POINT pA;           /* point of closest approach on line of helix A */
+   POINT pB;           /* point of closest approach on line of helix B */
    int rval;           /* 0 if parallel; 1 if lines intersect; 2 if lines are skew (as expected) */  
    int hA_start;       /* first axis in contact area of helix A        */
    int hA_end;         /* last axis in contact area of helix A         */
    int hB_start;       /* first axis in contact area of helix B        */
    int hB_end;         /* last axis in contact area of helix B         */
+   double total[3];
    double totalx,totaly,totalz;
    double averagex,averagey,averagez;
    double contact_vector[3];          /* vector of the closest approach from Helix B to Helix A */
@@ -2629,16 +8804,14 @@ void two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX *helix, st
    // dmf 6.28.17
     char cA_label[20], cB_label[20], cD_label[20]; 
     FILE *fpo_pyaxis;
-    static LINESEGMENT Alimits;    // helix A axial start and end points
-    static LINESEGMENT Blimits;    // helix B axial start and end points
+    LINESEGMENT *Alimits;          // helix A axial start and end points
+    LINESEGMENT *Blimits;          // helix B axial start and end points
     float rdist;  // return value for linesegment distance routine
 
-// dmf 7.25.17 - want to modify pymol_axis to include identifying string. 
-    if((fpo_pyaxis=fopen(pymol_axis, "a+"))==NULL)
-    {
-        printf("\n\n** Error appending to file '%s'!",pymol_axis);
-        exit(1);
-    }
+    Alimits=&entry->Alimits;
+    Blimits=&entry->Blimits;
+
+    fpo_pyaxis=entry->fpo_pyaxis;
     
    pi=180.0/acos(-1.0);
 
@@ -2647,18 +8820,17 @@ void two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX *helix, st
 
    if((helix[i].residues_total<4) || (helix[j].residues_total<4))
    {
-      printf("\n\n** Error ** Packed helix is less than 4 residues!\n\n");
-      exit(1);
+      return entry_error(entry, XHELIX_ERROR_STRUCTURE, "** Error ** Packed helix is less than 4 residues!");
    }
    else
    {
       // dmf 6.29.17 these are the axis segment identifiers at the start and
       // end of the helix contacts (i.e. they are integers)
-      hA_start=helix_pair[i][j].h1_start;
-      hA_end=helix_pair[i][j].h1_end;
+      hA_start=helix_pair->h1_start;
+      hA_end=helix_pair->h1_end;
 
-      hB_start=helix_pair[i][j].h2_start;
-      hB_end=helix_pair[i][j].h2_end;
+      hB_start=helix_pair->h2_start;
+      hB_end=helix_pair->h2_end;
 
       /* assign the two middle helix origins from the two helices to the two start point structures A and B */
 
@@ -2699,16 +8871,11 @@ void two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX *helix, st
             hA_end=helix[i].residues_total-4;
          }
 
-         totalx=0.0;
-         totaly=0.0;
-         totalz=0.0;
+         axis_run(&helix[i], hA_start, hA_end, total);
 
-         for(g=hA_start;g<=hA_end;g++)
-         { 
-            totalx=helix[i].unit_local_axis[g][0]+totalx;
-            totaly=helix[i].unit_local_axis[g][1]+totaly;
-            totalz=helix[i].unit_local_axis[g][2]+totalz;
-         }
+         totalx=total[0];
+         totaly=total[1];
+         totalz=total[2];
 
          averagex=totalx/(hA_end-hA_start+1);
          averagey=totaly/(hA_end-hA_start+1);
@@ -2725,18 +8892,18 @@ void two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX *helix, st
           // which will yield points on the averaged helix axis vector. This can be used to
           // determine the segment-wise point of close approach (which can be different from the perpendicular)
           // Alternatively, just grab the coordinates at hA_start and hA_end to define a helix vector.
-          Alimits.P0.px=A.px-(totalx/2);
-          Alimits.P0.py=A.py-(totaly/2);
-          Alimits.P0.pz=A.pz-(totalz/2);
-          Alimits.P1.px=A.px+(totalx/2);
-          Alimits.P1.py=A.py+(totaly/2);
-          Alimits.P1.pz=A.pz+(totalz/2);
+          Alimits->P0.px=A.px-(totalx/2);
+          Alimits->P0.py=A.py-(totaly/2);
+          Alimits->P0.pz=A.pz-(totalz/2);
+          Alimits->P1.px=A.px+(totalx/2);
+          Alimits->P1.py=A.py+(totaly/2);
+          Alimits->P1.pz=A.pz+(totalz/2);
 #ifdef DEBUG
           printf("\n testing start and end points helix %d\n",i);
           printf("Center: A %f %f %f\n",A.px, A.py, A.pz);
           printf("Vector: dA %f %f %f\n", dA.dx, dA.dy, dA.dz);
-          printf("Start: Ai %f %f %f\n", Alimits.P0.px, Alimits.P0.py, Alimits.P0.pz);
-          printf("Endpoint: Af %f %f %f\n", Alimits.P1.px, Alimits.P1.py, Alimits.P1.pz);
+          printf("Start: Ai %f %f %f\n", Alimits->P0.px, Alimits->P0.py, Alimits->P0.pz);
+          printf("Endpoint: Af %f %f %f\n", Alimits->P1.px, Alimits->P1.py, Alimits->P1.pz);
 #endif
 
       }
@@ -2744,29 +8911,24 @@ void two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX *helix, st
        // dmf 6.29.17 changed criteria to <> 30 residues
       else if(hA_end-hA_start+1>=33)  /* if the contact zone is bigger than 30 residues... (to be used mainly for coiled coils) */
       {
-         totalx=0.0;
-         totaly=0.0;
-         totalz=0.0;
+         /* get middle 25 axes only, all of which must be set */
 
-         for(m=h-12;m<h+13;m++)   /* get middle 25 axes only */
+         if(h-12<0)
          {
-            if(m<0)
-            {
-               printf("\n\n** Error in contact axes - less than zero - helix %d **\n",i);
-               exit(1);
-            }
-
-            totalx=helix[i].unit_local_axis[m][0]+totalx;
-            totaly=helix[i].unit_local_axis[m][1]+totaly;
-            totalz=helix[i].unit_local_axis[m][2]+totalz;
+            return entry_error(entry, XHELIX_ERROR_STRUCTURE, "** Error in contact axes - less than zero - helix %d **",i);
+         }
 
-            if((helix[i].unit_local_axis[m][0]==-1)||(helix[i].unit_local_axis[m][1]==-1)||(helix[i].unit_local_axis[m][2]==-1))
-            {
-               printf("\n\n** Error in contact axes - over limit - helix %d **\n",i);
-               exit(1);
-            }
+         if((h+12>helix[i].residues_total-4) || (helix[i].unset_axes[h+13]>helix[i].unset_axes[h-12]))
+         {
+            return entry_error(entry, XHELIX_ERROR_STRUCTURE, "** Error in contact axes - over limit - helix %d **",i);
          }
 
+         axis_run(&helix[i], h-12, h+12, total);
+
+         totalx=total[0];
+         totaly=total[1];
+         totalz=total[2];
+
          averagex=totalx/25;
          averagey=totaly/25;
          averagez=totalz/25;
@@ -2793,16 +8955,11 @@ void two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX *helix, st
             hB_end=helix[j].residues_total-4;
          }
 
-         totalx=0.0;
-         totaly=0.0;
-         totalz=0.0;
+         axis_run(&helix[j], hB_start, hB_end, total);
 
-         for(g=hB_start;g<=hB_end;g++)
-         {
-            totalx=helix[j].unit_local_axis[g][0]+totalx;
-            totaly=helix[j].unit_local_axis[g][1]+totaly;
-            totalz=helix[j].unit_local_axis[g][2]+totalz;
-         }
+         totalx=total[0];
+         totaly=total[1];
+         totalz=total[2];
 
          averagex=totalx/(hB_end-hB_start+1);
          averagey=totaly/(hB_end-hB_start+1);
@@ -2819,18 +8976,18 @@ void two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX *helix, st
           // which will yield points on the averaged helix axis vector. This can be used to
           // determine the segment-wise point of close approach (which can be different from the perpendicular)
           // Alternatively, just grab the coordinates at hA_start and hA_end to define a helix vector.
-          Blimits.P0.px=B.px-(totalx/2);
-          Blimits.P0.py=B.py-(totaly/2);
-          Blimits.P0.pz=B.pz-(totalz/2);
-          Blimits.P1.px=B.px+(totalx/2);
-          Blimits.P1.py=B.py+(totaly/2);
-          Blimits.P1.pz=B.pz+(totalz/2);
+          Blimits->P0.px=B.px-(totalx/2);
+          Blimits->P0.py=B.py-(totaly/2);
+          Blimits->P0.pz=B.pz-(totalz/2);
+          Blimits->P1.px=B.px+(totalx/2);
+          Blimits->P1.py=B.py+(totaly/2);
+          Blimits->P1.pz=B.pz+(totalz/2);
 #ifdef DEBUG
           printf("\n testing start and end points helix %d\n",j);
           printf("Center: B %f %f %f\n",B.px, B.py, B.pz);
           printf("Vector: dB %f %f %f\n", dB.dx, dB.dy, dB.dz);
-          printf("Start: Bi %f %f %f\n", Blimits.P0.px, Blimits.P0.py, Blimits.P0.pz);
-          printf("Endpoint: Bf %f %f %f\n", Blimits.P1.px, Blimits.P1.py, Blimits.P1.pz);
+          printf("Start: Bi %f %f %f\n", Blimits->P0.px, Blimits->P0.py, Blimits->P0.pz);
+          printf("Endpoint: Bf %f %f %f\n", Blimits->P1.px, Blimits->P1.py, Blimits->P1.pz);
 #endif
 
       }
@@ -2838,29 +8995,24 @@ void two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX *helix, st
        // dmf 6.29.17 changed criteria to <> 30 residues
       else if(hB_end-hB_start+1>=33)   /* for coiled coils - if contact zone is equal to 30 residues or more */
       {
-         totalx=0.0;
-         totaly=0.0;
-         totalz=0.0;
+         /* get middle 25 axes only, all of which must be set */
 
-         for(n=k-12;n<k+13;n++)   /* get middle 25 axes only */
+         if(k-12<0)
          {
-            if(n<0)
-            {
-               printf("\n\n** Error in contact axes - less than zero - helix %d **\n",j);
-               exit(1);
-            }
-
-            totalx=helix[j].unit_local_axis[n][0]+totalx;
-            totaly=helix[j].unit_local_axis[n][1]+totaly;
-            totalz=helix[j].unit_local_axis[n][2]+totalz;
+            return entry_error(entry, XHELIX_ERROR_STRUCTURE, "** Error in contact axes - less than zero - helix %d **",j);
+         }
 
-            if((helix[j].unit_local_axis[n][0]==-1)||(helix[j].unit_local_axis[n][1]==-1)||(helix[j].unit_local_axis[n][2]==-1))
-            {
-               printf("\n\n** Error in contact axes - over limit - helix %d **\n",j);
-               exit(1);
-            }
+         if((k+12>helix[j].residues_total-4) || (helix[j].unset_axes[k+13]>helix[j].unset_axes[k-12]))
+         {
+            return entry_error(entry, XHELIX_ERROR_STRUCTURE, "** Error in contact axes - over limit - helix %d **",j);
          }
 
+         axis_run(&helix[j], k-12, k+12, total);
+
+         totalx=total[0];
+         totaly=total[1];
+         totalz=total[2];
+
          averagex=totalx/25;
          averagey=totaly/25;
          averagez=totalz/25;
@@ -2916,7 +9068,7 @@ void two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX *helix, st
        if(volume<0) angle=-angle;
        
        // dmf 6.29.17 This is really all this routine is trying to determine:
-       helix_pair[i][j].angle2=angle;
+       helix_pair->angle2=angle;
 
        // now deal with the distance...
        
@@ -2927,7 +9079,7 @@ void two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX *helix, st
        
        /* smallest distance between the two helix axes i.e. length of line of closest approach */
        // dmf 7.12.17 recalcualate this below (keep here for debug comparison below, als)
-       helix_pair[i][j].distance=sqrt(pow(pB.px-pA.px,2.0)+pow(pB.py-pA.py,2.0)+pow(pB.pz-pA.pz,2.0));
+       helix_pair->distance=sqrt(pow(pB.px-pA.px,2.0)+pow(pB.py-pA.py,2.0)+pow(pB.pz-pA.pz,2.0));
        
        // BUG2 - GETTING contact vectors well displaced from position of helices... 
        // dmf 6.28.17 also, should output the points pA and pB for display in pymol
@@ -2946,100 +9098,564 @@ void two_helix_contact_vectors(int helix_A, int helix_B, struct HELIX *helix, st
        // using the values of the inital and final points Ai,Af & Bi,Bf along the helix axes.
        
       // function returns pA, pB which are points of closest approach within the segment
-       rdist=segment_segment_closest_points3d(&pA, &pB, &Alimits, &Blimits);
+       rdist=segment_segment_closest_points3d(&pA, &pB, Alimits, Blimits);
        
 #ifdef DEBUG
        printf("coming out of seg_seg routine \n");
        printf("rdist is %f",rdist);
-       printf(" compare with previously calculated distance %f\n",helix_pair[i][j].distance);
+       printf(" compare with previously calculated distance %f\n",helix_pair->distance);
        printf("segment point A %f, %f, %f\n",pA.px, pA.py, pA.pz);
        printf("segment point B %f, %f, %f\n",pB.px, pB.py, pB.pz);
 #endif
        
-       sprintf(cA_label,"%dto%d",i,j);
-       sprintf(cB_label,"%dto%d",j,i);
-	   sprintf(cD_label,"Contact_%dto%d",i,j);
-       fprintf(fpo_pyaxis,"pseudoatom %s, pos=[%f, %f, %f]\n",cA_label,pA.px,pA.py,pA.pz);
-       fprintf(fpo_pyaxis,"pseudoatom %s, pos=[%f, %f, %f]\n",cB_label,pB.px,pB.py,pB.pz);
-       fprintf(fpo_pyaxis,"distance %s, /%s, /%s\n",cD_label, cA_label,cB_label);
+       write_output(entry->fpo_cgo,"CYLINDER, %.3f, %.3f, %.3f, %.3f, %.3f, %.3f, *s,\n",pA.px,pA.py,pA.pz,pB.px,pB.py,pB.pz);
+
+       if(fpo_pyaxis!=NULL)
+       {
+          sprintf(cA_label,"%dto%d",i,j);
+          sprintf(cB_label,"%dto%d",j,i);
+          sprintf(cD_label,"Contact_%dto%d",i,j);
+          write_output(fpo_pyaxis,"pseudoatom %s, pos=[%f, %f, %f]\n",cA_label,pA.px,pA.py,pA.pz);
+          write_output(fpo_pyaxis,"pseudoatom %s, pos=[%f, %f, %f]\n",cB_label,pB.px,pB.py,pB.pz);
+          write_output(fpo_pyaxis,"distance %s, /%s, /%s\n",cD_label, cA_label,cB_label);
+       }
        
        /* smallest distance between the two helix axes i.e. length of line of closest approach */
        // dmf 7.12.17 added this so that helix_packing_pair.txt output is consistent
-       helix_pair[i][j].distance=sqrt(pow(pB.px-pA.px,2.0)+pow(pB.py-pA.py,2.0)+pow(pB.pz-pA.pz,2.0));
+       helix_pair->distance=sqrt(pow(pB.px-pA.px,2.0)+pow(pB.py-pA.py,2.0)+pow(pB.pz-pA.pz,2.0));
        
    }
-   // dmf 7.28.17
-   fclose(fpo_pyaxis); 
+
+   return XHELIX_OK;
 }
 
 /* ------------------------------------------------------------------------- */
 
-/* Free up the memory taken by helix_atom structure */
-void destroy_helix_atom(struct ATOM **helix_atom, int *helices_total)
+/* Function to keep the message of an error of the entry being analysed, returns the error code */
+int entry_error(struct ENTRYSTATE *entry, int status, const char *format, ...)
 {
-   /* Deallocate the memory for the 2d array dynamically
-    *
-    * ---max atoms per helix (1000-2000)-->
-    *        |
-    *  number of helices
-    *        \/
-    */
+   /* Variables */
+
+   va_list args;
 
-   int i;
 
+   va_start(args, format);
+   vsnprintf(entry->message, MESSAGE_LENGTH, format, args);
+   va_end(args);
 
-   for (i=0; i<*helices_total; i++)
+   return status;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to report an allocation that failed in any of the arenas of an entry, as entry_error() does; */
+/* returns XHELIX_OK if none did */
+int arena_error(struct ENTRYSTATE *entry, struct ARENA **arena, int arenas_total)
+{
+   /* Variables */
+
+   int t;
+
+
+   for(t=0;t<arenas_total;t++)
    {
-      free(helix_atom[i]);
+      if(arena[t]->failed) return entry_error(entry, XHELIX_ERROR_STRUCTURE, "** Error allocating %lu bytes of memory!", (unsigned long) arena[t]->failed);
    }
-   free(helix_atom);
+
+   return XHELIX_OK;
 }
 
 /* ------------------------------------------------------------------------- */
 
-/* Free up the memory taken by helix_pair structure */
-void destroy_helix_pair(struct HELIXPAIR **helix_pair, int *helices_total)
+/* Function to open an output file of the entry, once for the whole entry, with a large buffer from the arena */
+/* so that it is written out in few pieces; fp is left NULL, and nothing is written to it, when the output is */
+/* not one of those asked for */
+int open_output(struct ENTRYSTATE *entry, int output, char *filename, struct ARENA *arena, FILE **fp)
 {
-   /* Deallocate the memory for the 2d array dynamically
-    *
-    * ---number of helices--->
-    *        |
-    *  number of helices
-    *        \/
-    */
+   *fp=NULL;
 
-   int i;
+   if(!(entry->outputs & output)) return XHELIX_OK;
+
+   if(entry->compression!=XHELIX_COMPRESS_NONE)
+   {
+      if(open_deflater(entry, filename, fp)) return entry_error(entry, XHELIX_ERROR_OUTPUT, "** Error writing to file '%s'!", filename);
+   }
+   else if((*fp=fopen(filename, "w"))==NULL)
+   {
+      return entry_error(entry, XHELIX_ERROR_OUTPUT, "** Error writing to file '%s'!", filename);
+   }
+
+   setvbuf(*fp, (char *) arena_alloc(arena, OUTPUT_BUFFER), _IOFBF, OUTPUT_BUFFER);
+
+   return arena_error(entry, &arena, 1);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to write to an output file, if it is open */
+void write_output(FILE *fp, const char *format, ...)
+{
+   /* Variables */
+
+   va_list args;
+
+
+   if(fp==NULL) return;
+
+   va_start(args, format);
+   vfprintf(fp, format, args);
+   va_end(args);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to close an output file, if it is open */
+void close_output(FILE *fp)
+{
+   if(fp!=NULL) fclose(fp);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to open a compressed output file with a thread compressing it, fp is the pipe the entry writes */
+/* the output into. Returns 0, or -1 if the file, the pipe or the thread cannot be made */
+int open_deflater(struct ENTRYSTATE *entry, char *filename, FILE **fp)
+{
+   /* Variables */
+
+   struct DEFLATER *deflater;
+   int pipe_end[2];
+   int status=0;
+
+
+   if((deflater=(struct DEFLATER *) calloc(1,sizeof(struct DEFLATER)))==NULL) return -1;
+
+   deflater->compression=entry->compression;
+
+#ifdef HAVE_ZLIB
+   if((deflater->compression==XHELIX_COMPRESS_GZIP) && (deflateInit2(&deflater->gzip, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY)!=Z_OK)) status=-1;
+#endif
+#ifdef HAVE_ZSTD
+   if((deflater->compression==XHELIX_COMPRESS_ZSTD) && ((deflater->zstd=ZSTD_createCCtx())==NULL)) status=-1;
+#endif
+
+   if((status==0) && ((deflater->fp=fopen(filename, "wb"))==NULL)) status=-1;
+
+   if((status==0) && pipe(pipe_end)) status=-1;
+
+   if(status==0)
+   {
+      deflater->source=pipe_end[0];
+
+      if((*fp=fdopen(pipe_end[1], "w"))==NULL)
+      {
+         close(pipe_end[1]);
+         status=-1;
+      }
+      else if(pthread_create(&deflater->thread, NULL, deflate_output, deflater))
+      {
+         fclose(*fp);
+         *fp=NULL;
+         status=-1;
+      }
+
+      if(status) close(pipe_end[0]);
+   }
+
+   if(status)
+   {
+      if(deflater->fp!=NULL)
+      {
+         fclose(deflater->fp);
+         remove(filename);
+      }
+
+      deflater->failed=1;
+      deflate_chunk(deflater, 0, -1);
+      free(deflater);
+
+      return -1;
+   }
+
+   deflater->next=entry->deflater;
+   entry->deflater=deflater;
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function run by the thread compressing an output file, a chunk at a time until the entry closes the pipe; */
+/* after a failure the pipe is still read to its end, so the entry never waits on it */
+void* deflate_output(void *data)
+{
+   /* Variables */
+
+   struct DEFLATER *deflater;
+   ssize_t size;
+
+
+   deflater=(struct DEFLATER *) data;
+
+   for(;;)
+   {
+      size=read(deflater->source, deflater->in, DEFLATE_CHUNK);
+
+      if((size<0) && (errno==EINTR)) continue;
+
+      if(size<=0)
+      {
+         if(size<0) deflater->failed=1;
+         break;
+      }
+
+      if(!deflater->failed && deflate_chunk(deflater, size, 0)) deflater->failed=1;
+   }
+
+   if(!deflater->failed && deflate_chunk(deflater, 0, 1)) deflater->failed=1;
+
+   deflate_chunk(deflater, 0, -1);
+
+   close(deflater->source);
+
+   if(fclose(deflater->fp)) deflater->failed=1;
+
+   return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to compress size bytes of an output and write what comes out to its file, finish set to 1 for */
+/* the end of the output, or to -1 to free the compressor. Returns 0, or -1 if it cannot be compressed or written */
+int deflate_chunk(struct DEFLATER *deflater, size_t size, int finish)
+{
+#if defined(HAVE_ZLIB) || defined(HAVE_ZSTD)
+   /* Variables */
+
+   size_t produced;
+#endif
+#ifdef HAVE_ZLIB
+   int result;
+#endif
+#ifdef HAVE_ZSTD
+   ZSTD_inBuffer in;
+   ZSTD_outBuffer out;
+   size_t left;
+#endif
+
+
+#ifdef HAVE_ZLIB
+   if(deflater->compression==XHELIX_COMPRESS_GZIP)
+   {
+      if(finish<0) return deflateEnd(&deflater->gzip)==Z_OK ? 0 : -1;
+
+      deflater->gzip.next_in=deflater->in;
+      deflater->gzip.avail_in=size;
+
+      /* deflate is called until it has taken all the input and, at the end, given out all it held back */
+
+      do
+      {
+         deflater->gzip.next_out=deflater->out;
+         deflater->gzip.avail_out=DEFLATE_CHUNK;
+
+         result=deflate(&deflater->gzip, finish ? Z_FINISH : Z_NO_FLUSH);
+
+         if(result==Z_STREAM_ERROR) return -1;
+
+         produced=DEFLATE_CHUNK-deflater->gzip.avail_out;
+
+         if((produced>0) && (fwrite(deflater->out, 1, produced, deflater->fp)!=produced)) return -1;
+      }
+      while((deflater->gzip.avail_out==0) || (finish && (result!=Z_STREAM_END)));
+   }
+#endif
+#ifdef HAVE_ZSTD
+   if(deflater->compression==XHELIX_COMPRESS_ZSTD)
+   {
+      if(finish<0)
+      {
+         ZSTD_freeCCtx(deflater->zstd);
+         return 0;
+      }
+
+      in.src=deflater->in;
+      in.size=size;
+      in.pos=0;
+
+      do
+      {
+         out.dst=deflater->out;
+         out.size=DEFLATE_CHUNK;
+         out.pos=0;
+
+         left=ZSTD_compressStream2(deflater->zstd, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+
+         if(ZSTD_isError(left)) return -1;
+
+         produced=out.pos;
+
+         if((produced>0) && (fwrite(deflater->out, 1, produced, deflater->fp)!=produced)) return -1;
+      }
+      while((in.pos<in.size) || (finish && (left>0)));
+   }
+#endif
+#if !defined(HAVE_ZLIB) && !defined(HAVE_ZSTD)
+   /* with neither built in no output is ever compressed, see xhelix_set_compression() */
+
+   (void) deflater;
+   (void) size;
+   (void) finish;
+#endif
+
+   return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to wait for the threads compressing the output files of an entry, whose pipes must have been */
+/* closed, and to pass on the status, or an error if a file could not be written whole */
+int close_deflaters(struct ENTRYSTATE *entry, int status)
+{
+   /* Variables */
+
+   struct DEFLATER *deflater;
+   int failed=0;
+
+
+   while((deflater=entry->deflater)!=NULL)
+   {
+      pthread_join(deflater->thread, NULL);
+
+      failed|=deflater->failed;
+
+      entry->deflater=deflater->next;
+      free(deflater);
+   }
+
+   if(failed && (status==XHELIX_OK)) return entry_error(entry, XHELIX_ERROR_OUTPUT, "** Error compressing the output files!");
+
+   return status;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to generate an empty arena, its first block is taken when it is first used */
+struct ARENA* make_arena(void)
+{
+   return (struct ARENA *) calloc(1,sizeof(struct ARENA));
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to take a new block of at least size bytes for the arena, backed by huge pages if asked for; */
+/* NULL if there is no memory for it */
+struct ARENABLOCK* arena_block(size_t size)
+{
+   /* Variables */
+
+   struct ARENABLOCK *block;
+   size_t bytes;
+
+
+   if(size<ARENA_BLOCK) size=ARENA_BLOCK;
+
+   bytes=size+sizeof(struct ARENABLOCK);
+
+#ifdef HUGE_PAGES
+   bytes=(bytes+HUGE_PAGE_SIZE-1)/HUGE_PAGE_SIZE*HUGE_PAGE_SIZE;
+
+   if((block=(struct ARENABLOCK *) mmap(NULL, bytes, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0))==MAP_FAILED) block=NULL;
+   else madvise(block, bytes, MADV_HUGEPAGE);
+#else
+   block=(struct ARENABLOCK *) malloc(bytes);
+#endif
+
+   if(block==NULL) return NULL;
+
+   block->next=NULL;
+   block->size=bytes-sizeof(struct ARENABLOCK);
+   block->used=0;
+
+   return block;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to give a block back */
+void arena_unblock(struct ARENABLOCK *block)
+{
+#ifdef HUGE_PAGES
+   munmap(block, block->size+sizeof(struct ARENABLOCK));
+#else
+   free(block);
+#endif
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to hand out size bytes from the arena, filled with zeros (as calloc). NULL if there is no memory */
+/* for them, which is kept in the arena until it is reset so that arena_error() can report it */
+void* arena_alloc(struct ARENA *arena, size_t size)
+{
+   /* Variables */
+
+   struct ARENABLOCK *block;
+   void *p;
+
+
+   size=(size+ARENA_ALIGN-1)/ARENA_ALIGN*ARENA_ALIGN;
+
+   if((arena->block==NULL) || (arena->block->used+size>arena->block->size))
+   {
+      if((block=arena_block(size))==NULL)
+      {
+         if(!arena->failed) arena->failed=(size>ARENA_BLOCK) ? size : ARENA_BLOCK;
+
+         return NULL;
+      }
+
+      block->next=arena->block;
+      arena->block=block;
+   }
+
+   p=(char *) (arena->block+1)+arena->block->used;
+
+   arena->block->used+=size;
+   arena->used+=size;
+   arena->last=p;
+
+   memset(p, 0, size);
+
+   return p;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to grow an arena allocation from old_size to size bytes (as realloc), NULL if there is no memory */
+/* the most recent allocation grows in place while its block has room, anything else is copied */
+void* arena_realloc(struct ARENA *arena, void *old, size_t old_size, size_t size)
+{
+   /* Variables */
+
+   void *p;
+   size_t extra;
+
+
+   old_size=(old_size+ARENA_ALIGN-1)/ARENA_ALIGN*ARENA_ALIGN;
+   size=(size+ARENA_ALIGN-1)/ARENA_ALIGN*ARENA_ALIGN;
+
+   if((old!=NULL) && (old==arena->last) && (size>old_size) && (arena->block->used+size-old_size<=arena->block->size))
+   {
+      extra=size-old_size;
+
+      arena->block->used+=extra;
+      arena->used+=extra;
+
+      return old;
+   }
+
+   if((p=arena_alloc(arena, size))==NULL) return NULL;
+
+   if(old!=NULL) memcpy(p, old, old_size<size ? old_size : size);
+
+   return p;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Function to take back everything handed out by the arena in one step */
+/* if the last protein needed more than one block, they are swapped for one block big enough for it all */
+void arena_reset(struct ARENA *arena)
+{
+   /* Variables */
+
+   struct ARENABLOCK *block;
+   struct ARENABLOCK *next;
+
+
+   if((arena->block!=NULL) && (arena->block->next!=NULL))
+   {
+      for(block=arena->block;block!=NULL;block=next)
+      {
+         next=block->next;
+         arena_unblock(block);
+      }
+
+      arena->block=arena_block(arena->used);
+   }
+
+   if(arena->block!=NULL) arena->block->used=0;
+
+   arena->used=0;
+   arena->last=NULL;
+   arena->failed=0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Free up the memory taken by the arena */
+void destroy_arena(struct ARENA *arena)
+{
+   /* Variables */
+
+   struct ARENABLOCK *block;
+   struct ARENABLOCK *next;
 
 
-   for (i=0; i<*helices_total; i++)
+   for(block=arena->block;block!=NULL;block=next)
    {
-      free(helix_pair[i]);
+      next=block->next;
+      arena_unblock(block);
    }
-   free(helix_pair);
+
+   free(arena);
 }
 
+/* ------------------------------------------------------------------------- */
+
 // dmf 7.29.17
-void create_filenames(char *pdb_id) {
+void create_filenames(char *pdb_id, struct ENTRYSTATE *entry) {
+    const char *suffix=(entry->compression==XHELIX_COMPRESS_ZSTD) ? ".zst" : ".gz";
+
     /* create the output filenames with pdb_identifier appended */
     
-    /* variables declared globally */
-    strcpy(output_shape, pdb_id);
-    strcpy(output_packing, pdb_id);
-    strcpy(output_helices, pdb_id);
-    strcpy(pymol_axis, pdb_id);
-    strcpy(output_axis, pdb_id);
-    strcpy(output_contact, pdb_id);
-    strcpy(output_geom, pdb_id);
+    /* variables held in the entry state */
+    strcpy(entry->output_shape, pdb_id);
+    strcpy(entry->output_packing, pdb_id);
+    strcpy(entry->output_helices, pdb_id);
+    strcpy(entry->pymol_axis, pdb_id);
+    strcpy(entry->pymol_cgo, pdb_id);
+    strcpy(entry->output_axis, pdb_id);
+    strcpy(entry->output_contact, pdb_id);
+    strcpy(entry->output_geom, pdb_id);
     /* */
-    strcat(output_shape, "_helix_shape.txt");
-    strcat(output_packing, "_helix_packing_pair.txt");
-    strcat(output_helices, "_helices.txt");
-    strcat(pymol_axis, "_axis.py");
-    strcat(output_axis, "_axis.txt");
-    strcat(output_contact, "_contact.txt");
-    strcat(output_geom, "_geom.txt");
+    strcat(entry->output_shape, "_helix_shape.txt");
+    strcat(entry->output_packing, "_helix_packing_pair.txt");
+    strcat(entry->output_helices, "_helices.txt");
+    strcat(entry->pymol_axis, "_axis.py");
+    strcat(entry->pymol_cgo, "_axis_cgo.py");
+    strcat(entry->output_axis, "_axis.txt");
+    strcat(entry->output_contact, "_contact.txt");
+    strcat(entry->output_geom, "_geom.txt");
+
+    /* compressed files are named as gzip and zstd name them */
+
+    if(entry->compression!=XHELIX_COMPRESS_NONE)
+    {
+        strcat(entry->output_shape, suffix);
+        strcat(entry->output_packing, suffix);
+        strcat(entry->output_helices, suffix);
+        strcat(entry->pymol_axis, suffix);
+        strcat(entry->pymol_cgo, suffix);
+        strcat(entry->output_axis, suffix);
+        strcat(entry->output_contact, suffix);
+        strcat(entry->output_geom, suffix);
+    }
     
-    printf("Helix Output Files: %s, %s, %s, %s\n", output_helices, output_axis, output_geom, output_contact);
-    printf("SSE Appended Output Files: %s, %s\n",output_packing,output_shape);
+    if(entry->verbose)
+    {
+        printf("Helix Output Files: %s, %s, %s, %s\nSSE Appended Output Files: %s, %s\n", entry->output_helices, entry->output_axis, entry->output_geom, entry->output_contact, entry->output_packing, entry->output_shape);
+    }
 
 }
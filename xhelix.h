@@ -0,0 +1,120 @@
+/* libxhelix - helix packing analysis of one protein at a time, as done by x-helix for each entry of its list */
+/* All state lives in an analysis context, so entries can be analysed side by side with a context per thread */
+
+#ifndef XHELIX_H
+#define XHELIX_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#if defined(__GNUC__)
+#define XHELIX_API __attribute__((visibility("default")))
+#else
+#define XHELIX_API
+#endif
+
+/* return codes, xhelix_error() tells what went wrong */
+#define XHELIX_OK 0
+#define XHELIX_ERROR_INPUT 1          /* a DSSP or PDB input could not be read */
+#define XHELIX_ERROR_OUTPUT 2         /* an output file could not be written */
+#define XHELIX_ERROR_STRUCTURE 3      /* the helices of the entry could not be analysed, or there was no memory for them */
+
+/* output files written for an entry, named <pdb id>_<name> in the current directory */
+#define XHELIX_OUTPUT_NONE 0
+#define XHELIX_OUTPUT_HELICES 1       /* helices.txt */
+#define XHELIX_OUTPUT_PACKING 2       /* helix_packing_pair.txt */
+#define XHELIX_OUTPUT_SHAPE 4         /* helix_shape.txt */
+#define XHELIX_OUTPUT_AXIS 8          /* axis.txt */
+#define XHELIX_OUTPUT_GEOM 16         /* geom.txt */
+#define XHELIX_OUTPUT_CONTACT 32      /* contact.txt */
+#define XHELIX_OUTPUT_PYMOL 64        /* axis.py, a named PyMOL object for every axis point and contact */
+#define XHELIX_OUTPUT_CGO 128         /* axis_cgo.py, the same axes and contacts as two PyMOL CGO objects, quick to load */
+#define XHELIX_OUTPUT_ALL 255
+
+/* compression of the output files, which are then named <pdb id>_<name>.gz or .zst */
+#define XHELIX_COMPRESS_NONE 0
+#define XHELIX_COMPRESS_GZIP 1        /* built with -DHAVE_ZLIB */
+#define XHELIX_COMPRESS_ZSTD 2        /* built with -DHAVE_ZSTD */
+
+/* progress reports on stdout, each a whole line but for the marks of the helices scanned */
+#define XHELIX_VERBOSE_PROGRESS 1     /* a mark for each helix as its neighbours are scanned, then "Done" */
+#define XHELIX_VERBOSE_LINES 2        /* "Analysis of <pdb id> done" alone, for contexts reporting side by side */
+
+struct XHELIX;
+
+/* A helix of the last entry analysed. The arrays belong to the context and last until its next analysis */
+struct XHELIX_HELIX
+{
+   char pdb[5];
+   char chain;
+   int helix_no;                      /* helix number from the DSSP file */
+   int residues_total;
+   const char *residues;              /* one letter sequence */
+   const float *residue_numbers;      /* residue numbers, insertion codes as hundredths */
+   int atoms_total;
+   char geometry;                     /* S for short, U for unknown, K for kinked, C for curved, L for linear */
+   double max_bending_angle;
+   int axes_total;                    /* residues_total-3 unit local axes, none below 4 residues */
+   const double (*axis)[3];
+   const double (*origin)[3];         /* axes_total+1 local helix origins */
+   int bending_angles_total;          /* angles between axes j and j+3, for j=0,3,6... */
+   const double *bending_angle;
+};
+
+/* A pair of neighbouring helices of the last entry analysed, helices are numbered as in the helix results */
+struct XHELIX_PAIR
+{
+   int helix_one;
+   int helix_two;
+   int packed;                        /* 1 for packed helices */
+   int h1_residues;                   /* residues of each helix in contact */
+   int h2_residues;
+   int h1_start;                      /* contact area of each helix, as residue numbers within the helix */
+   int h1_end;
+   int h2_start;
+   int h2_end;
+   int covalent;                      /* interhelical contacts by type */
+   int electrostatic;
+   int hbond;
+   int vdw;
+   double angle1;                     /* interhelical angle from all axes, -1 unless packed and both helices have axes */
+   double angle2;                     /* interhelical angle from the axes of the contact area */
+   double distance;                   /* interaxial distance */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* a new context writes no files, reports nothing and uses one thread */
+XHELIX_API struct XHELIX* xhelix_create(void);
+XHELIX_API void xhelix_destroy(struct XHELIX*);
+XHELIX_API void xhelix_set_threads(struct XHELIX*, int threads_total);
+XHELIX_API void xhelix_set_outputs(struct XHELIX*, int outputs);
+XHELIX_API int xhelix_set_compression(struct XHELIX*, int compression);
+XHELIX_API void xhelix_set_verbose(struct XHELIX*, int verbose);
+
+/* in the C-alpha mode the helix C-alphas are taken from the DSSP input and the PDB input, which may be NULL, */
+/* is not read: helix shapes, axes, neighbours and their global angles come out, but no contacts or packed pairs */
+XHELIX_API void xhelix_set_ca_only(struct XHELIX*, int ca_only);
+
+/* analysis of one entry from its DSSP and PDB files, open streams, or texts held in memory; the PDB input may */
+/* also be mmCIF or binary, and either may be gzip data. With a NULL DSSP input the helices are assigned from */
+/* the structure, as DSSP would assign them */
+XHELIX_API int xhelix_analyse_files(struct XHELIX*, const char *pdb_id, const char *dssp_file, const char *pdb_file);
+XHELIX_API int xhelix_analyse_streams(struct XHELIX*, const char *pdb_id, FILE *dssp, FILE *pdb);
+XHELIX_API int xhelix_analyse_text(struct XHELIX*, const char *pdb_id, const char *dssp, size_t dssp_size, const char *pdb, size_t pdb_size);
+
+/* a structure read from a PDB or mmCIF stream written in the binary format, which is read in place of either and fastest */
+XHELIX_API int xhelix_write_binary(struct XHELIX*, const char *pdb_id, FILE *structure, FILE *binary);
+
+/* results of the last entry analysed, the number of helices or pairs is returned */
+XHELIX_API int xhelix_helices(struct XHELIX*, const struct XHELIX_HELIX **helix);
+XHELIX_API int xhelix_pairs(struct XHELIX*, const struct XHELIX_PAIR **pair);
+XHELIX_API const char* xhelix_error(struct XHELIX*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif